@@ -8,16 +8,39 @@
 
 using namespace std;
 
-// Constructor: Initializes an Account with account number, description, and initial balance
-Account::Account(int accountNumber, const string &description, double initialBalance)
-        : accountNumber(accountNumber), description(description), balance(initialBalance), parent(nullptr), nextTransactionID(1) {
+// Constructor: Initializes an Account with account number, description, initial balance, and storage
+Account::Account(int accountNumber, string_view description, double initialBalance, PostingStore *postingStore,
+                 StringPool *stringPool)
+        : accountNumber(accountNumber), balance(initialBalance), openingBalance(initialBalance), subtreeHash(0),
+          store(postingStore), slot(-1), parent(nullptr), nextTransactionID(1) {
     validateAccountNumber(accountNumber); // Ensure the account number is valid
+
+    // Descriptions are stored once per distinct string
+    this->description = (stringPool ? *stringPool : StringPool::shared()).intern(description);
+    subtreeHash = LedgerHash::accountTerm(accountNumber, this->description, initialBalance);
+
+    // Standalone accounts keep their transactions in a private store
+    if (!store) {
+        ownedStore.reset(new PostingStore());
+        store = ownedStore.get();
+    }
+    slot = store->allocateSlot(accountNumber);
+}
+
+// Constructor: Initializes an Account whose description is static data (not interned)
+Account::Account(int accountNumber, StaticDescription description, double initialBalance, PostingStore *postingStore)
+        : accountNumber(accountNumber), description(description.text), balance(initialBalance),
+          openingBalance(initialBalance),
+          subtreeHash(LedgerHash::accountTerm(accountNumber, description.text, initialBalance)),
+          store(postingStore), slot(-1), parent(nullptr), nextTransactionID(1) {
+    validateAccountNumber(accountNumber);
+    slot = store->allocateSlot(accountNumber);
 }
 
-// Destructor: Releases memory for all transactions associated with this account
+// Destructor: Releases the account's transactions from the posting store
 Account::~Account() {
-    for (Transaction *transaction : transactions) {
-        delete transaction;
+    if (!ownedStore && slot >= 0) {
+        store->releaseSlot(slot);
     }
 }
 
@@ -34,7 +57,7 @@ int Account::getAccountNumber() const {
 }
 
 // Returns the account description
-const string &Account::getDescription() const {
+string_view Account::getDescription() const {
     return description;
 }
 
@@ -43,14 +66,24 @@ double Account::getBalance() const {
     return balance;
 }
 
+// Returns the balance the account was created with
+double Account::getOpeningBalance() const {
+    return openingBalance;
+}
+
 // Returns the parent account, if any
 Account *Account::getParent() const {
     return parent;
 }
 
-// Returns a reference to the list of transactions associated with this account
-const vector<Transaction *> &Account::getTransactions() const {
-    return transactions;
+// Returns a view over the transactions associated with this account
+PostingView Account::getTransactions() const {
+    return store->view(slot);
+}
+
+// Returns this account's slot in the posting store
+int Account::getSlot() const {
+    return slot;
 }
 
 // Sets the parent account for this account
@@ -58,83 +91,129 @@ void Account::setParent(Account *parentAccount) {
     parent = parentAccount;
 }
 
+// Points the description at an equal copy of its text
+void Account::relocateDescription(string_view text) {
+    if (text != description) {
+        throw invalid_argument("A relocated description must keep its text.");
+    }
+    description = text;
+}
+
 // Updates the balance by adding the specified amount
 void Account::updateBalance(double amount) {
     balance += amount;
 }
 
+// Sets the balance to a recomputed value
+void Account::setBalance(double value) {
+    balance = value;
+}
+
+// Returns the hash of this account and its descendants
+uint64_t Account::getSubtreeHash() const {
+    return subtreeHash;
+}
+
+// Adds a term to the subtree hash (wrapping modulo 2^64)
+void Account::adjustSubtreeHash(uint64_t term) {
+    subtreeHash += term;
+}
+
+// Sums the hash terms of the postings from a position on
+uint64_t Account::postingsHash(size_t from) const {
+    PostingView postings = store->view(slot);
+    uint64_t hash = 0;
+    for (size_t i = from; i < postings.size(); ++i) {
+        PostingRef posting = postings[i];
+        hash += LedgerHash::postingTerm(accountNumber, posting.getAmount(), posting.getDebitOrCredit(),
+                                        posting.getDate());
+    }
+    return hash;
+}
+
 // Adds a transaction to the account and updates balances for this account and its parent accounts
-void Account::addTransaction(double amount, char debitOrCredit) {
+void Account::addTransaction(double amount, char debitOrCredit, int date) {
     // Validate the transaction type
     if (debitOrCredit != 'D' && debitOrCredit != 'C') {
         throw invalid_argument("Invalid transaction type. Use 'D' for Debit or 'C' for Credit.");
     }
 
-    // Create a new transaction with this account's next transaction ID
-    Transaction *transaction = new Transaction(amount, debitOrCredit );
-    transaction->setTransactionID(nextTransactionID++); // Use and increment the account's transaction ID
-
-    // Validate the transaction
-    if (!transaction->isValid(this)) {
-        delete transaction; // Clean up if invalid
+    // Validate the transaction before anything is stored
+    Transaction transaction(amount, debitOrCredit, date);
+    if (!transaction.isValid(this)) {
         throw invalid_argument("Transaction is invalid: Insufficient balance for credit transaction.");
     }
 
-    // Add the transaction to the list
-    transactions.push_back(transaction);
+    // Store the transaction with this account's next transaction ID
+    uint64_t term = appendTransaction(amount, debitOrCredit, date);
 
     // Calculate the adjustment based on the transaction type
     double adjustment = (debitOrCredit == 'D') ? amount : -amount;
 
-    // Propagate the balance adjustment to this account and its parent accounts
+    // Propagate the balance adjustment and hash term to this account and its parent accounts
     Account *current = this;
     while (current) {
         current->updateBalance(adjustment);
+        current->adjustSubtreeHash(term);
         current = current->getParent();
     }
 }
 
+// Stores a transaction without validation or balance changes; returns its hash term
+uint64_t Account::appendTransaction(double amount, char debitOrCredit, int date) {
+    store->append(slot, nextTransactionID++, amount, debitOrCredit, date);
+    return LedgerHash::postingTerm(accountNumber, amount, debitOrCredit, date);
+}
+
 // Removes a transaction by its ID and adjusts balances accordingly
 void Account::removeTransaction(int transactionID) {
-    auto it = find_if(transactions.begin(), transactions.end(),
-                      [transactionID](Transaction *t) { return t->getTransactionID() == transactionID; });
+    PostingView postings = store->view(slot);
+    const int *ids = postings.ids();
+    const int *it = find(ids, ids + postings.size(), transactionID);
 
-    if (it != transactions.end()) {
+    if (it != ids + postings.size()) {
         // Reverse the balance adjustment caused by this transaction
-        double adjustment = ((*it)->getDebitOrCredit() == 'D') ? -(*it)->getAmount() : (*it)->getAmount();
-        updateBalance(adjustment);
-
-        // Propagate the reverse adjustment to parent accounts
-        Account *current = parent;
-        while (current) {
-            current->updateBalance(adjustment);
-            current = current->getParent();
-        }
+        size_t index = static_cast<size_t>(it - ids);
+        PostingRef posting = postings[index];
+        double adjustment = (posting.getDebitOrCredit() == 'D') ? -posting.getAmount() : posting.getAmount();
+        uint64_t term = 0 - LedgerHash::postingTerm(accountNumber, posting.getAmount(), posting.getDebitOrCredit(),
+                                                    posting.getDate());
 
-        // Delete the transaction and remove it from the list
-        delete *it;
-        transactions.erase(it);
+        // Remove the transaction from the store
+        store->erase(slot, index);
 
         // Reassign transaction IDs to ensure they are sequential
-        int newID = 1;
-        for (Transaction *transaction : transactions) {
-            transaction->setTransactionID(newID++);
-        }
+        store->renumber(slot);
 
         // Update the nextTransactionID counter
-        nextTransactionID = newID;
+        nextTransactionID = static_cast<int>(store->size(slot)) + 1;
+
+        // Propagate the reverse adjustment and hash term to this account and its parent accounts
+        Account *current = this;
+        while (current) {
+            current->updateBalance(adjustment);
+            current->adjustSubtreeHash(term);
+            current = current->getParent();
+        }
     } else {
         throw invalid_argument("Transaction not found.");
     }
 }
 
+// Reserves room for a number of transactions in the account's slot
+void Account::reserveTransactions(size_t count) {
+    store->reserve(slot, count);
+}
+
 // Overloaded input operator: Reads account details from the input stream
 istream &operator>>(istream &in, Account &account) {
     cout << "Enter Account Number: ";
     in >> account.accountNumber;
     cout << "Enter Description: ";
     in.ignore(); // Ignore any trailing newline
-    getline(in, account.description);
+    string description;
+    getline(in, description);
+    account.description = StringPool::shared().intern(description);
     cout << "Enter Initial Balance: ";
     in >> account.balance;
     return in;
@@ -146,7 +225,7 @@ ostream &operator<<(ostream &out, const Account &account) {
     out << account.accountNumber << " ";
 
     // Ensure the description is padded or truncated to a fixed width
-    string description = account.description.substr(0, 80); // Truncate if too long
+    string description(account.description.substr(0, 80)); // Truncate if too long
     if (description.length() < 80) {  // Pad with spaces if too short
         description.append(80 - description.length(), ' ');
     }
@@ -156,8 +235,8 @@ ostream &operator<<(ostream &out, const Account &account) {
     out << " " << fixed << setprecision(2) << account.balance << "\n";
 
     // Output the transactions
-    for (const Transaction *transaction : account.transactions) {
-        out<< *transaction << "\n"; // Assuming Transaction has operator<< defined
+    for (auto transaction : account.getTransactions()) {
+        out << transaction->toTransaction() << "\n";
     }
     return out;
 }
@@ -165,12 +244,20 @@ ostream &operator<<(ostream &out, const Account &account) {
 // Copy constructor: Creates a deep copy of the given Account object
 Account::Account(const Account &other)
         : accountNumber(other.accountNumber),
-          description(other.description),
+          description(StringPool::shared().intern(other.description)), // The source pool may not outlive the copy
           balance(other.balance),
+          openingBalance(other.openingBalance),
+          subtreeHash(other.subtreeHash),
+          store(nullptr),
+          ownedStore(new PostingStore()),
+          slot(-1),
           parent(other.parent),
           nextTransactionID(other.nextTransactionID) {
-    for (const auto &t : other.transactions) {
-        transactions.push_back(new Transaction(*t)); // Deep copy of transactions
+    // Deep copy of transactions into a private store
+    store = ownedStore.get();
+    slot = store->allocateSlot(accountNumber);
+    for (auto t : other.getTransactions()) {
+        store->append(slot, t->getTransactionID(), t->getAmount(), t->getDebitOrCredit(), t->getDate());
     }
 }
 
@@ -178,23 +265,64 @@ Account::Account(const Account &other)
 Account &Account::operator=(const Account &other) {
     if (this != &other) {
         accountNumber = other.accountNumber;
-        description = other.description;
+        description = StringPool::shared().intern(other.description);
         balance = other.balance;
+        openingBalance = other.openingBalance;
+        subtreeHash = other.subtreeHash;
         parent = other.parent;
         nextTransactionID = other.nextTransactionID;
 
-        // Clear existing transactions
-        for (auto t : transactions) {
-            delete t;
+        // Clear existing transactions by starting over in a fresh slot (a private store if moved from)
+        if (slot >= 0) {
+            store->releaseSlot(slot);
+        } else {
+            ownedStore.reset(new PostingStore());
+            store = ownedStore.get();
         }
-        transactions.clear();
+        slot = store->allocateSlot(accountNumber);
 
         // Deep copy transactions from the other account
-        for (const auto &t : other.transactions) {
-            transactions.push_back(new Transaction(*t));
+        for (auto t : other.getTransactions()) {
+            store->append(slot, t->getTransactionID(), t->getAmount(), t->getDebitOrCredit(), t->getDate());
         }
     }
     return *this;
 }
 
 
+
+// Move constructor: Takes over the other account's slot without copying transactions
+Account::Account(Account &&other) noexcept
+        : accountNumber(other.accountNumber),
+          description(other.description),
+          balance(other.balance),
+          openingBalance(other.openingBalance),
+          subtreeHash(other.subtreeHash),
+          store(other.store),
+          ownedStore(move(other.ownedStore)),
+          slot(other.slot),
+          parent(other.parent),
+          nextTransactionID(other.nextTransactionID) {
+    other.slot = -1;
+}
+
+// Move assignment operator: Releases this account's slot and takes over the other's
+Account &Account::operator=(Account &&other) noexcept {
+    if (this != &other) {
+        if (!ownedStore && slot >= 0) {
+            store->releaseSlot(slot);
+        }
+        accountNumber = other.accountNumber;
+        description = other.description;
+        balance = other.balance;
+        openingBalance = other.openingBalance;
+        subtreeHash = other.subtreeHash;
+        store = other.store;
+        ownedStore = move(other.ownedStore);
+        slot = other.slot;
+        parent = other.parent;
+        nextTransactionID = other.nextTransactionID;
+        other.slot = -1;
+    }
+    return *this;
+}
@@ -4,24 +4,40 @@
 /**-- Account.h --------------------------------------------------------------
   This header file defines an Account class for representing financial
   accounts, including support for transactions and hierarchical parent-child
-  relationships between accounts.
+  relationships between accounts. Transactions are stored column-wise in a
+  PostingStore slot: the ledger-wide store of the ForestTree when one is
+  given, or a private store for standalone accounts. Descriptions are
+  interned in a StringPool and exposed as string_view.
 
   Basic operations:
     Constructor:         Constructs an Account with a unique account number,
-                         description, and optional initial balance.
+                         description (interned, or static data), and optional
+                         initial balance.
     Copy Constructor:    Creates a deep copy of an existing Account object.
     Assignment Operator: Assigns one Account object to another, performing
                          a deep copy.
+    Move Constructor / Move Assignment: Transfer an account's slot and
+                         description without copying its transactions.
     Destructor:          Cleans up memory used by the Account and its transactions.
     Getters:             Provides access to account attributes, such as
                          account number, description, balance, parent account,
-                         and associated transactions.
+                         and a view over the associated transactions.
     Setters:             Allows modification of account relationships (e.g., parent).
+    relocateDescription: Points the description at an equal copy of its text.
     updateBalance:       Updates the account's balance by a specified amount.
+    setBalance:          Sets the balance to a recomputed value (ForestTree only).
+    getSubtreeHash / adjustSubtreeHash / postingsHash:
+                         The incremental subtree hash (LedgerHash.h) and the
+                         hash of the account's own postings.
     addTransaction:      Adds a new transaction to the account and propagates
                          balance adjustments to parent accounts.
+    appendTransaction:   Stores a transaction without validating it or adjusting
+                         any balance or hash (for callers that apply them themselves).
+    removeTransactionsIf: Removes every transaction matching a predicate in one
+                         pass, leaving balances and hashes to the caller.
     removeTransaction:   Removes a transaction from the account by ID and
                          adjusts balances for the account and parent accounts.
+    reserveTransactions: Reserves room for a number of transactions.
     Overloaded Operators: Implements input and output stream operations for Accounts.
     saveToFile:          Saves account details to a file.
 
@@ -30,26 +46,45 @@
 
   Class Invariant:
     1. Each account has a unique account number.
-    2. Transactions are stored as pointers to allow dynamic allocation.
+    2. Transactions are stored in the account's slot of a PostingStore.
     3. The parent pointer is either null or points to a valid Account object.
     4. The balance reflects the sum of the initial balance and all transaction amounts.
     5. The nextTransactionID ensures all transactions for an account have unique IDs.
+    6. `store` is never null; `ownedStore` is set only for standalone accounts.
+    7. `slot` is -1 only in a moved-from account, which owns no postings.
+    8. `subtreeHash` is the sum of the LedgerHash terms of this account (its
+       identity and its postings) and the subtree hashes of the accounts
+       whose parent it is, kept up to date by every change that goes
+       through ForestTree or addTransaction/removeTransaction.
 ----------------------------------------------------------------------------**/
 
 #include <iostream>
 #include <string>
 #include <vector>
+#include <memory>
+#include <string_view>
+#include "LedgerHash.h"
+#include "PostingStore.h"
+#include "StringPool.h"
 
 using namespace std;
 
-class Transaction; // Forward declaration
-
 class Account {
+public:
+    // Description held in static storage (e.g. a ChartTable); used as is, not interned
+    struct StaticDescription {
+        string_view text;
+    };
+
 private:
     int accountNumber;                    // Unique account number
-    string description;                   // Account description
+    string_view description;              // Account description (interned in a StringPool)
     double balance;                       // Current account balance
-    vector<Transaction *> transactions;   // List of transactions for the account
+    double openingBalance;                // Balance the account was created with
+    uint64_t subtreeHash;                 // Hash of this account and its descendants (invariant 8)
+    PostingStore *store;                  // Store holding this account's transactions
+    unique_ptr<PostingStore> ownedStore;  // Private store of a standalone account
+    int slot;                             // This account's slot in the store
     Account *parent;                      // Pointer to the parent account (if any)
     int nextTransactionID;                // Tracks the next transaction ID for this account
 
@@ -62,17 +97,42 @@ private:
     -----------------------------------------------------------------------*/
     void validateAccountNumber(int accountNumber);
 
+    /*------------------------------------------------------------------------
+      Sets the balance to a value. Only ForestTree::recomputeBalances uses
+      it, to store a recomputed balance exactly rather than as a difference.
+
+      Precondition:  value is the balance the postings give the account.
+      Post-condition: getBalance() == value.
+    -----------------------------------------------------------------------*/
+    void setBalance(double value);
+
+    friend class ForestTree;
+
 public:
     /***** Constructor *****/
     /*------------------------------------------------------------------------
       Constructs an Account object with a unique account number, description,
-      and an optional initial balance.
+      an optional initial balance, and optional posting store and string pool.
 
       Precondition:  A unique account number and description are provided.
-                     Initial balance defaults to 0.0 if not specified.
-      Post-condition: An Account object is created with the specified attributes.
+                     Initial balance defaults to 0.0 if not specified. The
+                     store and pool, if given, must outlive the account.
+      Post-condition: An Account object is created with the specified attributes,
+                      an empty slot in the store (or in a private store), and
+                      its description interned in the pool (or the shared pool).
+    -----------------------------------------------------------------------*/
+    Account(int accountNumber, string_view description, double initialBalance = 0.0,
+            PostingStore *postingStore = nullptr, StringPool *stringPool = nullptr);
+
+    /*------------------------------------------------------------------------
+      Constructs an Account whose description lives in static storage: the
+      view is kept as is, with no copy into a string pool.
+
+      Precondition:  description.text outlives the account; postingStore is
+                     not null and outlives the account.
+      Post-condition: An Account object is created with an empty slot in the store.
     -----------------------------------------------------------------------*/
-    Account(int accountNumber, const string &description, double initialBalance = 0.0);
+    Account(int accountNumber, StaticDescription description, double initialBalance, PostingStore *postingStore);
 
     /***** Copy Constructor *****/
     /*------------------------------------------------------------------------
@@ -80,7 +140,7 @@ public:
 
       Precondition:  An Account object is provided.
       Post-condition: A new Account object is created as a copy of the given Account,
-                      with a deep copy of its transactions.
+                      with a deep copy of its transactions in a private store.
     -----------------------------------------------------------------------*/
     Account(const Account &other);
 
@@ -95,6 +155,20 @@ public:
     -----------------------------------------------------------------------*/
     Account &operator=(const Account &other);
 
+    /***** Move Constructor / Move Assignment *****/
+    /*------------------------------------------------------------------------
+      Transfers another Account's attributes, posting slot (or private store)
+      and description view, without copying any transaction. Accounts whose
+      parent pointer refers to the source are not updated.
+
+      Precondition:  An Account object is provided.
+      Post-condition: This account owns the source's transactions; the source
+                      owns no slot and may only be destroyed or assigned to.
+    -----------------------------------------------------------------------*/
+    Account(Account &&other) noexcept;
+
+    Account &operator=(Account &&other) noexcept;
+
     /***** Destructor *****/
     /*------------------------------------------------------------------------
       Cleans up memory used by the Account and its associated transactions.
@@ -113,13 +187,25 @@ public:
     -----------------------------------------------------------------------*/
     int getAccountNumber() const;
 
-    const string &getDescription() const;
+    string_view getDescription() const;
 
     double getBalance() const;
 
+    double getOpeningBalance() const;
+
     Account *getParent() const;
 
-    const vector<Transaction *> &getTransactions() const;
+    /*------------------------------------------------------------------------
+      Returns a lightweight view over this account's transactions. Iterating
+      it yields PostingRef handles that support the Transaction getters
+      through `->`; the raw columns are available for aggregation kernels.
+
+      Precondition:  None.
+      Post-condition: The view is valid until the posting store is modified.
+    -----------------------------------------------------------------------*/
+    PostingView getTransactions() const;
+
+    int getSlot() const;
 
     /***** Setters *****/
     /*------------------------------------------------------------------------
@@ -130,6 +216,15 @@ public:
     -----------------------------------------------------------------------*/
     void setParent(Account *parentAccount);
 
+    /*------------------------------------------------------------------------
+      Points the description at another copy of the same text, e.g. one
+      re-interned in a compacted pool. The subtree hash is unchanged.
+
+      Precondition:  text equals the description and outlives the account.
+      Post-condition: getDescription views text.
+    -----------------------------------------------------------------------*/
+    void relocateDescription(string_view text);
+
     /***** Update Balance *****/
     /*------------------------------------------------------------------------
       Updates the account balance by adding or subtracting a specified amount.
@@ -139,16 +234,46 @@ public:
     -----------------------------------------------------------------------*/
     void updateBalance(double amount);
 
+    /***** Subtree Hash *****/
+    /*------------------------------------------------------------------------
+      getSubtreeHash returns the hash of this account and every account below
+      it (invariant 8); adjustSubtreeHash adds a term (modulo 2^64; subtract
+      by adding its negation), which callers do along the ancestor chain in
+      the walk that updates balances. postingsHash returns the sum of the
+      posting terms from a position on.
+
+      Precondition:  from <= number of transactions.
+      Post-condition: Returns or updates the hash.
+    -----------------------------------------------------------------------*/
+    uint64_t getSubtreeHash() const;
+
+    void adjustSubtreeHash(uint64_t term);
+
+    uint64_t postingsHash(size_t from = 0) const;
+
     /***** Transaction Management *****/
     /*------------------------------------------------------------------------
       Adds a transaction to the account and propagates balance adjustments
       to this account and its parent accounts.
 
       Precondition:  A valid numeric amount and transaction type ('D' or 'C') are provided.
+                     The posting date is 0 (undated) or a valid YYYYMMDD value.
       Post-condition: The transaction is added to the account's transaction list,
-                      and balances are adjusted accordingly.
+                      and balances and subtree hashes are adjusted accordingly.
+    -----------------------------------------------------------------------*/
+    void addTransaction(double amount, char debitOrCredit, int date = 0);
+
+    /*------------------------------------------------------------------------
+      Stores a transaction with the account's next ID, leaving every balance
+      and hash unchanged; the caller validates it and applies the balance
+      adjustment and the returned hash term along the ancestor chain
+      (ForestTree::postEntry merges the adjustments of several legs).
+
+      Precondition:  debitOrCredit is 'D' or 'C' and the date is 0 or valid.
+      Post-condition: The transaction is stored and its LedgerHash term is
+                      returned; nothing is allocated if the slot had room.
     -----------------------------------------------------------------------*/
-    void addTransaction(double amount, char debitOrCredit);
+    uint64_t appendTransaction(double amount, char debitOrCredit, int date);
 
     /*------------------------------------------------------------------------
       Removes a transaction from the account by its ID and adjusts balances
@@ -156,10 +281,38 @@ public:
 
       Precondition:  A valid transaction ID is provided.
       Post-condition: The transaction is removed from the account, and balances
-                      are adjusted accordingly.
+                      and subtree hashes are adjusted accordingly.
     -----------------------------------------------------------------------*/
     void removeTransaction(int transactionID);
 
+    /*------------------------------------------------------------------------
+      Removes every transaction for which remove(PostingRef) returns true in
+      one compaction pass, then renumbers the rest once. Balances and hashes
+      are left unchanged; the caller applies the net adjustments (ForestTree's
+      bulk operations merge them over the ancestors).
+
+      Precondition:  remove does not modify the account.
+      Post-condition: Returns the number removed; remaining IDs are 1..n.
+    -----------------------------------------------------------------------*/
+    template<typename Predicate>
+    size_t removeTransactionsIf(Predicate remove) {
+        size_t removed = store->eraseIf(slot, remove);
+        if (removed > 0) {
+            store->renumber(slot);
+            nextTransactionID = static_cast<int>(store->size(slot)) + 1;
+        }
+        return removed;
+    }
+
+    /*------------------------------------------------------------------------
+      Reserves room for a number of transactions, so that adding up to that
+      many allocates nothing.
+
+      Precondition:  None.
+      Post-condition: The account's slot can hold `count` transactions.
+    -----------------------------------------------------------------------*/
+    void reserveTransactions(size_t count);
+
     /***** Overloaded Input and Output Operators *****/
     /*------------------------------------------------------------------------
       Implements input and output stream operations for Account objects.
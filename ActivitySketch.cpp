@@ -0,0 +1,161 @@
+#include "ActivitySketch.h"
+#include "MemoryUsage.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+// Constructor creating an empty sketch with a number of counters
+ActivitySketch::ActivitySketch(size_t capacity) : capacity(capacity), total(0), takenOver(0) {
+    if (capacity == 0) {
+        throw invalid_argument("An activity sketch needs at least one counter");
+    }
+    counters.reserve(capacity);
+    bucketOf.reserve(capacity);
+    buckets.resize(capacity);
+    freeBuckets.reserve(capacity);
+    rebuildBuckets();
+}
+
+// Counts one posting: the account's counter, a free one, or the smallest one taken over
+void ActivitySketch::record(int accountNumber) {
+    if (accountNumber < 1 || accountNumber > MAX_ACCOUNT_NUMBER) {
+        throw invalid_argument("Account number out of range for the activity sketch");
+    }
+    if (positions.empty()) {
+        positions.assign(MAX_ACCOUNT_NUMBER + 1, -1);
+    }
+    ++total;
+    int found = positions[accountNumber];
+    if (found >= 0) {
+        increment(static_cast<size_t>(found));
+        return;
+    }
+
+    if (counters.size() < capacity) {
+        // Every count is at least takenOver, so the new counter goes last
+        counters.push_back({accountNumber, takenOver, takenOver});
+        size_t position = counters.size() - 1;
+        if (position > 0 && counters[position - 1].count == takenOver) {
+            size_t bucket = bucketOf[position - 1];
+            buckets[bucket].last = position;
+            bucketOf.push_back(bucket);
+        } else {
+            bucketOf.push_back(takeBucket(takenOver, position));
+        }
+    } else {
+        Counter &smallest = counters.back();
+        positions[smallest.accountNumber] = -1;
+        smallest.accountNumber = accountNumber;
+        smallest.error = smallest.count;
+        takenOver = smallest.count;
+    }
+    positions[accountNumber] = static_cast<int>(counters.size() - 1);
+    increment(counters.size() - 1);
+}
+
+// Moves a counter to the front of its run of equal counts and increments it
+void ActivitySketch::increment(size_t position) {
+    size_t bucket = bucketOf[position];
+    uint64_t count = buckets[bucket].count;
+    size_t first = buckets[bucket].first;
+    if (first != position) {
+        swap(counters[first], counters[position]);
+        positions[counters[position].accountNumber] = static_cast<int>(position);
+        positions[counters[first].accountNumber] = static_cast<int>(first);
+    }
+    ++counters[first].count;
+
+    // The counter leaves the front of its run: it joins the run above, or starts one
+    bool alone = buckets[bucket].last == first;
+    if (first > 0 && counters[first - 1].count == count + 1) {
+        size_t above = bucketOf[first - 1];
+        buckets[above].last = first;
+        bucketOf[first] = above;
+        if (alone) {
+            freeBuckets.push_back(bucket);
+        } else {
+            buckets[bucket].first = first + 1;
+        }
+    } else if (alone) {
+        buckets[bucket].count = count + 1;
+    } else {
+        buckets[bucket].first = first + 1;
+        bucketOf[first] = takeBucket(count + 1, first);
+    }
+}
+
+// Takes a bucket from the pool for a run starting at a position
+size_t ActivitySketch::takeBucket(uint64_t count, size_t position) {
+    size_t bucket = freeBuckets.back();
+    freeBuckets.pop_back();
+    buckets[bucket] = {count, position, position};
+    return bucket;
+}
+
+// Returns every bucket to the pool and regroups the counters into runs
+void ActivitySketch::rebuildBuckets() {
+    freeBuckets.clear();
+    for (size_t bucket = capacity; bucket > 0; --bucket) {
+        freeBuckets.push_back(bucket - 1);
+    }
+    bucketOf.clear();
+    for (size_t i = 0; i < counters.size(); ++i) {
+        if (i > 0 && counters[i - 1].count == counters[i].count) {
+            size_t bucket = bucketOf[i - 1];
+            buckets[bucket].last = i;
+            bucketOf.push_back(bucket);
+        } else {
+            bucketOf.push_back(takeBucket(counters[i].count, i));
+        }
+    }
+}
+
+// Drops the counter of a removed account, keeping the others in order
+void ActivitySketch::remove(int accountNumber) {
+    if (positions.empty() || accountNumber < 1 || accountNumber > MAX_ACCOUNT_NUMBER ||
+        positions[accountNumber] < 0) {
+        return;
+    }
+    size_t position = static_cast<size_t>(positions[accountNumber]);
+    positions[accountNumber] = -1;
+    counters.erase(counters.begin() + static_cast<ptrdiff_t>(position));
+    for (size_t i = position; i < counters.size(); ++i) {
+        positions[counters[i].accountNumber] = static_cast<int>(i);
+    }
+    rebuildBuckets();
+}
+
+// Returns up to k counters, highest count first
+vector<ActivitySketch::Counter> ActivitySketch::top(size_t k) const {
+    return vector<Counter>(counters.begin(), counters.begin() + static_cast<ptrdiff_t>(min(k, counters.size())));
+}
+
+// Returns the number of postings counted
+uint64_t ActivitySketch::getTotal() const {
+    return total;
+}
+
+// Returns the number of counters
+size_t ActivitySketch::getCapacity() const {
+    return capacity;
+}
+
+// Drops every counter, keeping the allocated lookup and pool
+void ActivitySketch::clear() {
+    for (const Counter &counter: counters) {
+        positions[counter.accountNumber] = -1;
+    }
+    counters.clear();
+    rebuildBuckets();
+    total = 0;
+    takenOver = 0;
+}
+
+// Returns the bytes of the counters, the bucket pool and the account lookup
+size_t ActivitySketch::memoryBytes() const {
+    return MemoryUsage::vectorBytes(counters) + MemoryUsage::vectorBytes(bucketOf) +
+           MemoryUsage::vectorBytes(buckets) + MemoryUsage::vectorBytes(freeBuckets) +
+           MemoryUsage::vectorBytes(positions);
+}
@@ -0,0 +1,138 @@
+#ifndef ACTIVITYSKETCH_H
+#define ACTIVITYSKETCH_H
+
+/**-- ActivitySketch.h ------------------------------------------------------
+  This header file defines the ActivitySketch class, a Space-Saving sketch
+  of posting activity by account: it tracks the accounts posted to most
+  often in a fixed number of counters, at constant cost per posting,
+  without keeping a count for every account.
+
+  An untracked account takes over the counter with the smallest count once
+  every counter is in use, inheriting that count as its error. A counter's
+  count therefore overestimates the account's postings by at most its
+  error, and every account with more than total / capacity postings holds
+  a counter. Removing an account frees its counter; an account taking a
+  free counter later inherits the largest count ever taken over, so the
+  bound still holds.
+
+  Counters are kept in descending order of count, grouped into runs of
+  equal counts (buckets); a posting swaps its counter with the first one of
+  its run and increments it, which keeps the order (the Stream-Summary
+  structure of Metwally et al., laid out in an array). The account lookup
+  is a dense array indexed by account number and the buckets come from a
+  pool sized to the counters, so counting a posting never allocates.
+
+  Basic operations:
+    Constructor:  Constructs an empty sketch with a number of counters.
+    record:       Counts one posting to an account.
+    remove:       Drops the counter of a removed account.
+    top:          Returns the counters with the highest counts.
+    getTotal:     Number of postings counted.
+    getCapacity:  Number of counters.
+    clear:        Drops every counter.
+    memoryBytes:  Returns the memory held by the sketch.
+
+  Helper functions:
+    increment:    Increments the counter at a position, keeping the order.
+    takeBucket:   Takes a bucket from the pool.
+    rebuildBuckets: Regroups every counter into buckets after a removal.
+
+  Class Invariant:
+    1. counters is sorted by descending count and holds at most capacity entries.
+    2. positions holds the position of every tracked account and -1 for the others.
+    3. bucketOf[i] is the bucket whose run covers position i; a bucket in use
+       spans every position holding its count, and freeBuckets lists the others.
+    4. Every count is at least takenOver, and the counts sum to at most total.
+--------------------------------------------------------------------------**/
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+class ActivitySketch {
+public:
+    struct Counter {
+        int accountNumber;
+        uint64_t count;       // Postings counted, at most `error` more than the account's
+        uint64_t error;       // Count inherited from the account this counter replaced
+    };
+
+    static constexpr int MAX_ACCOUNT_NUMBER = 99999;   // Highest account number tracked
+
+private:
+    struct Bucket {
+        uint64_t count;       // Count shared by the run
+        size_t first;         // First position of the run
+        size_t last;          // Last position of the run
+    };
+
+    size_t capacity;                  // Number of counters
+    vector<Counter> counters;         // Descending by count
+    vector<size_t> bucketOf;          // Bucket of each counter, by position
+    vector<Bucket> buckets;           // Pool of capacity buckets
+    vector<size_t> freeBuckets;       // Buckets of the pool not in use
+    vector<int> positions;            // Counter position per account number (-1 if untracked)
+    uint64_t total;                   // Postings counted
+    uint64_t takenOver;               // Largest count an untracked account took over
+
+    void increment(size_t position);
+
+    size_t takeBucket(uint64_t count, size_t position);
+
+    void rebuildBuckets();
+
+public:
+    /***** Constructor *****/
+    /*------------------------------------------------------------------------
+      Constructs an empty sketch. The account lookup is allocated on the
+      first posting.
+
+      Precondition:  capacity > 0.
+      Post-condition: No posting is counted; throws invalid_argument for 0.
+    -----------------------------------------------------------------------*/
+    explicit ActivitySketch(size_t capacity = 128);
+
+    /***** Record *****/
+    /*------------------------------------------------------------------------
+      Counts one posting to an account.
+
+      Precondition:  1 <= accountNumber <= MAX_ACCOUNT_NUMBER.
+      Post-condition: The account holds a counter; constant time, and no
+                      allocation after the first posting. Throws
+                      invalid_argument for an account number out of range.
+    -----------------------------------------------------------------------*/
+    void record(int accountNumber);
+
+    /***** Remove *****/
+    /*------------------------------------------------------------------------
+      Drops the counter of an account that no longer exists. Its postings
+      stay in the total.
+
+      Precondition:  None.
+      Post-condition: top no longer lists the account; linear in the capacity.
+    -----------------------------------------------------------------------*/
+    void remove(int accountNumber);
+
+    /***** Queries *****/
+    /*------------------------------------------------------------------------
+      Returns up to k counters, highest count first.
+
+      Precondition:  None.
+      Post-condition: Returns min(k, counters in use) counters.
+    -----------------------------------------------------------------------*/
+    vector<Counter> top(size_t k) const;
+
+    uint64_t getTotal() const;
+
+    size_t getCapacity() const;
+
+    /***** Clear *****/
+    void clear();
+
+    /***** Statistics *****/
+    size_t memoryBytes() const;
+};
+
+#endif // ACTIVITYSKETCH_H
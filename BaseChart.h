@@ -0,0 +1,18 @@
+#ifndef BASECHART_H
+#define BASECHART_H
+
+/**-- BaseChart.h -----------------------------------------------------------
+  Declares BASE_CHART, the Lebanese chart of accounts (accountswithspace.txt)
+  compiled into static data at build time by chart_compile. The definition is
+  generated into the build tree and linked through the chart_base library.
+
+  Usage:
+    ForestTree tree;
+    tree.buildFromTable(BASE_CHART);   // No parsing, base accounts in one block
+--------------------------------------------------------------------------**/
+
+#include "ChartTable.h"
+
+extern const ChartTable BASE_CHART;
+
+#endif // BASECHART_H
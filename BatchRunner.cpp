@@ -0,0 +1,742 @@
+#include "BatchRunner.h"
+#include "LedgerDiff.h"
+#include "NumberParsing.h"
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+    const char *const WHITESPACE = " \t\r\n\v\f";
+
+    // Splits off the next whitespace-delimited token; `rest` keeps what follows it
+    string_view nextToken(string_view &rest) {
+        size_t start = rest.find_first_not_of(WHITESPACE);
+        if (start == string_view::npos) {
+            rest = string_view();
+            return string_view();
+        }
+        size_t end = rest.find_first_of(WHITESPACE, start);
+        if (end == string_view::npos) end = rest.size();
+        string_view token = rest.substr(start, end - start);
+        rest = rest.substr(end);
+        return token;
+    }
+
+    string_view requireToken(string_view &rest, const char *name) {
+        string_view token = nextToken(rest);
+        if (token.empty()) {
+            throw invalid_argument(string("Missing ") + name);
+        }
+        return token;
+    }
+
+    int parseInt(string_view token, const char *name) {
+        int value;
+        if (!NumberParsing::parseInt(token, value)) {
+            throw invalid_argument(string("Invalid ") + name + ": " + string(token));
+        }
+        return value;
+    }
+
+    double parseAmount(string_view token, const char *name) {
+        string text(token);
+        char *end = nullptr;
+        double value = strtod(text.c_str(), &end);
+        if (end == text.c_str() || *end != '\0') {
+            throw invalid_argument(string("Invalid ") + name + ": " + text);
+        }
+        return value;
+    }
+
+    char parseType(string_view token) {
+        if (token == "D" || token == "d" || token == "Debit" || token == "debit") return 'D';
+        if (token == "C" || token == "c" || token == "Credit" || token == "credit") return 'C';
+        throw invalid_argument("Invalid transaction type: " + string(token) + ". Use D or C.");
+    }
+
+    int parseDateToken(string_view token) {
+        return Transaction::parseDate(string(token));
+    }
+
+    // Parses the options of remove-where / reverse-where; `on <date>` only when reversalDate is given
+    PostingFilter parseFilter(string_view &rest, bool &includeSubtree, int *reversalDate) {
+        PostingFilter filter;
+        includeSubtree = false;
+        for (string_view option = nextToken(rest); !option.empty(); option = nextToken(rest)) {
+            if (option == "subtree") {
+                includeSubtree = true;
+            } else if (option == "amount") {
+                filter.minAmount = filter.maxAmount = parseAmount(requireToken(rest, "amount"), "amount");
+            } else if (option == "min") {
+                filter.minAmount = parseAmount(requireToken(rest, "minimum amount"), "minimum amount");
+            } else if (option == "max") {
+                filter.maxAmount = parseAmount(requireToken(rest, "maximum amount"), "maximum amount");
+            } else if (option == "ids") {
+                filter.fromID = parseInt(requireToken(rest, "first transaction ID"), "first transaction ID");
+                filter.toID = parseInt(requireToken(rest, "last transaction ID"), "last transaction ID");
+            } else if (option == "dates") {
+                filter.fromDate = parseDateToken(requireToken(rest, "first date"));
+                filter.toDate = parseDateToken(requireToken(rest, "last date"));
+            } else if (option == "type") {
+                filter.type = parseType(requireToken(rest, "type"));
+            } else if (option == "on" && reversalDate) {
+                *reversalDate = parseDateToken(requireToken(rest, "reversal date"));
+            } else {
+                throw invalid_argument("Unknown filter option: " + string(option));
+            }
+        }
+        return filter;
+    }
+
+    size_t parseCount(string_view token) {
+        int count = parseInt(token, "count");
+        if (count < 1) {
+            throw invalid_argument("Invalid count: " + string(token));
+        }
+        return static_cast<size_t>(count);
+    }
+
+    void expectEnd(string_view rest) {
+        if (!nextToken(rest).empty()) {
+            throw invalid_argument("Unexpected arguments: " + string(rest));
+        }
+    }
+
+    void appendMoney(string &out, double value) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%.2f", value);
+        out += buffer;
+    }
+
+    void appendField(string &out, const char *name) {
+        out += ",\"";
+        out += name;
+        out += "\":";
+    }
+
+    // Appends a 64-bit hash as a JSON string of 16 hexadecimal digits
+    void appendHash(string &out, uint64_t hash) {
+        char buffer[24];
+        snprintf(buffer, sizeof(buffer), "\"%016llx\"", static_cast<unsigned long long>(hash));
+        out += buffer;
+    }
+
+    // Appends the account numbers of a list of changes as a JSON array
+    template<typename Change>
+    void appendNumbers(string &out, const vector<Change> &changes) {
+        out += '[';
+        for (size_t i = 0; i < changes.size(); ++i) {
+            if (i > 0) out += ',';
+            out += to_string(changes[i].accountNumber);
+        }
+        out += ']';
+    }
+}
+
+// Constructor binding the runner to a tree
+BatchRunner::BatchRunner(ForestTree &tree) : tree(tree) {}
+
+// Returns whether a line holds a command (not blank or a comment)
+bool BatchRunner::isCommand(string_view line) {
+    size_t start = line.find_first_not_of(WHITESPACE);
+    return start != string_view::npos && line[start] != '#';
+}
+
+// Returns whether a command only reads the tree
+bool BatchRunner::isReadOnly(string_view line) {
+    string_view op = nextToken(line);
+    return op == "query" || op == "postings" || op == "balance-at" || op == "movement" || op == "aggregate" ||
+           op == "search" || op == "diff" || op == "hash" || op == "replication" || op == "memory" ||
+           op == "top-balances" || op == "top-postings" || op == "heavy-hitters";
+}
+
+// Returns whether a command changes the tree
+bool BatchRunner::isMutation(string_view line) {
+    string_view op = nextToken(line);
+    return op == "add-account" || op == "remove-account" || op == "post" || op == "reverse" || op == "entry" ||
+           op == "unpost" || op == "remove-where" || op == "reverse-where" || op == "rule" || op == "clear-rule" ||
+           op == "recompute";
+}
+
+// Attaches a replication log
+void BatchRunner::setLog(ReplicationLog *replicationLog) {
+    log = replicationLog;
+}
+
+// Confines the file commands to a directory, or disables them if it is empty
+void BatchRunner::confineFiles(const string &directory) {
+    filesConfined = true;
+    fileDirectory = directory;
+}
+
+// Returns the path a file command opens, or throws if the runner's confinement forbids it
+string BatchRunner::filePath(string_view name) const {
+    if (!filesConfined) {
+        return string(name);
+    }
+    if (fileDirectory.empty()) {
+        throw invalid_argument("File commands are disabled");
+    }
+    if (name.find('/') != string_view::npos || name == "." || name == "..") {
+        throw invalid_argument("File must be a plain name inside the server's file directory");
+    }
+    return fileDirectory + '/' + string(name);
+}
+
+// Appends a JSON string literal, escaping quotes, backslashes and control characters
+void BatchRunner::appendString(string &out, string_view text) {
+    out += '"';
+    for (char c: text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buffer[8];
+                    snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    out += buffer;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+// Appends the fields describing an account
+void BatchRunner::appendAccount(string &out, const Account *account) const {
+    appendField(out, "account");
+    out += to_string(account->getAccountNumber());
+    appendField(out, "description");
+    appendString(out, account->getDescription());
+    appendField(out, "balance");
+    appendMoney(out, account->getBalance());
+    appendField(out, "parent");
+    out += account->getParent() ? to_string(account->getParent()->getAccountNumber()) : "null";
+    appendField(out, "postings");
+    out += to_string(account->getTransactions().size());
+}
+
+// Executes one command line and returns its JSON result
+string BatchRunner::execute(string_view line) {
+    string_view rest = line;
+    string_view op = nextToken(rest);
+
+    string out = "{\"seq\":" + to_string(++stats.commands) + ",\"op\":";
+    appendString(out, op);
+    size_t prefix = out.size();
+    out += ",\"ok\":true";
+
+    try {
+        if (log && log->isFollower() && isMutation(op)) {
+            throw invalid_argument("Read-only replica: send changes to the primary");
+        }
+        if (op == "add-account") {
+            int number = parseInt(requireToken(rest, "account number"), "account number");
+            double balance = parseAmount(requireToken(rest, "balance"), "balance");
+            size_t start = rest.find_first_not_of(WHITESPACE);
+            size_t end = rest.find_last_not_of(WHITESPACE);
+            string_view description = (start == string_view::npos) ? string_view() : rest.substr(start, end - start + 1);
+            tree.addAccount(number, description, balance);
+            appendAccount(out, tree.searchAccount(number));
+        } else if (op == "remove-account") {
+            int number = parseInt(requireToken(rest, "account number"), "account number");
+            expectEnd(rest);
+            tree.removeAccount(number);
+            appendField(out, "account");
+            out += to_string(number);
+        } else if (op == "post") {
+            int number = parseInt(requireToken(rest, "account number"), "account number");
+            double amount = parseAmount(requireToken(rest, "amount"), "amount");
+            char type = parseType(requireToken(rest, "type"));
+            string_view dateToken = nextToken(rest);
+            int date = dateToken.empty() ? 0 : parseDateToken(dateToken);
+            expectEnd(rest);
+
+            tree.emplaceTransaction(number, amount, type, date);
+            const Account *account = tree.searchAccount(number);
+            PostingView postings = account->getTransactions();
+            appendField(out, "account");
+            out += to_string(number);
+            appendField(out, "id");
+            out += to_string(postings[postings.size() - 1].getTransactionID());
+            appendField(out, "balance");
+            appendMoney(out, account->getBalance());
+        } else if (op == "reverse") {
+            int number = parseInt(requireToken(rest, "account number"), "account number");
+            int id = parseInt(requireToken(rest, "transaction ID"), "transaction ID");
+            string_view dateToken = nextToken(rest);
+            expectEnd(rest);
+
+            Account *account = tree.searchAccount(number);
+            if (!account) {
+                throw invalid_argument("Account not found");
+            }
+            double amount = 0.0;
+            char type = '\0';
+            int date = 0;
+            for (auto posting: account->getTransactions()) {
+                if (posting->getTransactionID() == id) {
+                    amount = posting->getAmount();
+                    type = (posting->getDebitOrCredit() == 'D') ? 'C' : 'D';
+                    date = posting->getDate();
+                    break;
+                }
+            }
+            if (type == '\0') {
+                throw invalid_argument("Transaction not found for the given account.");
+            }
+            if (!dateToken.empty()) {
+                date = parseDateToken(dateToken);
+            }
+
+            tree.emplaceTransaction(number, amount, type, date);
+            PostingView postings = account->getTransactions();
+            appendField(out, "account");
+            out += to_string(number);
+            appendField(out, "reversed");
+            out += to_string(id);
+            appendField(out, "id");
+            out += to_string(postings[postings.size() - 1].getTransactionID());
+            appendField(out, "balance");
+            appendMoney(out, account->getBalance());
+        } else if (op == "entry") {
+            // Legs are <number> <amount> <type> triples; a single token left over is the date
+            vector<string_view> tokens;
+            for (string_view token = nextToken(rest); !token.empty(); token = nextToken(rest)) {
+                tokens.push_back(token);
+            }
+            size_t legCount = tokens.size() / 3;
+            int date = (tokens.size() % 3 == 1) ? parseDateToken(tokens.back()) : 0;
+            if (tokens.size() % 3 == 2) {
+                throw invalid_argument("Incomplete leg: expected <number> <amount> <D|C>");
+            }
+            JournalEntry entry(date);
+            for (size_t i = 0; i < legCount; ++i) {
+                entry.addLeg(parseInt(tokens[3 * i], "account number"), parseAmount(tokens[3 * i + 1], "amount"),
+                             parseType(tokens[3 * i + 2]));
+            }
+
+            tree.postEntry(entry);
+            appendField(out, "legs");
+            out += '[';
+            for (size_t i = 0; i < legCount; ++i) {
+                const JournalEntry::Leg &leg = entry.getLegs()[i];
+                const Account *account = tree.searchAccount(leg.accountNumber);
+                size_t laterLegs = 0;   // Later legs on the same account hold the IDs after this one
+                for (size_t j = i + 1; j < legCount; ++j) {
+                    laterLegs += entry.getLegs()[j].accountNumber == leg.accountNumber;
+                }
+                out += (i == 0) ? "{\"account\":" : ",{\"account\":";
+                out += to_string(leg.accountNumber);
+                appendField(out, "id");
+                out += to_string(account->getTransactions().size() - laterLegs);
+                appendField(out, "balance");
+                appendMoney(out, account->getBalance());
+                out += '}';
+            }
+            out += ']';
+            appendField(out, "total");
+            appendMoney(out, entry.getDebitTotal());
+        } else if (op == "rule") {
+            int number = parseInt(requireToken(rest, "account number"), "account number");
+            PostingRules::Rule rule;
+            for (string_view option = nextToken(rest); !option.empty(); option = nextToken(rest)) {
+                if (option == "negative") {
+                    rule.floor = -numeric_limits<double>::infinity();
+                } else if (option == "floor") {
+                    rule.floor = parseAmount(requireToken(rest, "floor"), "floor");
+                } else if (option == "limit") {
+                    rule.limit = parseAmount(requireToken(rest, "limit"), "limit");
+                } else if (option == "debit-only") {
+                    rule.types = PostingRules::DEBITS;
+                } else if (option == "credit-only") {
+                    rule.types = PostingRules::CREDITS;
+                } else {
+                    throw invalid_argument("Unknown rule option: " + string(option));
+                }
+            }
+            tree.setPostingRule(number, rule);
+            appendField(out, "subtree");
+            out += to_string(number);
+            appendField(out, "floor");
+            if (isinf(rule.floor)) out += "null"; else appendMoney(out, rule.floor);
+            appendField(out, "limit");
+            if (isinf(rule.limit)) out += "null"; else appendMoney(out, rule.limit);
+            appendField(out, "types");
+            out += (rule.types == PostingRules::DEBITS) ? "\"D\"" : (rule.types == PostingRules::CREDITS) ? "\"C\"" : "\"DC\"";
+        } else if (op == "clear-rule") {
+            int number = parseInt(requireToken(rest, "account number"), "account number");
+            expectEnd(rest);
+            if (!tree.removePostingRule(number)) {
+                throw invalid_argument("No rule for subtree " + to_string(number));
+            }
+            appendField(out, "subtree");
+            out += to_string(number);
+        } else if (op == "remove-where" || op == "reverse-where") {
+            int number = parseInt(requireToken(rest, "account number"), "account number");
+            bool includeSubtree = false;
+            int reversalDate = 0;
+            PostingFilter filter = parseFilter(rest, includeSubtree, (op == "reverse-where") ? &reversalDate : nullptr);
+            size_t count = (op == "remove-where")
+                           ? tree.removePostings(number, filter, includeSubtree)
+                           : tree.reversePostings(number, filter, includeSubtree, reversalDate);
+            appendField(out, "account");
+            out += to_string(number);
+            appendField(out, (op == "remove-where") ? "removed" : "reversed");
+            out += to_string(count);
+            appendField(out, "balance");
+            appendMoney(out, tree.searchAccount(number)->getBalance());
+        } else if (op == "unpost") {
+            int number = parseInt(requireToken(rest, "account number"), "account number");
+            int id = parseInt(requireToken(rest, "transaction ID"), "transaction ID");
+            expectEnd(rest);
+            tree.removeTransaction(number, id);
+            appendField(out, "account");
+            out += to_string(number);
+            appendField(out, "balance");
+            appendMoney(out, tree.searchAccount(number)->getBalance());
+        } else if (op == "query" || op == "postings") {
+            int number = parseInt(requireToken(rest, "account number"), "account number");
+            expectEnd(rest);
+            const Account *account = tree.searchAccount(number);
+            if (!account) {
+                throw invalid_argument("Account not found");
+            }
+            appendAccount(out, account);
+            if (op == "postings") {
+                appendField(out, "transactions");
+                out += '[';
+                bool first = true;
+                for (auto posting: account->getTransactions()) {
+                    out += first ? "{\"id\":" : ",{\"id\":";
+                    first = false;
+                    out += to_string(posting->getTransactionID());
+                    appendField(out, "amount");
+                    appendMoney(out, posting->getAmount());
+                    appendField(out, "type");
+                    out += (posting->getDebitOrCredit() == 'D') ? "\"D\"" : "\"C\"";
+                    if (posting->getDate() != 0) {
+                        appendField(out, "date");
+                        appendString(out, Transaction::formatDate(posting->getDate()));
+                    }
+                    out += '}';
+                }
+                out += ']';
+            }
+        } else if (op == "balance-at") {
+            int number = parseInt(requireToken(rest, "account number"), "account number");
+            int date = parseDateToken(requireToken(rest, "date"));
+            expectEnd(rest);
+            double balance = tree.balanceAt(number, date);
+            appendField(out, "account");
+            out += to_string(number);
+            appendField(out, "date");
+            appendString(out, Transaction::formatDate(date));
+            appendField(out, "balance");
+            appendMoney(out, balance);
+        } else if (op == "movement") {
+            int number = parseInt(requireToken(rest, "account number"), "account number");
+            int fromDate = parseDateToken(requireToken(rest, "start date"));
+            int toDate = parseDateToken(requireToken(rest, "end date"));
+            expectEnd(rest);
+            double movement = tree.periodMovement(number, fromDate, toDate);
+            appendField(out, "account");
+            out += to_string(number);
+            appendField(out, "movement");
+            appendMoney(out, movement);
+        } else if (op == "aggregate") {
+            int number = parseInt(requireToken(rest, "account number"), "account number");
+            string_view metricName = requireToken(rest, "metric");
+            QueryCache::Metric metric;
+            if (!QueryCache::parseMetric(metricName, metric)) {
+                throw invalid_argument("Invalid metric: " + string(metricName));
+            }
+            int fromDate = 0, toDate = 0;
+            string_view fromToken = nextToken(rest);
+            if (!fromToken.empty()) {
+                fromDate = parseDateToken(fromToken);
+                toDate = parseDateToken(requireToken(rest, "end date"));
+            }
+            expectEnd(rest);
+            double value = tree.subtreeAggregate(number, metric, fromDate, toDate);
+            appendField(out, "account");
+            out += to_string(number);
+            appendField(out, "metric");
+            appendString(out, metricName);
+            appendField(out, "value");
+            if (metric == QueryCache::POSTING_COUNT) {
+                out += to_string(static_cast<long long>(value));
+            } else {
+                appendMoney(out, value);
+            }
+        } else if (op == "search") {
+            size_t start = rest.find_first_not_of(WHITESPACE);
+            if (start == string_view::npos) {
+                throw invalid_argument("Missing search words");
+            }
+            vector<Account *> matches = tree.searchByDescription(string(rest.substr(start)));
+            appendField(out, "matches");
+            out += '[';
+            for (size_t i = 0; i < matches.size(); ++i) {
+                out += (i == 0) ? "{\"account\":" : ",{\"account\":";
+                out += to_string(matches[i]->getAccountNumber());
+                appendField(out, "description");
+                appendString(out, matches[i]->getDescription());
+                out += '}';
+            }
+            out += ']';
+        } else if (op == "hash") {
+            // Subtree hash of an account and its children, or of the top-level accounts
+            string_view numberToken = nextToken(rest);
+            expectEnd(rest);
+            int number = numberToken.empty() ? 0 : parseInt(numberToken, "account number");
+            vector<Account *> children = tree.getChildren(number);
+            appendField(out, "account");
+            if (number == 0) {
+                out += "null";
+            } else {
+                out += to_string(number);
+                appendField(out, "hash");
+                appendHash(out, tree.searchAccount(number)->getSubtreeHash());
+            }
+            appendField(out, "children");
+            out += '[';
+            for (size_t i = 0; i < children.size(); ++i) {
+                out += (i == 0) ? "{\"account\":" : ",{\"account\":";
+                out += to_string(children[i]->getAccountNumber());
+                appendField(out, "hash");
+                appendHash(out, children[i]->getSubtreeHash());
+                out += '}';
+            }
+            out += ']';
+        } else if (op == "top-balances") {
+            size_t k = parseCount(requireToken(rest, "count"));
+            string_view numberToken = nextToken(rest);
+            expectEnd(rest);
+            int number = numberToken.empty() ? 0 : parseInt(numberToken, "account number");
+            vector<Account *> accounts = tree.topBalances(k, number);
+            appendField(out, "accounts");
+            out += '[';
+            for (size_t i = 0; i < accounts.size(); ++i) {
+                out += (i == 0) ? "{\"account\":" : ",{\"account\":";
+                out += to_string(accounts[i]->getAccountNumber());
+                appendField(out, "balance");
+                appendMoney(out, accounts[i]->getBalance());
+                out += '}';
+            }
+            out += ']';
+        } else if (op == "top-postings") {
+            // The account number is optional: filter options never start with a digit
+            size_t k = parseCount(requireToken(rest, "count"));
+            string_view peek = rest;
+            string_view numberToken = nextToken(peek);
+            int number = 0;
+            if (!numberToken.empty() && isdigit(static_cast<unsigned char>(numberToken[0]))) {
+                number = parseInt(numberToken, "account number");
+                rest = peek;
+            }
+            bool includeSubtree = false;
+            PostingFilter filter = parseFilter(rest, includeSubtree, nullptr);
+            vector<ForestTree::RankedPosting> ranked = tree.topPostings(k, number, filter, includeSubtree);
+            appendField(out, "postings");
+            out += '[';
+            for (size_t i = 0; i < ranked.size(); ++i) {
+                out += (i == 0) ? "{\"account\":" : ",{\"account\":";
+                out += to_string(ranked[i].accountNumber);
+                appendField(out, "id");
+                out += to_string(ranked[i].transactionID);
+                appendField(out, "amount");
+                appendMoney(out, ranked[i].amount);
+                appendField(out, "type");
+                out += (ranked[i].debitOrCredit == 'D') ? "\"D\"" : "\"C\"";
+                if (ranked[i].date != 0) {
+                    appendField(out, "date");
+                    appendString(out, Transaction::formatDate(ranked[i].date));
+                }
+                out += '}';
+            }
+            out += ']';
+        } else if (op == "heavy-hitters") {
+            string_view countToken = nextToken(rest);
+            expectEnd(rest);
+            const ActivitySketch &activity = tree.getActivitySketch();
+            vector<ActivitySketch::Counter> counters = activity.top(countToken.empty() ? 20 : parseCount(countToken));
+            appendField(out, "postings");
+            out += to_string(activity.getTotal());
+            appendField(out, "accounts");
+            out += '[';
+            for (size_t i = 0; i < counters.size(); ++i) {
+                out += (i == 0) ? "{\"account\":" : ",{\"account\":";
+                out += to_string(counters[i].accountNumber);
+                appendField(out, "count");
+                out += to_string(counters[i].count);
+                appendField(out, "error");
+                out += to_string(counters[i].error);
+                out += '}';
+            }
+            out += ']';
+        } else if (op == "recompute") {
+            // Rebuilds every balance from the postings and lists the accounts that were off
+            expectEnd(rest);
+            vector<ForestTree::BalanceMismatch> mismatches;
+            tree.recomputeBalances(&mismatches);
+            appendField(out, "mismatches");
+            out += '[';
+            for (size_t i = 0; i < mismatches.size(); ++i) {
+                out += (i == 0) ? "{\"account\":" : ",{\"account\":";
+                out += to_string(mismatches[i].accountNumber);
+                appendField(out, "stored");
+                appendMoney(out, mismatches[i].stored);
+                appendField(out, "recomputed");
+                appendMoney(out, mismatches[i].recomputed);
+                out += '}';
+            }
+            out += ']';
+        } else if (op == "diff") {
+            // The saved state is "before", the live tree "after"
+            string file = filePath(requireToken(rest, "file"));
+            expectEnd(rest);
+            ForestTree saved;
+            saved.buildFromFile(file);
+            LedgerDiff::Report report = LedgerDiff::compare(saved, tree);
+            appendField(out, "addedAccounts");
+            appendNumbers(out, report.addedAccounts);
+            appendField(out, "removedAccounts");
+            appendNumbers(out, report.removedAccounts);
+            appendField(out, "changedDescriptions");
+            appendNumbers(out, report.changedDescriptions);
+            appendField(out, "balances");
+            out += '[';
+            for (size_t i = 0; i < report.balanceChanges.size(); ++i) {
+                const LedgerDiff::BalanceChange &change = report.balanceChanges[i];
+                out += (i == 0) ? "{\"account\":" : ",{\"account\":";
+                out += to_string(change.accountNumber);
+                appendField(out, "before");
+                appendMoney(out, change.before);
+                appendField(out, "after");
+                appendMoney(out, change.after);
+                out += '}';
+            }
+            out += ']';
+            appendField(out, "addedPostings");
+            out += to_string(report.addedPostings.size());
+            appendField(out, "removedPostings");
+            out += to_string(report.removedPostings.size());
+            appendField(out, "skipped");
+            out += to_string(report.subtreesSkipped);
+        } else if (op == "replication") {
+            expectEnd(rest);
+            if (!log) {
+                throw invalid_argument("Replication is not enabled");
+            }
+            ReplicationLog::Status status = log->getStatus();
+            appendField(out, "role");
+            out += (status.role == ReplicationLog::PRIMARY) ? "\"primary\"" : "\"replica\"";
+            appendField(out, "epoch");
+            appendHash(out, status.epoch);
+            appendField(out, "position");
+            out += to_string(status.position);
+            appendField(out, "firstRetained");
+            out += to_string(status.firstRetained);
+            appendField(out, "treeHash");
+            appendHash(out, tree.getTreeHash());
+            if (status.role == ReplicationLog::REPLICA) {
+                appendField(out, "connected");
+                out += status.connected ? "true" : "false";
+                appendField(out, "primaryPosition");
+                out += to_string(status.upstreamPosition);
+                appendField(out, "behind");
+                out += to_string(status.upstreamPosition - status.position);
+                appendField(out, "lastDelayMicros");
+                out += to_string(status.lastDelayMicros);
+                appendField(out, "maxDelayMicros");
+                out += to_string(status.maxDelayMicros);
+                appendField(out, "sinceContactMillis");
+                out += to_string(status.sinceContactMicros < 0 ? -1 : status.sinceContactMicros / 1000);
+                appendField(out, "reconnects");
+                out += to_string(status.reconnects);
+                appendField(out, "error");
+                if (status.error.empty()) out += "null"; else appendString(out, status.error);
+            }
+        } else if (op == "memory" || op == "compact") {
+            // compact changes no balance, posting or description, so it is not a mutation for the log
+            expectEnd(rest);
+            if (op == "compact") {
+                appendField(out, "released");
+                out += to_string(tree.compact());
+            }
+            ForestTree::MemoryStats memory = tree.memoryStats();
+            appendField(out, "accounts");
+            out += to_string(memory.accountCount);
+            appendField(out, "postings");
+            out += to_string(memory.postingCount);
+            appendField(out, "bytes");
+            out += "{\"accounts\":" + to_string(memory.accounts);
+            appendField(out, "descriptions");
+            out += to_string(memory.descriptions);
+            appendField(out, "postings");
+            out += to_string(memory.postings);
+            appendField(out, "indexes");
+            out += to_string(memory.indexes);
+            appendField(out, "slack");
+            out += to_string(memory.slack);
+            appendField(out, "total");
+            out += to_string(memory.total()) + '}';
+        } else if (op == "export") {
+            size_t start = rest.find_first_not_of(WHITESPACE);
+            size_t end = rest.find_last_not_of(WHITESPACE);
+            if (start == string_view::npos) {
+                throw invalid_argument("Missing export file");
+            }
+            string_view file = rest.substr(start, end - start + 1);
+            tree.printTree(filePath(file));
+            appendField(out, "file");
+            appendString(out, file);
+        } else {
+            throw invalid_argument("Unknown command: " + string(op));
+        }
+    } catch (const exception &e) {
+        out.resize(prefix);
+        out += ",\"ok\":false,\"error\":";
+        appendString(out, e.what());
+        out += '}';
+        ++stats.failed;
+        return out;
+    }
+
+    out += '}';
+    ++stats.succeeded;
+    if (log && isMutation(op)) {
+        log->append(line);
+    }
+    return out;
+}
+
+// Executes every command of a stream, writing one result per line
+size_t BatchRunner::run(istream &in, ostream &out) {
+    size_t failedBefore = stats.failed;
+    string line;
+    while (getline(in, line)) {
+        if (!isCommand(line)) continue;
+        out << execute(line) << '\n';
+    }
+    out.flush();
+    return stats.failed - failedBefore;
+}
+
+// Returns the commands executed, succeeded and failed so far
+const BatchRunner::Stats &BatchRunner::getStats() const {
+    return stats;
+}
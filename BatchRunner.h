@@ -0,0 +1,194 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+/**-- BatchRunner.h ---------------------------------------------------------
+  This header file defines the BatchRunner class, which executes text
+  commands against a ForestTree without prompts and reports each result as
+  one line of JSON. It backs the batch mode of the chart executable and can
+  be reused by any front end that speaks the same line protocol.
+
+  Command grammar (one command per line, whitespace-separated; blank lines
+  and lines starting with '#' are skipped):
+
+    add-account <number> <balance> <description...>
+    remove-account <number>
+    post <number> <amount> <D|C> [<YYYY-MM-DD>]
+    reverse <number> <transactionID> [<YYYY-MM-DD>]
+                               Posts an offsetting entry (opposite type, same
+                               amount, the original date unless one is given)
+    entry <number> <amount> <D|C> <number> <amount> <D|C> ... [<YYYY-MM-DD>]
+                               Posts a balanced journal entry atomically
+                               (ForestTree::postEntry)
+    unpost <number> <transactionID>
+                               Deletes a posting (removeTransaction)
+    remove-where <number> [subtree] [amount <x> | min <x> | max <x>] [ids <first> <last>]
+                 [dates <from> <to>] [type <D|C>]
+                               Deletes every matching posting of an account, or
+                               of its subtree (ForestTree::removePostings)
+    reverse-where <number> <same filter options> [on <YYYY-MM-DD>]
+                               Reverses every matching posting (reversePostings)
+    rule <number> [negative | floor <amount>] [limit <amount>] [debit-only | credit-only]
+                               Sets the posting rule of a subtree (PostingRules)
+    clear-rule <number>        Removes the posting rule of a subtree
+    query <number>             Account details
+    postings <number>          Account details and every posting
+    balance-at <number> <YYYY-MM-DD>
+    movement <number> <YYYY-MM-DD> <YYYY-MM-DD>
+    aggregate <number> <balance|debits|credits|turnover|postings> [<from> <to>]
+                               Cached subtree aggregate (ForestTree::subtreeAggregate)
+    search <words...>          Ranked description search (up to 20 matches)
+    top-balances <k> [<number>]
+                               The k largest balances, of the ledger or of an
+                               account and its descendants (ForestTree::topBalances)
+    top-postings <k> [<number>] [subtree] [<remove-where filter options>]
+                               The k largest matching postings, of the ledger
+                               or of an account (or subtree)
+    heavy-hitters [<k>]        The k (default 20) accounts posted to most often,
+                               with each count's maximum overestimate (ActivitySketch)
+    export <file>              Writes the chart with printTree
+    hash [<number>]            Subtree hash of an account and of each child (of the
+                               top-level accounts if no number is given), to find
+                               where two replicas differ by descending
+    recompute                  Recomputes every balance from the postings
+                               (ForestTree::recomputeBalances) and lists the
+                               accounts whose stored balance was off
+    diff <file>                What changed since a saved chart (LedgerDiff): added,
+                               removed and renamed accounts, balance changes, and
+                               the number of added and removed postings
+    replication                Log position of a primary or replica (ReplicationLog)
+                               and, on a replica, its lag behind the primary
+    memory                     Bytes held by the tree by category (ForestTree::memoryStats)
+    compact                    Releases the memory left by removals (ForestTree::compact)
+                               and reports the bytes released and held afterwards
+
+  With a ReplicationLog (setLog), every successful command that changes the
+  tree (isMutation) is appended to the log of a primary, and rejected on a
+  replica, whose tree only changes through its LogFollower.
+
+  The file commands (export, diff) open any path the process can reach. A
+  front end serving untrusted clients confines them with confineFiles: they
+  then take a plain file name inside one directory, or fail if there is none.
+
+  Every result is a JSON object on one line with "seq" (1-based command
+  number), "op", "ok" and either the command's fields or "error".
+
+  Basic operations:
+    Constructor:   Binds the runner to a tree.
+    execute:       Executes one command and returns its JSON result.
+    run:           Executes every command of a stream, writing one result per line.
+    getStats:      Commands executed, succeeded and failed so far.
+    setLog:        Records mutations in, or rejects them for, a replication log.
+    confineFiles:  Restricts the file commands to one directory, or disables them.
+
+  Helper functions:
+    isCommand:     Returns whether a line holds a command (not blank or a comment).
+    isReadOnly:    Returns whether a command only reads the tree.
+    isMutation:    Returns whether a command changes the tree.
+    appendString:  Appends a JSON string literal with escaping.
+    filePath:      Resolves the file argument of a file command.
+--------------------------------------------------------------------------**/
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include "ForestTree.h"
+#include "ReplicationLog.h"
+
+using namespace std;
+
+class BatchRunner {
+public:
+    struct Stats {
+        size_t commands = 0;     // Commands executed
+        size_t succeeded = 0;    // Commands that returned "ok": true
+        size_t failed = 0;       // Commands that returned an error
+    };
+
+private:
+    ForestTree &tree;    // Tree the commands act on
+    Stats stats;
+    ReplicationLog *log = nullptr;    // Log of the mutations, if replicating
+    bool filesConfined = false;       // File commands limited to fileDirectory
+    string fileDirectory;             // Directory of the file commands when confined (none if empty)
+
+    string filePath(string_view name) const;
+
+    static void appendString(string &out, string_view text);
+
+    void appendAccount(string &out, const Account *account) const;
+
+public:
+    /***** Constructor *****/
+    explicit BatchRunner(ForestTree &tree);
+
+    /***** Execute *****/
+    /*------------------------------------------------------------------------
+      Executes one command line and returns its JSON result (without a
+      trailing newline). Errors, including malformed commands and failed
+      tree operations, are reported in the result and never thrown.
+
+      Precondition:  isCommand(line) is true.
+      Post-condition: The tree reflects the command if it succeeded; the
+                      statistics are updated.
+    -----------------------------------------------------------------------*/
+    string execute(string_view line);
+
+    /***** Run *****/
+    /*------------------------------------------------------------------------
+      Executes every command read from `in`, writing one JSON result per line
+      to `out`.
+
+      Precondition:  None.
+      Post-condition: Returns the number of commands that failed.
+    -----------------------------------------------------------------------*/
+    size_t run(istream &in, ostream &out);
+
+    /***** Statistics *****/
+    const Stats &getStats() const;
+
+    /***** Replication *****/
+    /*------------------------------------------------------------------------
+      Attaches a replication log: on a primary, each successful mutation is
+      appended to it (the caller serializes mutations, e.g. the server's
+      exclusive lock); on a replica, mutations fail as read-only.
+
+      Precondition:  The log outlives the runner, or log is nullptr.
+      Post-condition: Later commands follow the log's role.
+    -----------------------------------------------------------------------*/
+    void setLog(ReplicationLog *replicationLog);
+
+    /***** File access *****/
+    /*------------------------------------------------------------------------
+      Confines export and diff to a directory: their file must be a plain
+      name (no '/', not "." or "..") and is opened inside `directory`. With
+      an empty directory, file commands fail.
+
+      Precondition:  None.
+      Post-condition: Later file commands only reach files in `directory`.
+    -----------------------------------------------------------------------*/
+    void confineFiles(const string &directory);
+
+    static bool isCommand(string_view line);
+
+    /*------------------------------------------------------------------------
+      Returns whether a command only reads the tree (query, postings,
+      balance-at, movement, aggregate, search, diff, hash, replication,
+      memory, top-balances, top-postings, heavy-hitters), so it may run
+      concurrently with other read-only commands. A server takes its shared
+      lock for these and its exclusive lock for everything else.
+    -----------------------------------------------------------------------*/
+    static bool isReadOnly(string_view line);
+
+    /*------------------------------------------------------------------------
+      Returns whether a command changes the tree (add-account, remove-account,
+      post, reverse, entry, unpost, remove-where, reverse-where, rule,
+      clear-rule, recompute): the commands a replication log records.
+      export and compact are in neither list: they update caches or storage
+      (so they run exclusively) but leave the ledger's contents unchanged.
+    -----------------------------------------------------------------------*/
+    static bool isMutation(string_view line);
+};
+
+#endif // BATCHRUNNER_H
@@ -0,0 +1,86 @@
+#include "ChartSkeleton.h"
+#include "ForestTree.h"
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+using namespace std;
+
+// Constructor: Views a static chart table
+ChartSkeleton::ChartSkeleton(const ChartTable &chartTable) : table(chartTable) {
+    validate();
+}
+
+// Constructor: Copies the accounts of a ForestTree into an owned table
+ChartSkeleton::ChartSkeleton(const ForestTree &tree) : table{nullptr, 0, nullptr} {
+    const map<int, Account *> &accounts = tree.getAccountMap();
+    ownedEntries.reserve(accounts.size());
+    map<const Account *, int> indexOf;
+    for (const auto &pair: accounts) {
+        const Account *account = pair.second;
+        if (!account->getTransactions().empty()) {
+            throw invalid_argument("Account " + to_string(pair.first) + " has postings; a skeleton holds accounts only");
+        }
+        string_view description = account->getDescription();
+        int parent = account->getParent() ? indexOf.at(account->getParent()) : -1;
+        ownedEntries.push_back({pair.first, parent, static_cast<unsigned>(ownedDescriptions.size()),
+                                static_cast<unsigned>(description.size()), account->getBalance()});
+        ownedDescriptions.append(description);
+        indexOf[account] = static_cast<int>(ownedEntries.size()) - 1;
+    }
+    table = {ownedEntries.data(), ownedEntries.size(), ownedDescriptions.data()};
+}
+
+// Checks that entries are ordered and parents precede their children
+void ChartSkeleton::validate() const {
+    for (size_t i = 0; i < table.count; ++i) {
+        const ChartTableEntry &entry = table.entries[i];
+        if (i > 0 && entry.accountNumber <= table.entries[i - 1].accountNumber) {
+            throw invalid_argument("Chart table is not ordered by account number at entry " + to_string(i));
+        }
+        if (entry.parentIndex >= static_cast<int>(i)) {
+            throw invalid_argument("Chart table parent of entry " + to_string(i) + " is not an earlier entry");
+        }
+    }
+}
+
+// Returns the number of accounts
+size_t ChartSkeleton::size() const {
+    return table.count;
+}
+
+// Returns the index of an account number by binary search, or -1
+int ChartSkeleton::indexOf(int accountNumber) const {
+    const ChartTableEntry *end = table.entries + table.count;
+    const ChartTableEntry *it = lower_bound(table.entries, end, accountNumber,
+                                            [](const ChartTableEntry &entry, int number) {
+                                                return entry.accountNumber < number;
+                                            });
+    return (it != end && it->accountNumber == accountNumber) ? static_cast<int>(it - table.entries) : -1;
+}
+
+// Returns the account number at an index
+int ChartSkeleton::getAccountNumber(int index) const {
+    return table.entries[index].accountNumber;
+}
+
+// Returns the parent index of an index (-1 for a root)
+int ChartSkeleton::getParent(int index) const {
+    return table.entries[index].parentIndex;
+}
+
+// Returns the description at an index
+string_view ChartSkeleton::getDescription(int index) const {
+    const ChartTableEntry &entry = table.entries[index];
+    return string_view(table.descriptions + entry.descriptionOffset, entry.descriptionLength);
+}
+
+// Returns the opening balance at an index
+double ChartSkeleton::getOpeningBalance(int index) const {
+    return table.entries[index].balance;
+}
+
+// Returns the bytes held by the skeleton
+size_t ChartSkeleton::memoryBytes() const {
+    return sizeof(*this) + ownedEntries.capacity() * sizeof(ChartTableEntry) + ownedDescriptions.capacity();
+}
@@ -0,0 +1,117 @@
+#ifndef CHARTSKELETON_H
+#define CHARTSKELETON_H
+
+/**-- ChartSkeleton.h -------------------------------------------------------
+  This header file defines the ChartSkeleton class, the immutable shape of a
+  chart of accounts: account numbers, parent links, descriptions and
+  opening balances, with no postings. Accounts are addressed by a dense
+  index (their rank by account number), so per-account data of any number
+  of ledgers can be kept in plain arrays indexed the same way.
+
+  A skeleton is built once and shared, read-only, by every entity of a
+  MultiEntityLedger. Built from a ChartTable it views the table's static
+  data; built from a ForestTree it owns a copy laid out the same way.
+
+  Basic operations:
+    Constructor:        Builds the skeleton from a ChartTable or a ForestTree.
+    size:               Returns the number of accounts.
+    indexOf:            Returns the index of an account number (-1 if absent).
+    Getters:            Account number, parent index, description and
+                        opening balance of an index.
+    memoryBytes:        Returns the memory held by the skeleton.
+
+  Class Invariant:
+    1. table.entries is ordered by account number; index i is entry i.
+    2. The parent of every entry is -1 or an earlier index.
+    3. ownedEntries and ownedDescriptions back the table when it was built
+       from a ForestTree, and are empty otherwise.
+    4. The skeleton never changes after construction.
+--------------------------------------------------------------------------**/
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ChartTable.h"
+
+using namespace std;
+
+class ForestTree;
+
+class ChartSkeleton {
+private:
+    ChartTable table;                        // Entries and descriptions (static or owned)
+    vector<ChartTableEntry> ownedEntries;    // Entries copied from a ForestTree
+    string ownedDescriptions;                // Descriptions copied from a ForestTree
+
+    /***** Helper Function *****/
+    /*------------------------------------------------------------------------
+      Checks the ordering and parent links of the table.
+
+      Precondition:  table is set.
+      Post-condition: Throws invalid_argument if invariant 1 or 2 is broken.
+    -----------------------------------------------------------------------*/
+    void validate() const;
+
+public:
+    /***** Constructors *****/
+    /*------------------------------------------------------------------------
+      Builds a skeleton that views a ChartTable (e.g. BASE_CHART).
+
+      Precondition:  The table outlives the skeleton.
+      Post-condition: The skeleton has one account per table entry; throws
+                      invalid_argument if the table is malformed.
+    -----------------------------------------------------------------------*/
+    explicit ChartSkeleton(const ChartTable &chartTable);
+
+    /*------------------------------------------------------------------------
+      Builds a skeleton from the accounts of a ForestTree. Each account's
+      current balance becomes its opening balance.
+
+      Precondition:  The tree holds no postings.
+      Post-condition: The skeleton owns a copy of the accounts; throws
+                      invalid_argument if an account has postings.
+    -----------------------------------------------------------------------*/
+    explicit ChartSkeleton(const ForestTree &tree);
+
+    ChartSkeleton(const ChartSkeleton &) = delete;
+
+    ChartSkeleton &operator=(const ChartSkeleton &) = delete;
+
+    /***** Lookup *****/
+    /*------------------------------------------------------------------------
+      Returns the number of accounts, or the index of an account number.
+
+      Precondition:  None.
+      Post-condition: indexOf returns -1 if the account is not in the chart.
+    -----------------------------------------------------------------------*/
+    size_t size() const;
+
+    int indexOf(int accountNumber) const;
+
+    /***** Getters *****/
+    /*------------------------------------------------------------------------
+      Provide the attributes of the account at an index.
+
+      Precondition:  0 <= index < size().
+      Post-condition: getParent returns the parent's index, or -1 for a root.
+    -----------------------------------------------------------------------*/
+    int getAccountNumber(int index) const;
+
+    int getParent(int index) const;
+
+    string_view getDescription(int index) const;
+
+    double getOpeningBalance(int index) const;
+
+    /*------------------------------------------------------------------------
+      Returns the bytes held by the skeleton (0 beyond the object itself when
+      it views a static table).
+
+      Precondition:  None.
+      Post-condition: Returns the size in bytes.
+    -----------------------------------------------------------------------*/
+    size_t memoryBytes() const;
+};
+
+#endif // CHARTSKELETON_H
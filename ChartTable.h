@@ -0,0 +1,35 @@
+#ifndef CHARTTABLE_H
+#define CHARTTABLE_H
+
+/**-- ChartTable.h ----------------------------------------------------------
+  This header file defines the ChartTable structure, a chart of accounts
+  compiled into static data: one entry per account, ordered by account
+  number, with the parent given as an index into the same table and the
+  description as a range of one shared character array.
+
+  Tables are generated at build time by the chart_compile tool (see
+  tools/ChartCompiler.cpp) from a chart file such as accountswithspace.txt,
+  so every field lives in read-only memory and loading one needs no parsing.
+  ForestTree::buildFromTable loads a table.
+
+  The base chart of the executables is BASE_CHART, declared in BaseChart.h
+  and generated into the chart_base library.
+--------------------------------------------------------------------------**/
+
+#include <cstddef>
+
+struct ChartTableEntry {
+    int accountNumber;
+    int parentIndex;                // Index of the parent entry, or -1 for a root
+    unsigned descriptionOffset;     // Description: descriptions[offset, offset + length)
+    unsigned descriptionLength;
+    double balance;                 // Initial balance
+};
+
+struct ChartTable {
+    const ChartTableEntry *entries; // Ordered by account number
+    size_t count;
+    const char *descriptions;       // Every description, back to back
+};
+
+#endif // CHARTTABLE_H
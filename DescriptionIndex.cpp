@@ -0,0 +1,165 @@
+#include "DescriptionIndex.h"
+#include "MemoryUsage.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+// Constructor: Initializes an empty index
+DescriptionIndex::DescriptionIndex() = default;
+
+// Removes every account from the index
+void DescriptionIndex::clear() {
+    terms.clear();
+    documentLengths.clear();
+}
+
+// Splits text into lowercase ASCII alphanumeric tokens
+vector<string> DescriptionIndex::tokenize(string_view text) {
+    vector<string> tokens;
+    string current;
+    for (char c: text) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (isalnum(u)) {
+            current += static_cast<char>(tolower(u));
+        } else if (!current.empty()) {
+            tokens.push_back(current);
+            current.clear();
+        }
+    }
+    if (!current.empty()) {
+        tokens.push_back(current);
+    }
+    return tokens;
+}
+
+// Indexes an account's description
+void DescriptionIndex::add(int accountNumber, string_view description) {
+    if (accountNumber < 1 || accountNumber > MAX_ACCOUNT_NUMBER) {
+        throw invalid_argument("Account number must be between 1 and 99999.");
+    }
+    vector<string> tokens = tokenize(description);
+    documentLengths[accountNumber] = static_cast<int>(tokens.size());
+
+    for (const string &token: tokens) {
+        vector<Posting> &list = terms[token];
+        auto it = lower_bound(list.begin(), list.end(), accountNumber,
+                              [](const Posting &p, int number) { return p.accountNumber < number; });
+        if (it != list.end() && it->accountNumber == accountNumber) {
+            ++it->frequency;
+        } else {
+            list.insert(it, Posting{accountNumber, 1});
+        }
+    }
+}
+
+// Removes an account's description from the index
+void DescriptionIndex::remove(int accountNumber, string_view description) {
+    documentLengths.erase(accountNumber);
+
+    for (const string &token: tokenize(description)) {
+        auto term = terms.find(token);
+        if (term == terms.end()) continue;
+
+        vector<Posting> &list = term->second;
+        auto it = lower_bound(list.begin(), list.end(), accountNumber,
+                              [](const Posting &p, int number) { return p.accountNumber < number; });
+        if (it != list.end() && it->accountNumber == accountNumber) {
+            list.erase(it); // Repeated tokens find nothing left to erase
+        }
+        if (list.empty()) {
+            terms.erase(term);
+        }
+    }
+}
+
+// Shrinks the posting lists and the length table after removals
+void DescriptionIndex::compact() {
+    for (auto &term: terms) {
+        term.second.shrink_to_fit();
+    }
+    documentLengths.rehash(0);
+}
+
+// Returns the bytes of the term dictionary, posting lists and length table
+size_t DescriptionIndex::memoryBytes() const {
+    size_t bytes = MemoryUsage::treeBytes(terms) + MemoryUsage::hashBytes(documentLengths);
+    for (const auto &term: terms) {
+        bytes += MemoryUsage::stringBytes(term.first) + MemoryUsage::vectorBytes(term.second);
+    }
+    return bytes;
+}
+
+// Returns accounts matching every query word, best first
+vector<DescriptionIndex::Match> DescriptionIndex::search(const string &query, size_t limit) const {
+    vector<string> words = tokenize(query);
+    if (words.empty() || limit == 0) {
+        return {};
+    }
+
+    // Dense per-thread scratch indexed by account number; matchedWords[a] counts
+    // the leading query words account a has matched so far
+    thread_local vector<int> matchedWords(MAX_ACCOUNT_NUMBER + 1, 0);
+    thread_local vector<double> bestScore(MAX_ACCOUNT_NUMBER + 1, 0.0);
+    thread_local vector<double> totalScore(MAX_ACCOUNT_NUMBER + 1, 0.0);
+
+    double documentCount = static_cast<double>(documentLengths.size());
+    vector<int> candidates;
+
+    for (size_t w = 0; w < words.size(); ++w) {
+        const string &word = words[w];
+        int required = static_cast<int>(w);
+
+        // Best weight of this word per account, over every term it prefixes
+        for (auto term = terms.lower_bound(word);
+             term != terms.end() && term->first.compare(0, word.size(), word) == 0; ++term) {
+            double idf = log(1.0 + documentCount / static_cast<double>(term->second.size()));
+            double weight = (term->first.size() == word.size()) ? idf : idf * 0.5;
+
+            for (const Posting &posting: term->second) {
+                int account = posting.accountNumber;
+                double score = weight * (1.0 + 0.1 * (posting.frequency - 1));
+                if (matchedWords[account] == required) {
+                    // First term of this word for an account that matched every earlier word
+                    matchedWords[account] = required + 1;
+                    bestScore[account] = score;
+                    if (w == 0) {
+                        totalScore[account] = 0.0;
+                        candidates.push_back(account);
+                    }
+                } else if (matchedWords[account] == required + 1) {
+                    bestScore[account] = max(bestScore[account], score);
+                }
+            }
+        }
+
+        for (int account: candidates) {
+            if (matchedWords[account] == required + 1) {
+                totalScore[account] += bestScore[account];
+            }
+        }
+    }
+
+    vector<Match> matches;
+    int required = static_cast<int>(words.size());
+    for (int account: candidates) {
+        if (matchedWords[account] == required) {
+            double length = static_cast<double>(documentLengths.at(account));
+            matches.push_back(Match{account, totalScore[account] / (1.0 + 0.05 * length)});
+        }
+        matchedWords[account] = 0; // Leave the scratch clean for the next query
+    }
+
+    auto better = [](const Match &a, const Match &b) {
+        return a.score != b.score ? a.score > b.score : a.accountNumber < b.accountNumber;
+    };
+    if (matches.size() > limit) {
+        partial_sort(matches.begin(), matches.begin() + static_cast<long>(limit), matches.end(), better);
+        matches.resize(limit);
+    } else {
+        sort(matches.begin(), matches.end(), better);
+    }
+    return matches;
+}
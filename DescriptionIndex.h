@@ -0,0 +1,119 @@
+#ifndef DESCRIPTIONINDEX_H
+#define DESCRIPTIONINDEX_H
+
+/**-- DescriptionIndex.h ----------------------------------------------------
+  This header file defines the DescriptionIndex class, an inverted index over
+  account descriptions. Descriptions are split into lowercase alphanumeric
+  tokens; each token maps to the list of accounts whose description contains
+  it. Terms are kept sorted, so every query word is matched as a prefix with
+  a single ordered range scan.
+
+  Basic operations:
+    Constructor:  Constructs an empty index.
+    clear:        Removes every account from the index.
+    add:          Indexes an account's description.
+    remove:       Removes an account's description from the index.
+    search:       Returns accounts matching every query word, best first.
+    tokenize:     Splits text into lowercase alphanumeric tokens.
+    compact:      Releases spare capacity left by removals.
+    memoryBytes:  Returns the memory held by the index.
+
+  Ranking:
+    Each query word scores the best term it matches in a description:
+    idf(term) for an exact word, half of it for a prefix-only match, and a
+    small bonus for repeated words. Scores of all query words are summed and
+    divided by a mild description-length penalty, so short, specific
+    descriptions rank before long ones. Ties are broken by account number.
+
+  Class Invariant:
+    1. Every term's posting list holds distinct account numbers in ascending order.
+    2. documentLengths holds the token count of every indexed account.
+--------------------------------------------------------------------------**/
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+class DescriptionIndex {
+public:
+    static constexpr int MAX_ACCOUNT_NUMBER = 99999;   // Highest indexable account number
+
+    struct Match {
+        int accountNumber;   // Matching account
+        double score;        // Relevance score (higher is better)
+    };
+
+private:
+    struct Posting {
+        int accountNumber;   // Account whose description contains the term
+        int frequency;       // Number of occurrences of the term
+    };
+
+    map<string, vector<Posting>> terms;         // Sorted term dictionary
+    unordered_map<int, int> documentLengths;    // Token count per indexed account
+
+public:
+    /***** Constructor *****/
+    DescriptionIndex();
+
+    /***** Clear *****/
+    /*------------------------------------------------------------------------
+      Removes every account from the index.
+
+      Precondition:  None.
+      Post-condition: The index is empty.
+    -----------------------------------------------------------------------*/
+    void clear();
+
+    /***** Maintenance *****/
+    /*------------------------------------------------------------------------
+      Indexes or un-indexes an account's description. remove must be given
+      the same description that was indexed.
+
+      Precondition:  A valid account number and its description are provided.
+      Post-condition: The account's terms are added to or removed from the index.
+    -----------------------------------------------------------------------*/
+    void add(int accountNumber, string_view description);
+
+    void remove(int accountNumber, string_view description);
+
+    /***** Search *****/
+    /*------------------------------------------------------------------------
+      Returns up to `limit` accounts whose description matches every word of
+      the query (each word as an exact word or a word prefix), ranked by
+      relevance.
+
+      Precondition:  None.
+      Post-condition: Returns the matches, best first; empty for an empty query.
+                      Scoring uses per-thread scratch arrays indexed by account
+                      number, so concurrent searches are safe.
+    -----------------------------------------------------------------------*/
+    vector<Match> search(const string &query, size_t limit) const;
+
+    /***** Tokenizer *****/
+    /*------------------------------------------------------------------------
+      Splits text into lowercase ASCII alphanumeric tokens.
+
+      Precondition:  None.
+      Post-condition: Returns the tokens in order of appearance.
+    -----------------------------------------------------------------------*/
+    static vector<string> tokenize(string_view text);
+
+    /***** Memory *****/
+    /*------------------------------------------------------------------------
+      Shrinks every posting list to its size and the length table to its
+      entries, e.g. after many accounts were removed.
+
+      Precondition:  None.
+      Post-condition: The index answers the same searches.
+    -----------------------------------------------------------------------*/
+    void compact();
+
+    size_t memoryBytes() const;
+};
+
+#endif // DESCRIPTIONINDEX_H
@@ -1,34 +1,89 @@
 #include "ForestTree.h"
+#include "PostingKernels.h"
+#include "Metrics.h"
+#include "MemoryUsage.h"
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <thread>
 
 using namespace std;
 
+namespace {
+
+    const size_t PARALLEL_MIN_ITEMS = 2048;    // Smaller ranges are not worth a thread
+
+    // Runs work(begin, end) over [0, count), split into ranges across up to `threads` threads
+    void parallelFor(size_t count, unsigned threads, const function<void(size_t, size_t)> &work) {
+        size_t ranges = min<size_t>(threads, (count + PARALLEL_MIN_ITEMS - 1) / PARALLEL_MIN_ITEMS);
+        if (ranges <= 1) {
+            if (count > 0) work(0, count);
+            return;
+        }
+        size_t step = (count + ranges - 1) / ranges;
+        vector<thread> workers;
+        workers.reserve(ranges - 1);
+        for (size_t begin = step; begin < count; begin += step) {
+            workers.emplace_back(work, begin, min(count, begin + step));
+        }
+        work(0, step);
+        for (thread &worker: workers) worker.join();
+    }
+}
+
 // Constructor for initializing an empty ForestTree
-ForestTree::ForestTree() : root(nullptr) {}
+ForestTree::ForestTree() : root(nullptr), descriptionIndexPending(false), baseAccounts(nullptr), baseAccountCount(0) {}
 
 // Destructor for cleaning up the ForestTree and releasing memory
 ForestTree::~ForestTree() {
     for (auto &pair: accountMap) {
         deleteTree(pair.second);
     }
+    releaseBaseAccounts();
 }
 
 // Helper function to recursively delete accounts
 void ForestTree::deleteTree(Account *node) {
-    if (node) {
+    if (!node) return;
+    if (baseAccounts && node >= baseAccounts && node < baseAccounts + baseAccountCount) {
+        node->~Account(); // Table accounts share one block, freed by releaseBaseAccounts
+    } else {
         delete node;
     }
 }
 
+// Frees the block of table accounts
+void ForestTree::releaseBaseAccounts() {
+    if (baseAccounts) {
+        allocator<Account>().deallocate(baseAccounts, baseAccountCount);
+        baseAccounts = nullptr;
+        baseAccountCount = 0;
+    }
+}
+
 // Initializes an empty ForestTree by clearing all accounts and resetting root
 void ForestTree::initialize() {
     for (auto &pair: accountMap) {
         deleteTree(pair.second);
     }
     accountMap.clear();
+    releaseBaseAccounts();
+    periodBalances.clear();
+    descriptionIndex.clear();
+    descriptionIndexPending.store(false, memory_order_relaxed);
+    postings.clear();
+    descriptions.clear();
+    rendered.clear();
+    queryCache.clear();
+    rules.resetTable();
+    activity.clear();
     root = nullptr;
 }
 
@@ -54,58 +109,78 @@ int ForestTree::findParentNumber(int accountNumber) const {
 
 
 // Cleans account description by removing unwanted characters and trimming spaces
-string ForestTree::cleanDescription(const string &desc) const {
-    if (desc.empty()) {
-        return "";
-    }
-
-    string cleaned = desc;
-
+string_view ForestTree::cleanDescription(string_view desc) const {
     // Trim leading whitespace
-    size_t start = cleaned.find_first_not_of(" \t");
-    if (start != string::npos) {
-        cleaned = cleaned.substr(start);
+    size_t start = desc.find_first_not_of(" \t");
+    if (start == string_view::npos) {
+        return desc.substr(desc.size());
     }
 
     // Trim trailing whitespace
-    size_t end = cleaned.find_last_not_of(" \t");
-    if (end != string::npos) {
-        cleaned = cleaned.substr(0, end + 1);
-    }
-
-    return cleaned;
+    size_t end = desc.find_last_not_of(" \t");
+    return desc.substr(start, end - start + 1);
 }
 
 
 // Builds the chart of accounts by reading from a file
 void ForestTree::buildFromFile(const string &filename) {
+    CHART_METRIC_SCOPE(Metrics::BUILD_FROM_FILE);
     ifstream file(filename);
     if (!file.is_open()) {
         throw runtime_error("Could not open file: " + filename);
     }
 
-    string line, description;
+    // A printed balance already includes the postings of the account and its descendants, so accounts and
+    // postings are collected first and each account opens at its printed balance minus its subtree's postings
+    // (those the rules accept; the others are dropped), rounded to the cents printTree saves
+    struct LoadedAccount {
+        int number;
+        string_view description;    // Interned in `descriptions`, which addAccount then finds
+        double printedBalance;
+    };
+    struct LoadedPosting {
+        int accountNumber;
+        double amount;
+        char debitOrCredit;
+        int date;
+    };
+    vector<LoadedAccount> loadedAccounts;
+    vector<LoadedPosting> loadedPostings;
+    unordered_map<int, size_t> loadedIndex;    // Position in loadedAccounts by account number
+
+    // Buffers are reused across lines
+    string line, description, firstToken;
     int accountNumber = 0;
     double balance = 0.0;
     bool readingDescription = false;
+    uint64_t bytesRead = 0, linesRead = 0, parseErrors = 0;    // Loader counters, published once at the end
+
+    // Collects the account being read, unless the tree or the file already has it
+    auto collectAccount = [&]() {
+        if (accountMap.find(accountNumber) == accountMap.end() && loadedIndex.emplace(accountNumber,
+                                                                                      loadedAccounts.size()).second) {
+            loadedAccounts.push_back({accountNumber, descriptions.intern(cleanDescription(description)), balance});
+        }
+    };
 
     while (getline(file, line)) {
+        bytesRead += line.size() + 1;
+        ++linesRead;
         if (line.empty()) continue; // Skip empty lines
 
-        istringstream iss(line);
-        string firstToken;
-        iss >> firstToken;
+        // Locate the first whitespace-delimited token without a string stream
+        size_t tokenStart = line.find_first_not_of(" \t\r\n\v\f");
+        size_t tokenEnd = (tokenStart == string::npos) ? line.size() : line.find_first_of(" \t\r\n\v\f", tokenStart);
+        if (tokenEnd == string::npos) tokenEnd = line.size();
+        if (tokenStart == string::npos) {
+            firstToken.clear();
+        } else {
+            firstToken.assign(line, tokenStart, tokenEnd - tokenStart);
+        }
 
-        if (isdigit(firstToken[0])) { // Starts with a digit (account number)
+        if (!firstToken.empty() && isdigit(static_cast<unsigned char>(firstToken[0]))) { // Starts with a digit (account number)
             if (readingDescription) { // Finalize the previous account
-                description = cleanDescription(description);
-                try {
-                    if (accountMap.find(accountNumber) == accountMap.end()) {
-                        addAccount(accountNumber, description, balance);
-                    }
-                } catch (const exception &e) {
-                    cerr << "Error adding account " << accountNumber << ": " << e.what() << endl;
-                }
+                collectAccount();
                 description.clear();
             }
 
@@ -114,24 +189,28 @@ void ForestTree::buildFromFile(const string &filename) {
                 accountNumber = stoi(firstToken);
             } catch (const exception &) {
                 cerr << "Error parsing account number: " << line << endl;
+                ++parseErrors;
                 continue;
             }
 
-            // Extract the remaining line for description/balance
-            getline(iss, line);
-            size_t lastSpace = line.find_last_of(' ');
-
-            if (lastSpace != string::npos) {
-                string potentialBalance = line.substr(lastSpace + 1);
-                try {
-                    balance = stod(potentialBalance); // Parse balance
-                    description = line.substr(0, lastSpace);
-                } catch (const exception &) {
-                    description = line; // Treat entire line as description
+            // The remainder of the line holds the description and balance
+            string_view rest = string_view(line).substr(tokenEnd);
+            size_t lastSpace = rest.find_last_of(' ');
+
+            description.clear();
+            if (lastSpace != string_view::npos) {
+                const char *balanceText = rest.data() + lastSpace + 1;
+                char *parsedEnd = nullptr;
+                double parsed = strtod(balanceText, &parsedEnd);
+                if (parsedEnd != balanceText) { // Parse balance
+                    balance = parsed;
+                    description.assign(rest.data(), lastSpace);
+                } else {
+                    description.assign(rest.data(), rest.size()); // Treat entire line as description
                     balance = 0.0;
                 }
             } else {
-                description = line;
+                description.assign(rest.data(), rest.size());
                 balance = 0.0;
             }
 
@@ -143,13 +222,14 @@ void ForestTree::buildFromFile(const string &filename) {
                     size_t idPos = line.find("Transaction ID:");
                     size_t amountPos = line.find("Amount:");
                     size_t typePos = line.find("Type:");
+                    size_t datePos = line.find("Date:");
 
                     if (idPos != string::npos && amountPos != string::npos && typePos != string::npos) {
                         string idStr = line.substr(idPos + 14, amountPos - (idPos + 14));
                         idStr.erase(idStr.find_last_not_of(" ,:\n\r\t") + 1); // Trim trailing characters
                         idStr.erase(0, idStr.find_first_not_of(" ,:\n\r\t")); // Trim leading characters
 
-                        int transactionID = stoi(idStr); // Convert to integer
+                        stoi(idStr); // Validates the ID; postings are renumbered 1..n per account when stored
 
                         string amountStr = line.substr(amountPos + 7, typePos - (amountPos + 7));
                         amountStr.erase(amountStr.find_last_not_of(" \n\r\t") + 1); // Trim trailing spaces
@@ -157,8 +237,9 @@ void ForestTree::buildFromFile(const string &filename) {
 
                         double transactionAmount = stod(amountStr); // Convert to double
 
-                        string typeStr = line.substr(typePos + 5);
-                        typeStr.erase(typeStr.find_last_not_of(" \n\r\t") + 1); // Trim trailing spaces
+                        string typeStr = (datePos != string::npos) ? line.substr(typePos + 5, datePos - (typePos + 5))
+                                                                   : line.substr(typePos + 5);
+                        typeStr.erase(typeStr.find_last_not_of(" ,\n\r\t") + 1); // Trim trailing characters
                         typeStr.erase(0, typeStr.find_first_not_of(" \n\r\t")); // Trim leading spaces
 
                         char transactionType = (typeStr == "Debit") ? 'D' : (typeStr == "Credit" ? 'C' : '\0');
@@ -167,25 +248,29 @@ void ForestTree::buildFromFile(const string &filename) {
                             throw invalid_argument("Invalid transaction type: " + typeStr);
                         }
 
-                        // Ensure the account exists before adding the transaction
-                        Account *account = searchAccount(accountNumber);
-                        if (!account) {
-                            addAccount(accountNumber, description, 0);
-                            account = searchAccount(accountNumber);
+                        int transactionDate = 0;
+                        if (datePos != string::npos) {
+                            string dateStr = line.substr(datePos + 5);
+                            dateStr.erase(dateStr.find_last_not_of(" \n\r\t") + 1); // Trim trailing spaces
+                            dateStr.erase(0, dateStr.find_first_not_of(" \n\r\t")); // Trim leading spaces
+                            transactionDate = Transaction::parseDate(dateStr);
                         }
 
-                        // Add the transaction
-                        Transaction transaction(transactionAmount, transactionType);
-                        transaction.setTransactionID(transactionID);
-                        account->addTransaction(transaction.getAmount(), transaction.getDebitOrCredit());
+                        // The account line precedes its transactions; collect it before them
+                        collectAccount();
+                        loadedPostings.push_back({accountNumber, transactionAmount, transactionType, transactionDate});
                     } else {
                         cerr << "Malformed transaction line: " << line << endl;
+                        ++parseErrors;
                     }
                 } catch (const exception &e) {
                     cerr << "Error parsing transaction for account " << accountNumber << ": " << e.what() << endl;
+                    ++parseErrors;
                 }
 
                 if (!getline(file, line)) break; // Read the next line if available
+                bytesRead += line.size() + 1;
+                ++linesRead;
             }
 
             // Check if the next line starts a new account
@@ -193,26 +278,124 @@ void ForestTree::buildFromFile(const string &filename) {
                 continue; // Process the next account line in the main loop
             }
         } else if (readingDescription) { // Append additional description lines
-            description += " " + line;
+            description.append(1, ' ').append(line);
         }
     }
 
-    // Add the last account if still reading
+    // Collect the last account if still reading
     if (readingDescription) {
-        description = cleanDescription(description);
+        collectAccount();
+    }
+
+    // Postings the rules reject are dropped before the sums, so that no opening counts a posting never stored
+    size_t kept = 0;
+    for (const LoadedPosting &posting: loadedPostings) {
+        PostingRules::Verdict verdict = rules.checkNumber(posting.accountNumber, posting.amount,
+                                                          posting.debitOrCredit);
+        if (verdict != PostingRules::OK) {
+            cerr << "Error adding transaction to account " << posting.accountNumber << ": "
+                 << PostingRules::verdictMessage(verdict) << endl;
+            ++parseErrors;
+            continue;
+        }
+        loadedPostings[kept++] = posting;
+    }
+    loadedPostings.resize(kept);
+
+    // Signed postings of each loaded account's subtree: own postings, then children into parents (higher
+    // numbers first, as a parent's number is its child's without the last digit)
+    unordered_map<int, double> subtreePostings;
+    for (const LoadedPosting &posting: loadedPostings) {
+        subtreePostings[posting.accountNumber] += (posting.debitOrCredit == 'D') ? posting.amount : -posting.amount;
+    }
+    vector<int> numbers;
+    numbers.reserve(loadedAccounts.size());
+    for (const LoadedAccount &loaded: loadedAccounts) numbers.push_back(loaded.number);
+    sort(numbers.begin(), numbers.end(), greater<int>());
+    for (int number: numbers) {
+        int parentNumber = findParentNumber(number);
+        if (parentNumber > 0 && loadedIndex.count(parentNumber) && subtreePostings.count(number)) {
+            subtreePostings[parentNumber] += subtreePostings[number];
+        }
+    }
+
+    // Ascending numbers add every parent before its children, so each child links to it
+    for (auto number = numbers.rbegin(); number != numbers.rend(); ++number) {
+        const LoadedAccount &loaded = loadedAccounts[loadedIndex[*number]];
         try {
-            if (accountMap.find(accountNumber) == accountMap.end()) {
-                addAccount(accountNumber, description, balance);
-            }
+            auto sum = subtreePostings.find(loaded.number);
+            double opening = llround((loaded.printedBalance - ((sum == subtreePostings.end()) ? 0.0 : sum->second)) *
+                                     100.0) / 100.0;
+            addAccount(loaded.number, loaded.description, opening);
         } catch (const exception &e) {
-            cerr << "Error adding account " << accountNumber << ": " << e.what() << endl;
+            cerr << "Error adding account " << loaded.number << ": " << e.what() << endl;
+            ++parseErrors;
         }
     }
+    for (const LoadedPosting &posting: loadedPostings) {
+        try {
+            recordPosting(requireAccount(posting.accountNumber), posting.amount, posting.debitOrCredit, posting.date,
+                          false);
+        } catch (const exception &e) {
+            cerr << "Error adding transaction to account " << posting.accountNumber << ": " << e.what() << endl;
+            ++parseErrors;
+        }
+    }
+
+    // The opening and the postings give the printed balance up to floating-point rounding; store it exactly
+    for (const LoadedAccount &loaded: loadedAccounts) {
+        auto found = accountMap.find(loaded.number);
+        if (found != accountMap.end()) {
+            found->second->setBalance(loaded.printedBalance);
+        }
+    }
+
+    CHART_METRIC_ADD(Metrics::LOADER_BYTES, bytesRead);
+    CHART_METRIC_ADD(Metrics::LOADER_LINES, linesRead);
+    CHART_METRIC_ADD(Metrics::LOADER_PARSE_ERRORS, parseErrors);
 }
 
+// Loads a chart compiled into static data, with its accounts in one block
+void ForestTree::buildFromTable(const ChartTable &table) {
+    initialize();
+    if (table.count == 0) return;
+
+    baseAccounts = allocator<Account>().allocate(table.count);
+    baseAccountCount = table.count;
+    try {
+        for (size_t i = 0; i < table.count; ++i) {
+            const ChartTableEntry &entry = table.entries[i];
+            if (i > 0 && entry.accountNumber <= table.entries[i - 1].accountNumber) {
+                throw invalid_argument("Chart table is not ordered by account number at entry " + to_string(i));
+            }
+            if (entry.parentIndex >= static_cast<int>(i)) {
+                throw invalid_argument("Chart table parent of entry " + to_string(i) + " is not an earlier entry");
+            }
+
+            string_view description(table.descriptions + entry.descriptionOffset, entry.descriptionLength);
+            Account *account = new(baseAccounts + i) Account(entry.accountNumber, Account::StaticDescription{description},
+                                                             entry.balance, &postings);
+            if (entry.parentIndex >= 0) {
+                account->setParent(baseAccounts + entry.parentIndex);
+            }
+            rules.compileSlot(account->getSlot(), entry.accountNumber);
+            accountMap.emplace_hint(accountMap.end(), entry.accountNumber, account); // Ordered: O(1) insert
+        }
+        for (size_t i = table.count; i-- > 0;) {    // Children come after their parents
+            if (table.entries[i].parentIndex >= 0) {
+                baseAccounts[table.entries[i].parentIndex].adjustSubtreeHash(baseAccounts[i].getSubtreeHash());
+            }
+        }
+        descriptionIndexPending.store(true, memory_order_release); // Built by the first search
+    } catch (const exception &) {
+        initialize();
+        throw;
+    }
+}
 
 // Adds an account to the ForestTree
-void ForestTree::addAccount(int accountNumber, const string &description, double initialBalance) {
+void ForestTree::addAccount(int accountNumber, string_view description, double initialBalance) {
+    CHART_METRIC_SCOPE(Metrics::ADD_ACCOUNT);
     try {
 
         // Validate the account number range (1 to 5 digits)
@@ -226,7 +409,7 @@ void ForestTree::addAccount(int accountNumber, const string &description, double
         }
 
         // Create a new account
-        Account *newAccount = new Account(accountNumber, description, initialBalance);
+        Account *newAccount = new Account(accountNumber, description, initialBalance, &postings, &descriptions);
         int parentNumber = findParentNumber(accountNumber);
 
         // Set the parent account if it exists
@@ -234,8 +417,17 @@ void ForestTree::addAccount(int accountNumber, const string &description, double
             newAccount->setParent(accountMap[parentNumber]);
         }
 
-        // Add the new account to the map
+        // Add the new account to the map and the description index
         accountMap[accountNumber] = newAccount;
+        if (!descriptionIndexPending.load(memory_order_relaxed)) {
+            descriptionIndex.add(accountNumber, newAccount->getDescription());
+        }
+        rendered.erase(newAccount->getSlot()); // The slot may have belonged to a removed account
+        rules.compileSlot(newAccount->getSlot(), accountNumber);
+        for (Account *ancestor = newAccount->getParent(); ancestor; ancestor = ancestor->getParent()) {
+            ancestor->adjustSubtreeHash(newAccount->getSubtreeHash());
+        }
+        invalidateAggregates(newAccount);
     } catch (const exception &e) {
         // Catch any errors and rethrow to be handled in the calling function
         throw;
@@ -250,28 +442,231 @@ void ForestTree::removeAccount(int accountNumber) {
         throw invalid_argument("Account not found");
     }
 
-    delete it->second;
+    // The ancestors lose the subtree's postings, as they lose its hash below; its opening balance never reached them
+    Account *removed = it->second;
+    Account *parent = removed->getParent();
+    if (parent) {
+        double delta = removed->getOpeningBalance() - removed->getBalance();
+        map<int, double> datedDeltas;
+        for (const Account *member: selectAccounts(accountNumber, true)) {
+            for (auto transaction: member->getTransactions()) {
+                if (transaction->getDate() != 0) {
+                    double amount = transaction->getAmount();
+                    datedDeltas[transaction->getDate()] += (transaction->getDebitOrCredit() == 'D') ? -amount : amount;
+                }
+            }
+        }
+        for (Account *ancestor = parent; ancestor; ancestor = ancestor->getParent()) {
+            ancestor->updateBalance(delta);
+        }
+        for (const auto &dated: datedDeltas) {
+            recordPeriodDelta(parent, dated.first, dated.second);
+        }
+        invalidateRendering(parent, false);
+    }
+
+    // Detach direct children (numbered N*10..N*10+9) so no parent pointer dangles
+    for (auto child = accountMap.lower_bound(accountNumber * 10);
+         child != accountMap.end() && child->first <= accountNumber * 10 + 9; ++child) {
+        if (child->second->getParent() == removed) {
+            child->second->setParent(nullptr);
+        }
+    }
+
+    // The detached children take their own hashes with them; the ancestors lose the whole subtree
+    for (Account *ancestor = removed->getParent(); ancestor; ancestor = ancestor->getParent()) {
+        ancestor->adjustSubtreeHash(0 - removed->getSubtreeHash());
+    }
+
+    periodBalances.erase(accountNumber);
+    if (!descriptionIndexPending.load(memory_order_relaxed)) {
+        descriptionIndex.remove(accountNumber, removed->getDescription());
+    }
+    rendered.erase(removed->getSlot());
+    activity.remove(accountNumber);
+    invalidateAggregates(removed);
+    deleteTree(removed);
     accountMap.erase(it);
 }
 
 // Adds a transaction to an account
 void ForestTree::addTransaction(int accountNumber, const Transaction &transaction) {
+    emplaceTransaction(accountNumber, transaction.getAmount(), transaction.getDebitOrCredit(), transaction.getDate());
+}
+
+// Posts a transaction from its fields, straight into the account's posting columns
+void ForestTree::emplaceTransaction(int accountNumber, double amount, char debitOrCredit, int date) {
+    CHART_METRIC_SCOPE(Metrics::ADD_TRANSACTION);
     // Search for the account by its number
-    Account *account = searchAccount(accountNumber);
-    if (!account) {
-        throw invalid_argument("Account not found");
+    Account *account = requireAccount(accountNumber);
+
+    // The account validates the posting before anything is stored
+    recordPosting(account, amount, debitOrCredit, date);
+}
+
+// Reserves room for postings of an account
+void ForestTree::reservePostings(int accountNumber, size_t count) {
+    requireAccount(accountNumber)->reserveTransactions(count);
+}
+
+// Posts a balanced journal entry: validate everything, reserve room, then apply merged deltas
+void ForestTree::postEntry(const JournalEntry &entry) {
+    CHART_METRIC_SCOPE(Metrics::POST_ENTRY);
+    entry.validate();
+    const vector<JournalEntry::Leg> &legs = entry.getLegs();
+    int date = entry.getDate();
+
+    // Resolve every leg and merge its delta into its account and ancestors (entries are small,
+    // so a linear scan of the merged list beats hashing)
+    entryAccounts.clear();
+    entryDeltas.clear();
+    auto pendingDelta = [this](const Account *account) {
+        for (const auto &merged: entryDeltas) {
+            if (merged.first == account) return merged.second;
+        }
+        return 0.0;
+    };
+    for (const JournalEntry::Leg &leg: legs) {
+        Account *account = requireAccount(leg.accountNumber);
+        PostingRules::Verdict verdict = rules.check(account->getSlot(), leg.amount, leg.debitOrCredit,
+                                                    account->getBalance() + pendingDelta(account));
+        if (verdict != PostingRules::OK) {
+            throw invalid_argument(string(PostingRules::verdictMessage(verdict)) + " (account " +
+                                   to_string(leg.accountNumber) + ")");
+        }
+        double delta = (leg.debitOrCredit == 'D') ? leg.amount : -leg.amount;
+        for (Account *current = account; current; current = current->getParent()) {
+            auto merged = find_if(entryDeltas.begin(), entryDeltas.end(),
+                                  [current](const pair<Account *, double> &p) { return p.first == current; });
+            if (merged != entryDeltas.end()) {
+                merged->second += delta;
+            } else {
+                entryDeltas.emplace_back(current, delta);
+            }
+        }
+        entryAccounts.push_back(account);
+    }
+
+    // Everything that can allocate happens before the first change
+    for (size_t i = 0; i < legs.size(); ++i) {
+        size_t sameAccount = count(entryAccounts.begin() + i, entryAccounts.end(), entryAccounts[i]);
+        postings.reserveMore(entryAccounts[i]->getSlot(), sameAccount);
+    }
+    if (date != 0) {
+        size_t recorded = 0;
+        try {
+            for (; recorded < entryDeltas.size(); ++recorded) {
+                if (entryDeltas[recorded].second != 0.0) {
+                    periodBalances.record(entryDeltas[recorded].first->getAccountNumber(), date,
+                                          entryDeltas[recorded].second);
+                }
+            }
+        } catch (...) {
+            for (size_t i = 0; i < recorded; ++i) {      // Existing buckets: undoing allocates nothing
+                if (entryDeltas[i].second != 0.0) {
+                    periodBalances.record(entryDeltas[i].first->getAccountNumber(), date, -entryDeltas[i].second);
+                }
+            }
+            throw;
+        }
+    }
+
+    // Apply: store the legs (adding each hash term up its chain), then update each account and ancestor once
+    for (size_t i = 0; i < legs.size(); ++i) {
+        uint64_t term = entryAccounts[i]->appendTransaction(legs[i].amount, legs[i].debitOrCredit, date);
+        activity.record(entryAccounts[i]->getAccountNumber());
+        for (Account *current = entryAccounts[i]; current; current = current->getParent()) {
+            current->adjustSubtreeHash(term);
+        }
     }
+    for (const auto &merged: entryDeltas) {
+        merged.first->updateBalance(merged.second);
+        rendered.invalidateHeader(merged.first->getSlot());
+        queryCache.invalidate(merged.first->getSlot());
+    }
+}
+
+// Sets the posting rule of a subtree and recompiles the check table
+void ForestTree::setPostingRule(int subtree, const PostingRules::Rule &rule) {
+    rules.setRule(subtree, rule);
+    compileRules();
+}
 
-    // Delegate the transaction details to the account's addTransaction method
-    account->addTransaction(transaction.getAmount(), transaction.getDebitOrCredit());
+// Removes the posting rule of a subtree and recompiles the check table
+bool ForestTree::removePostingRule(int subtree) {
+    bool removed = rules.removeRule(subtree);
+    if (removed) compileRules();
+    return removed;
+}
+
+// Returns the posting rules
+const PostingRules &ForestTree::getPostingRules() const {
+    return rules;
+}
+
+// Compiles the rule of every account into its slot
+void ForestTree::compileRules() {
+    for (const auto &pair: accountMap) {
+        rules.compileSlot(pair.second->getSlot(), pair.first);
+    }
+}
+
+// Checks arrays of postings against the rules (every check but the balance floor)
+size_t ForestTree::validatePostings(const int *accountNumbers, const double *amounts, const char *debitOrCredit,
+                                    size_t n, int *slots, unsigned char *verdicts) const {
+    for (size_t i = 0; i < n; ++i) {
+        auto it = accountMap.find(accountNumbers[i]);
+        slots[i] = (it != accountMap.end()) ? it->second->getSlot() : -1;
+    }
+    return rules.checkBatch(slots, amounts, debitOrCredit, n, verdicts);
+}
+
+// Posts to an account and records dated movements along the ancestor chain
+void ForestTree::recordPosting(Account *account, double amount, char debitOrCredit, int date, bool enforceFloor) {
+    // The rules are checked before anything is stored
+    PostingRules::Verdict verdict = rules.check(account->getSlot(), amount, debitOrCredit, account->getBalance());
+    if (verdict != PostingRules::OK && (enforceFloor || verdict != PostingRules::BELOW_FLOOR)) {
+        throw invalid_argument(PostingRules::verdictMessage(verdict));
+    }
+    if (date != 0 && !Transaction::isValidDate(date)) {
+        throw invalid_argument("Invalid posting date: " + to_string(date) + ". Use YYYY-MM-DD.");
+    }
+    uint64_t term = account->appendTransaction(amount, debitOrCredit, date);
+    activity.record(account->getAccountNumber());
+    double adjustment = (debitOrCredit == 'D') ? amount : -amount;
+    for (Account *current = account; current; current = current->getParent()) {
+        current->updateBalance(adjustment);
+        current->adjustSubtreeHash(term);
+    }
+    invalidateRendering(account, false);
+    invalidateAggregates(account);
+    if (date != 0) {
+        recordPeriodDelta(account, date, (debitOrCredit == 'D') ? amount : -amount);
+    }
+}
+
+// Records a dated delta for an account and every ancestor
+void ForestTree::recordPeriodDelta(Account *account, int date, double delta) {
+    for (Account *current = account; current; current = current->getParent()) {
+        periodBalances.record(current->getAccountNumber(), date, delta);
+    }
 }
 
 
 // Removes a transaction from an account
 void ForestTree::removeTransaction(int accountNumber, int transactionID) {
-    Account *account = searchAccount(accountNumber);
-    if (!account) {
-        throw invalid_argument("Account not found");
+    CHART_METRIC_SCOPE(Metrics::REMOVE_TRANSACTION);
+    Account *account = requireAccount(accountNumber);
+
+    // Remember the dated movement before the transaction is deleted
+    int date = 0;
+    double delta = 0.0;
+    for (auto transaction: account->getTransactions()) {
+        if (transaction->getTransactionID() == transactionID) {
+            date = transaction->getDate();
+            delta = (transaction->getDebitOrCredit() == 'D') ? -transaction->getAmount() : transaction->getAmount();
+            break;
+        }
     }
 
     try {
@@ -279,58 +674,685 @@ void ForestTree::removeTransaction(int accountNumber, int transactionID) {
     } catch (const exception &e) {
         throw invalid_argument("Transaction not found for the given account.");
     }
+
+    invalidateRendering(account, true);
+    invalidateAggregates(account);
+    if (date != 0) {
+        recordPeriodDelta(account, date, delta);
+    }
+}
+
+// Removes the matching postings of an account or subtree, one compaction per account
+size_t ForestTree::removePostings(int accountNumber, const PostingFilter &filter, bool includeSubtree) {
+    vector<Account *> accounts = selectAccounts(accountNumber, includeSubtree);
+    NetDeltas net;
+    map<int, double> datedDeltas;
+    size_t removed = 0;
+    for (Account *account: accounts) {
+        double delta = 0.0;
+        datedDeltas.clear();
+        uint64_t removedHash = 0;
+        size_t count = account->removeTransactionsIf([&](PostingRef posting) {
+            if (!filter.matches(posting.getTransactionID(), posting.getAmount(), posting.getDebitOrCredit(),
+                                posting.getDate())) {
+                return false;
+            }
+            double reverse = (posting.getDebitOrCredit() == 'D') ? -posting.getAmount() : posting.getAmount();
+            delta += reverse;
+            removedHash += LedgerHash::postingTerm(account->getAccountNumber(), posting.getAmount(),
+                                                   posting.getDebitOrCredit(), posting.getDate());
+            if (posting.getDate() != 0) {
+                datedDeltas[posting.getDate()] += reverse;
+            }
+            return true;
+        });
+        if (count == 0) continue;
+
+        removed += count;
+        rendered.invalidateBody(account->getSlot());
+        mergeNetDelta(net, account, delta, 0 - removedHash);
+        for (const auto &dated: datedDeltas) {
+            mergeNetDatedDelta(net, account, dated.first, dated.second);
+        }
+    }
+    applyNetDeltas(net);
+    return removed;
+}
+
+// Posts offsetting entries for the matching postings of an account or subtree
+size_t ForestTree::reversePostings(int accountNumber, const PostingFilter &filter, bool includeSubtree,
+                                   int reversalDate) {
+    if (reversalDate != 0 && !Transaction::isValidDate(reversalDate)) {
+        throw invalid_argument("Invalid posting date: " + to_string(reversalDate) + ". Use YYYY-MM-DD.");
+    }
+    vector<Account *> accounts = selectAccounts(accountNumber, includeSubtree);
+
+    // Check every reversal against the rules as the balances would stand after the earlier ones
+    struct Reversal {
+        Account *account;
+        double amount;
+        char type;
+        int date;
+    };
+    vector<Reversal> reversals;
+    vector<size_t> perAccount(accounts.size(), 0);
+    NetDeltas net;
+    for (size_t a = 0; a < accounts.size(); ++a) {
+        Account *account = accounts[a];
+        for (auto posting: account->getTransactions()) {
+            if (!filter.matches(posting.getTransactionID(), posting.getAmount(), posting.getDebitOrCredit(),
+                                posting.getDate())) {
+                continue;
+            }
+            char type = (posting.getDebitOrCredit() == 'D') ? 'C' : 'D';
+            int date = reversalDate ? reversalDate : posting.getDate();
+            auto pending = net.balances.find(account);
+            double balance = account->getBalance() + (pending != net.balances.end() ? pending->second.balance : 0.0);
+            PostingRules::Verdict verdict = rules.check(account->getSlot(), posting.getAmount(), type, balance);
+            if (verdict != PostingRules::OK) {
+                throw invalid_argument(string(PostingRules::verdictMessage(verdict)) + " (account " +
+                                       to_string(account->getAccountNumber()) + ", transaction " +
+                                       to_string(posting.getTransactionID()) + ")");
+            }
+            double delta = (type == 'D') ? posting.getAmount() : -posting.getAmount();
+            mergeNetDelta(net, account, delta,
+                          LedgerHash::postingTerm(account->getAccountNumber(), posting.getAmount(), type, date));
+            if (date != 0) {
+                mergeNetDatedDelta(net, account, date, delta);
+            }
+            reversals.push_back({account, posting.getAmount(), type, date});
+            ++perAccount[a];
+        }
+    }
+
+    // Room for every reversal before the first is stored
+    for (size_t a = 0; a < accounts.size(); ++a) {
+        if (perAccount[a] > 0) postings.reserveMore(accounts[a]->getSlot(), perAccount[a]);
+    }
+    for (const Reversal &reversal: reversals) {
+        reversal.account->appendTransaction(reversal.amount, reversal.type, reversal.date);
+        activity.record(reversal.account->getAccountNumber());
+    }
+    applyNetDeltas(net);
+    return reversals.size();
+}
+
+// Adds a balance delta and hash term to an account and each ancestor of a bulk change
+void ForestTree::mergeNetDelta(NetDeltas &net, Account *account, double delta, uint64_t hashTerm) const {
+    for (Account *current = account; current; current = current->getParent()) {
+        NetDelta &merged = net.balances[current];
+        merged.balance += delta;
+        merged.hash += hashTerm;
+    }
+}
+
+// Adds a dated delta of an account to a bulk change
+void ForestTree::mergeNetDatedDelta(NetDeltas &net, Account *account, int date, double delta) const {
+    net.dated.push_back({account, date, delta});
+}
+
+// Applies a bulk change: each balance, period bucket and cache entry once
+void ForestTree::applyNetDeltas(const NetDeltas &net) {
+    for (const auto &balance: net.balances) {
+        balance.first->updateBalance(balance.second.balance);
+        balance.first->adjustSubtreeHash(balance.second.hash);
+        rendered.invalidateHeader(balance.first->getSlot());
+        queryCache.invalidate(balance.first->getSlot());
+    }
+    for (const DatedDelta &dated: net.dated) {
+        if (dated.delta == 0.0) continue;
+        for (Account *current = dated.account; current; current = current->getParent()) {
+            periodBalances.record(current->getAccountNumber(), dated.date, dated.delta);
+        }
+    }
+}
+
+// Marks the cached text of an account dirty, and the balance lines of its ancestors
+void ForestTree::invalidateRendering(Account *account, bool postingsChanged) {
+    if (postingsChanged) {
+        rendered.invalidateBody(account->getSlot());
+    }
+    for (Account *current = account; current; current = current->getParent()) {
+        rendered.invalidateHeader(current->getSlot());
+    }
+}
+
+// Makes the cached aggregates of an account and its ancestors stale
+void ForestTree::invalidateAggregates(Account *account) {
+    for (Account *current = account; current; current = current->getParent()) {
+        queryCache.invalidate(current->getSlot());
+    }
 }
 
 
 // Searches for an account by its number
 Account *ForestTree::searchAccount(int accountNumber) {
+    CHART_METRIC_SCOPE(Metrics::SEARCH_ACCOUNT);
     auto it = accountMap.find(accountNumber);
     return (it != accountMap.end()) ? it->second : nullptr;
 }
 
+// Returns every account, ordered by account number
+const map<int, Account *> &ForestTree::getAccountMap() const {
+    return accountMap;
+}
+
+// Returns the accounts whose parent is an account (0: the accounts with no parent)
+vector<Account *> ForestTree::getChildren(int accountNumber) const {
+    vector<Account *> children;
+    if (accountNumber == 0) {
+        for (const auto &pair: accountMap) {
+            if (!pair.second->getParent()) children.push_back(pair.second);
+        }
+        return children;
+    }
+    Account *account = requireAccount(accountNumber);
+    if (accountNumber <= 9999) {
+        for (auto it = accountMap.lower_bound(accountNumber * 10);
+             it != accountMap.end() && it->first <= accountNumber * 10 + 9; ++it) {
+            if (it->second->getParent() == account) children.push_back(it->second);
+        }
+    }
+    return children;
+}
+
+// Returns the sum of the top-level accounts' subtree hashes
+uint64_t ForestTree::getTreeHash() const {
+    uint64_t hash = 0;
+    for (const auto &pair: accountMap) {
+        if (!pair.second->getParent()) hash += pair.second->getSubtreeHash();
+    }
+    return hash;
+}
+
+// Recomputes the subtree hashes bottom-up and compares them with the maintained ones
+bool ForestTree::verifyHashes(vector<int> *mismatched) const {
+    unordered_map<const Account *, uint64_t> expected;
+    expected.reserve(accountMap.size());
+    bool match = true;
+    for (auto it = accountMap.rbegin(); it != accountMap.rend(); ++it) {    // Children before parents
+        const Account *account = it->second;
+        uint64_t &hash = expected[account];
+        hash += LedgerHash::accountTerm(account->getAccountNumber(), account->getDescription(),
+                                        account->getOpeningBalance()) + account->postingsHash();
+        if (hash != account->getSubtreeHash()) {
+            match = false;
+            if (mismatched) mismatched->push_back(account->getAccountNumber());
+        }
+        if (account->getParent()) {
+            expected[account->getParent()] += hash;
+        }
+    }
+    return match;
+}
+
+// Recomputes every balance from the postings: own sums in parallel, then one parallel pass per level
+size_t ForestTree::recomputeBalances(vector<BalanceMismatch> *mismatches, unsigned threads) {
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+
+    // Number order puts every parent before its children, so depths are known when a child is reached
+    const size_t NONE = SIZE_MAX;
+    size_t count = accountMap.size();
+    vector<Account *> accounts;
+    vector<size_t> parents;
+    vector<vector<size_t>> levels;
+    unordered_map<const Account *, size_t> indexOf;
+    vector<size_t> depths(count);
+    accounts.reserve(count);
+    parents.reserve(count);
+    indexOf.reserve(count);
+    for (const auto &pair: accountMap) {
+        size_t index = accounts.size();
+        size_t parent = pair.second->getParent() ? indexOf.at(pair.second->getParent()) : NONE;
+        depths[index] = (parent == NONE) ? 0 : depths[parent] + 1;
+        if (depths[index] == levels.size()) levels.emplace_back();
+        levels[depths[index]].push_back(index);
+        indexOf[pair.second] = index;
+        accounts.push_back(pair.second);
+        parents.push_back(parent);
+    }
+
+    // Children of account i are children[childStart[i] .. childStart[i + 1]), in number order
+    vector<size_t> childStart(count + 1, 0), children(count);
+    for (size_t parent: parents) {
+        if (parent != NONE) ++childStart[parent + 1];
+    }
+    for (size_t i = 0; i < count; ++i) childStart[i + 1] += childStart[i];
+    vector<size_t> next(childStart.begin(), childStart.end() - 1);
+    for (size_t i = 0; i < count; ++i) {
+        if (parents[i] != NONE) children[next[parents[i]]++] = i;
+    }
+
+    vector<double> totals(count);
+    parallelFor(count, threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            PostingView view = accounts[i]->getTransactions();
+            totals[i] = PostingKernels::signedSum(view.amounts(), view.credits(), view.size());
+        }
+    });
+    for (size_t level = levels.size(); level-- > 0;) {
+        const vector<size_t> &members = levels[level];
+        parallelFor(members.size(), threads, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                size_t i = members[k];
+                for (size_t child = childStart[i]; child < childStart[i + 1]; ++child) {
+                    totals[i] += totals[children[child]];
+                }
+            }
+        });
+    }
+
+    size_t mismatchCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        Account *account = accounts[i];
+        double stored = account->getBalance();
+        double recomputed = account->getOpeningBalance() + totals[i];
+        if (recomputed == stored) continue;
+        if (llround(stored * 100) != llround(recomputed * 100)) {
+            ++mismatchCount;
+            if (mismatches) mismatches->push_back({account->getAccountNumber(), stored, recomputed});
+        }
+        account->setBalance(recomputed);
+        rendered.invalidateHeader(account->getSlot());
+        queryCache.invalidate(account->getSlot());
+    }
+    return mismatchCount;
+}
+
 // Prints the entire ForestTree to a file
 void ForestTree::printTree(const string &filename) {
     ofstream file(filename);
     if (!file.is_open()) {
         throw runtime_error("Could not open file for writing: " + filename);
     }
+    printTree(file);
+}
 
+// Prints the entire ForestTree to a stream
+void ForestTree::printTree(ostream &out) {
+    CHART_METRIC_SCOPE(Metrics::PRINT_TREE);
     for (const auto &pair: accountMap) {
         if (!pair.second->getParent()) {
-            printTreeRecursive(pair.second, file, 0);
+            printTreeRecursive(pair.second, out, 0);
         }
     }
 }
 
-void ForestTree::printTreeRecursive(Account *account, ofstream &file, int indent) {
+void ForestTree::printTreeRecursive(Account *account, ostream &out, int indent) {
     if (!account) return;
 
-    // Print account details with indentation
-    file << string(indent * 2, ' ')
-         << account->getAccountNumber() << " "
-         << setw(30) << left << account->getDescription() << " "
-         << fixed << setprecision(2) << account->getBalance() << "\n";
+    // Account line and transactions, from the cache where unchanged
+    rendered.write(account, indent, out);
 
-    // Print transactions for this account
-    for (const Transaction *transaction: account->getTransactions()) {
-        file << string((indent + 1) * 2, ' ')  // Indent transactions more than account
-             << "Transaction ID: " << transaction->getTransactionID() << ", "
-             << "Amount: " << transaction->getAmount() << ", "
-             << "Type: " << (transaction->getDebitOrCredit() == 'D' ? "Debit" : "Credit") << "\n";
+    // Recursively print child accounts (numbered N*10..N*10+9)
+    int firstChild = account->getAccountNumber() * 10;
+    for (auto child = accountMap.lower_bound(firstChild);
+         child != accountMap.end() && child->first <= firstChild + 9; ++child) {
+        if (child->second->getParent() == account) {
+            printTreeRecursive(child->second, out, indent + 1);
+        }
     }
+}
 
-    // Add a blank line after transactions for better readability
-    if (!account->getTransactions().empty()) {
-        file << "\n";
+// Returns an account's balance at the end of the period containing the date
+double ForestTree::balanceAt(int accountNumber, int date) {
+    Account *account = requireAccount(accountNumber);
+
+    // Later dated movements are backed out of the current balance
+    double later = periodBalances.totalMovement(accountNumber) - periodBalances.movementThrough(accountNumber, date);
+    return account->getBalance() - later;
+}
+
+// Returns an account's dated movement between two dates (inclusive)
+double ForestTree::periodMovement(int accountNumber, int fromDate, int toDate) {
+    requireAccount(accountNumber);
+    return periodBalances.movementBetween(accountNumber, fromDate, toDate);
+}
+
+// Switches period granularity and rebuilds every series from the postings
+void ForestTree::setPeriodGranularity(PeriodBalances::Granularity granularity) {
+    periodBalances = PeriodBalances(granularity);
+    queryCache.clear(); // Dated balances depend on the granularity
+    for (const auto &pair: accountMap) {
+        for (auto transaction: pair.second->getTransactions()) {
+            if (transaction->getDate() != 0) {
+                double delta = (transaction->getDebitOrCredit() == 'D') ? transaction->getAmount()
+                                                                        : -transaction->getAmount();
+                recordPeriodDelta(pair.second, transaction->getDate(), delta);
+            }
+        }
     }
+}
+
+// Collects an account and all of its descendants
+void ForestTree::collectSubtree(Account *account, vector<Account *> &out) const {
+    out.push_back(account);
+    long long number = account->getAccountNumber();
+    for (long long scale = 10; number * scale <= 99999; scale *= 10) {
+        long long first = number * scale, last = first + scale - 1;
+        for (auto it = accountMap.lower_bound(static_cast<int>(first));
+             it != accountMap.end() && it->first <= last; ++it) {
+            // A missing intermediate account leaves the candidate without this ancestor
+            for (Account *ancestor = it->second->getParent(); ancestor; ancestor = ancestor->getParent()) {
+                if (ancestor == account) {
+                    out.push_back(it->second);
+                    break;
+                }
+            }
+        }
+    }
+}
 
-    // Recursively print child accounts
+// Looks up an account or throws if it does not exist
+Account *ForestTree::requireAccount(int accountNumber) const {
+    auto it = accountMap.find(accountNumber);
+    if (it == accountMap.end()) {
+        throw invalid_argument("Account not found");
+    }
+    return it->second;
+}
+
+// Returns an account alone, or the account followed by its descendants
+vector<Account *> ForestTree::selectAccounts(int accountNumber, bool includeSubtree) const {
+    vector<Account *> accounts;
+    Account *account = requireAccount(accountNumber);
+    if (includeSubtree) {
+        collectSubtree(account, accounts);
+    } else {
+        accounts.push_back(account);
+    }
+    return accounts;
+}
+
+// Returns debits minus credits over an account's (or subtree's) postings
+double ForestTree::postingSignedSum(int accountNumber, bool includeSubtree) {
+    vector<Account *> accounts = selectAccounts(accountNumber, includeSubtree);
+
+    double sum = 0.0;
+    for (const Account *current: accounts) {
+        PostingView view = current->getTransactions();
+        sum += PostingKernels::signedSum(view.amounts(), view.credits(), view.size());
+    }
+    return sum;
+}
+
+// Returns the sum of postings of a type at or above a minimum amount
+double ForestTree::postingFilteredSum(int accountNumber, char debitOrCredit, double minAmount, bool includeSubtree) {
+    int typeFilter = (debitOrCredit == 'D') ? PostingKernels::DEBIT_ONLY
+                     : (debitOrCredit == 'C') ? PostingKernels::CREDIT_ONLY : PostingKernels::ANY_TYPE;
+
+    vector<Account *> accounts = selectAccounts(accountNumber, includeSubtree);
+
+    double sum = 0.0;
+    for (const Account *current: accounts) {
+        PostingView view = current->getTransactions();
+        sum += PostingKernels::filteredSum(view.amounts(), view.credits(), view.size(), typeFilter, minAmount);
+    }
+    return sum;
+}
+
+// Returns the number of postings above a threshold
+size_t ForestTree::countPostingsAbove(int accountNumber, double threshold, bool includeSubtree) {
+    vector<Account *> accounts = selectAccounts(accountNumber, includeSubtree);
+
+    size_t count = 0;
+    for (const Account *current: accounts) {
+        PostingView view = current->getTransactions();
+        count += PostingKernels::countAbove(view.amounts(), view.size(), threshold);
+    }
+    return count;
+}
+
+// Computes the smallest and largest posting amount
+bool ForestTree::postingRange(int accountNumber, bool includeSubtree, double &minAmount, double &maxAmount) {
+    vector<Account *> accounts = selectAccounts(accountNumber, includeSubtree);
+
+    bool found = false;
+    for (const Account *current: accounts) {
+        double lo, hi;
+        PostingView view = current->getTransactions();
+        if (PostingKernels::minMax(view.amounts(), view.size(), lo, hi)) {
+            minAmount = found ? min(minAmount, lo) : lo;
+            maxAmount = found ? max(maxAmount, hi) : hi;
+            found = true;
+        }
+    }
+    return found;
+}
+
+// Returns the ledger-wide columnar posting store
+const PostingStore &ForestTree::getPostingStore() const {
+    return postings;
+}
+
+// Builds the description index deferred by buildFromTable
+void ForestTree::ensureDescriptionIndex() {
+    if (!descriptionIndexPending.load(memory_order_acquire)) return;
+    lock_guard<mutex> guard(descriptionIndexLock);
+    if (!descriptionIndexPending.load(memory_order_relaxed)) return;
+    descriptionIndex.clear();
+    for (const auto &pair: accountMap) {
+        descriptionIndex.add(pair.first, pair.second->getDescription());
+    }
+    descriptionIndexPending.store(false, memory_order_release);
+}
+
+// Returns accounts whose descriptions match every query word, best first
+vector<Account *> ForestTree::searchByDescription(const string &query, size_t limit) {
+    ensureDescriptionIndex();
+    vector<Account *> results;
+    for (const DescriptionIndex::Match &match: descriptionIndex.search(query, limit)) {
+        results.push_back(accountMap.at(match.accountNumber));
+    }
+    return results;
+}
+
+// Returns a subtree aggregate, from the cache when the subtree is unchanged
+double ForestTree::subtreeAggregate(int accountNumber, QueryCache::Metric metric, int fromDate, int toDate) {
+    if (metric < 0 || metric >= QueryCache::METRIC_COUNT) {
+        throw invalid_argument("Invalid aggregate metric");
+    }
+    if (fromDate > toDate) {
+        throw invalid_argument("Start date is after end date");
+    }
+    Account *account = requireAccount(accountNumber);
+
+    double value;
+    if (!queryCache.lookup(accountNumber, account->getSlot(), metric, fromDate, toDate, value)) {
+        value = computeAggregate(account, metric, fromDate, toDate);
+        queryCache.store(accountNumber, account->getSlot(), metric, fromDate, toDate, value);
+    }
+    return value;
+}
+
+// Computes a subtree aggregate by scanning the subtree's posting columns
+double ForestTree::computeAggregate(Account *account, QueryCache::Metric metric, int fromDate, int toDate) const {
+    int accountNumber = account->getAccountNumber();
+    if (metric == QueryCache::BALANCE) {
+        if (toDate == 0) {
+            return account->getBalance();
+        }
+        double later = periodBalances.totalMovement(accountNumber) - periodBalances.movementThrough(accountNumber, toDate);
+        return account->getBalance() - later;
+    }
+
+    vector<Account *> accounts;
+    collectSubtree(account, accounts);
+
+    bool allTime = (fromDate == 0 && toDate == 0);
+    double debits = 0.0, credits = 0.0, count = 0.0;
+    for (const Account *current: accounts) {
+        PostingView view = current->getTransactions();
+        if (allTime) {
+            debits += PostingKernels::filteredSum(view.amounts(), view.credits(), view.size(),
+                                                  PostingKernels::DEBIT_ONLY, 0.0);
+            credits += PostingKernels::filteredSum(view.amounts(), view.credits(), view.size(),
+                                                   PostingKernels::CREDIT_ONLY, 0.0);
+            count += static_cast<double>(view.size());
+            continue;
+        }
+        const double *amounts = view.amounts();
+        const unsigned char *isCredit = view.credits();
+        const int *dates = view.dates();
+        for (size_t i = 0; i < view.size(); ++i) {
+            if (dates[i] == 0 || dates[i] < fromDate || dates[i] > toDate) continue;
+            (isCredit[i] ? credits : debits) += amounts[i];
+            count += 1.0;
+        }
+    }
+
+    switch (metric) {
+        case QueryCache::DEBITS: return debits;
+        case QueryCache::CREDITS: return credits;
+        case QueryCache::TURNOVER: return debits + credits;
+        default: return count;
+    }
+}
+
+// Returns the query cache statistics
+QueryCache::Stats ForestTree::getQueryCacheStats() const {
+    return queryCache.getStats();
+}
+
+// Returns the k accounts with the largest balances, of the ledger or of a subtree
+vector<Account *> ForestTree::topBalances(size_t k, int accountNumber) const {
+    vector<Account *> accounts;
+    if (accountNumber == 0) {
+        accounts.reserve(accountMap.size());
+        for (const auto &pair: accountMap) accounts.push_back(pair.second);
+    } else {
+        accounts = selectAccounts(accountNumber, true);
+    }
+    auto larger = [](const Account *a, const Account *b) {
+        return a->getBalance() > b->getBalance() ||
+               (a->getBalance() == b->getBalance() && a->getAccountNumber() < b->getAccountNumber());
+    };
+    size_t count = min(k, accounts.size());
+    partial_sort(accounts.begin(), accounts.begin() + static_cast<ptrdiff_t>(count), accounts.end(), larger);
+    accounts.resize(count);
+    return accounts;
+}
+
+// Returns the k largest postings matching a filter, of the ledger or of an account (or subtree)
+vector<ForestTree::RankedPosting> ForestTree::topPostings(size_t k, int accountNumber, const PostingFilter &filter,
+                                                          bool includeSubtree) const {
+    vector<RankedPosting> heap; // Bounded heap whose front is the smallest posting kept
+    if (k == 0) return heap;
+    heap.reserve(k);
+    auto larger = [](const RankedPosting &a, const RankedPosting &b) {
+        return a.amount > b.amount || (a.amount == b.amount && (a.accountNumber < b.accountNumber ||
+               (a.accountNumber == b.accountNumber && a.transactionID < b.transactionID)));
+    };
+    // Offers one posting: the amount is checked against the smallest kept before the filter is
+    auto offer = [&](int account, int id, double amount, unsigned char credit, int date) {
+        if (heap.size() == k && amount < heap.front().amount) return;
+        char type = credit ? 'C' : 'D';
+        if (!filter.matches(id, amount, type, date)) return;
+        RankedPosting posting{account, id, amount, type, date};
+        if (heap.size() < k) {
+            heap.push_back(posting);
+            push_heap(heap.begin(), heap.end(), larger);
+        } else if (larger(posting, heap.front())) {
+            pop_heap(heap.begin(), heap.end(), larger);
+            heap.back() = posting;
+            push_heap(heap.begin(), heap.end(), larger);
+        }
+    };
+
+    if (accountNumber == 0) {
+        // One pass over the columns; slack positions have no account
+        const vector<int> &accounts = postings.getAccountColumn();
+        const vector<int> &ids = postings.getIdColumn();
+        const vector<double> &amounts = postings.getAmountColumn();
+        const vector<unsigned char> &credits = postings.getCreditColumn();
+        const vector<int> &dates = postings.getDateColumn();
+        for (size_t i = 0; i < accounts.size(); ++i) {
+            if (accounts[i] != 0) offer(accounts[i], ids[i], amounts[i], credits[i], dates[i]);
+        }
+    } else {
+        for (const Account *account: selectAccounts(accountNumber, includeSubtree)) {
+            PostingView view = account->getTransactions();
+            for (size_t i = 0; i < view.size(); ++i) {
+                offer(account->getAccountNumber(), view.ids()[i], view.amounts()[i], view.credits()[i],
+                      view.dates()[i]);
+            }
+        }
+    }
+    sort_heap(heap.begin(), heap.end(), larger);
+    return heap;
+}
+
+// Returns the sketch of posting activity by account
+const ActivitySketch &ForestTree::getActivitySketch() const {
+    return activity;
+}
+
+// Returns the heap bytes held by the tree, by category
+ForestTree::MemoryStats ForestTree::memoryStats() const {
+    MemoryStats stats{};
+    size_t liveBaseAccounts = 0;
     for (const auto &pair: accountMap) {
-        if (pair.second->getParent() == account) {
-            printTreeRecursive(pair.second, file, indent + 1);
+        const Account *account = pair.second;
+        if (baseAccounts && account >= baseAccounts && account < baseAccounts + baseAccountCount) {
+            ++liveBaseAccounts;
+            stats.accounts += sizeof(Account);
+        } else {
+            stats.accounts += MemoryUsage::heapBlock(sizeof(Account));
         }
     }
+    stats.accounts += MemoryUsage::treeBytes(accountMap);
+    stats.accountCount = accountMap.size();
+
+    size_t poolSlack = descriptions.bytesReserved() - descriptions.bytesUsed();
+    stats.descriptions = descriptions.memoryBytes() - poolSlack;
+
+    stats.postings = postings.bytesUsed();
+    stats.postingCount = postings.postingCount();
+
+    stats.indexes = periodBalances.memoryBytes() + queryCache.memoryBytes() + rules.memoryBytes() +
+                    rendered.memoryBytes() + activity.memoryBytes() + MemoryUsage::vectorBytes(entryAccounts) +
+                    MemoryUsage::vectorBytes(entryDeltas);
+    if (!descriptionIndexPending.load(memory_order_acquire)) {
+        stats.indexes += descriptionIndex.memoryBytes();
+    }
+
+    stats.slack = (postings.bytesReserved() - postings.bytesUsed()) + poolSlack +
+                  (baseAccountCount - liveBaseAccounts) * sizeof(Account);
+    return stats;
 }
 
+// Compacts postings, descriptions, indexes and caches; returns the bytes released
+size_t ForestTree::compact() {
+    size_t before = memoryStats().total();
 
+    postings.compact();
 
+    StringPool compacted;
+    bool baseBlockUsed = false;
+    for (const auto &pair: accountMap) {
+        Account *account = pair.second;
+        if (descriptions.owns(account->getDescription())) {
+            account->relocateDescription(compacted.intern(account->getDescription()));
+        }
+        baseBlockUsed = baseBlockUsed ||
+                        (baseAccounts && account >= baseAccounts && account < baseAccounts + baseAccountCount);
+    }
+    descriptions.swap(compacted); // The old pool, now in `compacted`, is freed on return
+
+    if (!descriptionIndexPending.load(memory_order_acquire)) {
+        descriptionIndex.compact();
+    }
+    periodBalances.compact();
+    queryCache.compact();
+    rendered.compact();
+    entryAccounts.clear();
+    entryAccounts.shrink_to_fit();
+    entryDeltas.clear();
+    entryDeltas.shrink_to_fit();
+    if (!baseBlockUsed) {
+        releaseBaseAccounts();
+    }
+
+    size_t after = memoryStats().total();
+    return before > after ? before - after : 0;
+}
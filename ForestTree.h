@@ -10,37 +10,170 @@
     Destructor:          Cleans up memory used by the tree and its accounts.
     initialize:          Clears the tree, removing all accounts and transactions.
     buildFromFile:       Builds the ForestTree structure by reading from a file.
+    buildFromTable:      Loads a chart compiled into static data (ChartTable.h).
     addAccount:          Adds a new account to the tree.
     removeAccount:       Removes an account from the tree by its number.
     addTransaction:      Adds a transaction to a specific account.
+    emplaceTransaction:  Posts a transaction from its fields, with no Transaction object.
+    reservePostings:     Reserves room for postings of an account.
+    postEntry:           Posts a balanced JournalEntry atomically, updating each
+                         shared ancestor once with the net delta.
+    setPostingRule / removePostingRule / getPostingRules:
+                         Configure the posting validation rules by subtree.
+    validatePostings:    Checks arrays of postings against the rules.
     removeTransaction:   Removes a transaction from a specific account by ID.
+    removePostings / reversePostings:
+                         Remove or reverse every posting of an account (or
+                         subtree) matching a PostingFilter, in one pass.
     searchAccount:       Searches for an account in the tree by its number.
-    printTree:           Prints the entire tree structure to a file.
+    getAccountMap:       Returns every account, ordered by account number.
+    getChildren:         Returns the accounts whose parent is an account (or the
+                         top-level accounts), to descend by subtree hash.
+    getTreeHash:         Returns the hash of the whole ledger.
+    verifyHashes:        Recomputes every subtree hash and reports mismatches.
+    recomputeBalances:   Recomputes every balance from the postings in parallel,
+                         level by level, and reports the ones that were off.
+    printTree:           Prints the entire tree structure to a file or stream,
+                         re-rendering only accounts changed since the last print.
+    balanceAt:           Returns an account's (subtree) balance at the end of a date.
+    periodMovement:      Returns an account's (subtree) dated movement between two dates.
+    setPeriodGranularity: Selects day or month buckets for dated balances.
+    postingSignedSum:    Debits minus credits of an account or subtree's postings.
+    postingFilteredSum:  Sum of postings of a type at or above a minimum amount.
+    countPostingsAbove:  Number of postings above a threshold.
+    postingRange:        Smallest and largest posting amount.
+    getPostingStore:     Returns the ledger-wide columnar posting store.
+    searchByDescription: Ranked word/prefix search over account descriptions.
+    subtreeAggregate:    Cached balance, debits, credits, turnover or posting
+                         count of a subtree over a period.
+    getQueryCacheStats:  Hits, misses and invalidations of the aggregate cache.
+    topBalances / topPostings:
+                         The k largest balances or postings of the ledger or a subtree.
+    getActivitySketch:   Heavy hitters of posting activity by account (ActivitySketch).
+    memoryStats:         Bytes held by accounts, descriptions, postings, indexes and slack.
+    compact:             Returns the memory left unused by removals to the allocator.
 
   Helper functions:
     deleteTree:          Recursively deletes an account and its resources.
+    releaseBaseAccounts: Frees the block of accounts loaded from a chart table.
+    ensureDescriptionIndex: Builds the description index deferred by buildFromTable.
     findParentNumber:    Determines the parent account number based on the current account number.
     cleanDescription:    Cleans and formats account descriptions.
-    printTreeRecursive:  Recursively prints the ForestTree structure to a file.
+    printTreeRecursive:  Recursively prints the ForestTree structure to a stream.
+    invalidateRendering: Marks the cached text of an account and its ancestors dirty.
+    invalidateAggregates: Makes the cached aggregates of an account and its ancestors stale.
+    computeAggregate:    Computes a subtree aggregate without the cache.
+    recordPosting:       Posts to an account and records the dated movement
+                         for the account and its ancestors.
+    recordPeriodDelta:   Records a dated delta for an account and its ancestors.
+    collectSubtree:      Collects an account and all of its descendants.
+    requireAccount:      Looks up an account or throws if it does not exist.
+    compileRules:        Compiles the posting rule of every account.
+    mergeNetDelta / mergeNetDatedDelta / applyNetDeltas:
+                         Merge the balance deltas of a bulk change over the
+                         ancestors and apply each once, with its dated deltas.
+    selectAccounts:      Returns an account alone or together with its descendants.
 
   Class Invariant:
     1. The `root` pointer is null if the tree is empty or points to the root of the account hierarchy.
     2. The `accountMap` provides a quick lookup for accounts using their unique numbers.
     3. Each account can contain multiple transactions and may optionally have a parent account.
+    4. `periodBalances` holds, for every account, the dated movements of its whole subtree.
+    5. Every account's transactions live in its slot of `postings`.
+    6. `descriptionIndex` indexes the description of every account in `accountMap`,
+       unless `descriptionIndexPending` is set (it is then rebuilt on first search).
+    7. Account descriptions are interned once per distinct string in `descriptions`,
+       except those of table accounts, which view the table's static data.
+    8. `rendered` holds up-to-date text for every account not marked dirty;
+       every change to balances or postings goes through this class.
+    9. `queryCache` serves an aggregate only if no posting in the account's
+       subtree changed since it was computed.
+    10. Accounts loaded by buildFromTable live in the `baseAccounts` block;
+        deleteTree destroys them in place instead of deleting them. The
+        block is freed by initialize, or by compact once none is left.
+    11. `entryAccounts` and `entryDeltas` are scratch space of postEntry,
+        cleared at the start of every call (kept only for their capacity).
+    12. `rules` holds the compiled rule of every account's slot; every
+        posting is checked against it before it is stored.
+    13. Every account's subtree hash (Account invariant 8) covers exactly
+        the accounts below it by parent pointer; every change to accounts,
+        parents or postings adjusts the hashes on its ancestor chain.
+    14. `activity` has counted every posting stored since the tree was
+        initialized (removed postings are not uncounted) and tracks no
+        removed account.
 --------------------------------------------------------------------------**/
 
 #include <iostream>
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <vector>
+#include <atomic>
+#include <mutex>
 #include "Account.h"
 #include "Transaction.h"
+#include "PeriodBalances.h"
+#include "PostingStore.h"
+#include "DescriptionIndex.h"
+#include "StringPool.h"
+#include "RenderCache.h"
+#include "QueryCache.h"
+#include "ChartTable.h"
+#include "JournalEntry.h"
+#include "PostingRules.h"
+#include "PostingFilter.h"
+#include "ActivitySketch.h"
 
 using namespace std;
 
 class ForestTree {
+public:
+    // Heap bytes held by the tree, by category (estimates, see MemoryUsage.h)
+    struct MemoryStats {
+        size_t accounts;       // Account objects and the account map
+        size_t descriptions;   // Pooled description text and its lookup set
+        size_t postings;       // Live postings in every column and their slot table
+        size_t indexes;        // Description index, period balances, caches, rules, scratch
+        size_t slack;          // Reserved but unused: spare posting columns, pool tail, dead table accounts
+        size_t accountCount;
+        size_t postingCount;
+
+        size_t total() const { return accounts + descriptions + postings + indexes + slack; }
+    };
+
+    // A posting ranked by topPostings
+    struct RankedPosting {
+        int accountNumber;
+        int transactionID;
+        double amount;
+        char debitOrCredit;
+        int date;                // YYYYMMDD, 0 if undated
+    };
+
+    // An account whose stored balance differed from the one recomputed from its postings
+    struct BalanceMismatch {
+        int accountNumber;
+        double stored;
+        double recomputed;
+    };
+
 private:
+    PostingStore postings;          // Ledger-wide columnar storage of every account's transactions
+    StringPool descriptions;        // Arena of interned account descriptions
     Account *root; // Root of the tree (or null if the tree is empty)
     map<int, Account *> accountMap; // Map for quick account lookup by account number
+    PeriodBalances periodBalances;  // Per-account dated movements bucketed by period
+    DescriptionIndex descriptionIndex; // Inverted index over account descriptions
+    atomic<bool> descriptionIndexPending; // Index not yet built for a table-loaded chart
+    mutex descriptionIndexLock;     // Serializes the deferred build between concurrent searches
+    RenderCache rendered;           // printTree text of every account, re-rendered when dirty
+    QueryCache queryCache;          // Versioned subtree aggregates keyed by (account, metric, period)
+    Account *baseAccounts;          // One block holding the accounts of a chart table (or null)
+    size_t baseAccountCount;        // Accounts in the block
+    PostingRules rules;             // Posting validation rules, compiled per slot
+    vector<Account *> entryAccounts;                // postEntry scratch: account of each leg
+    vector<pair<Account *, double>> entryDeltas;    // postEntry scratch: net delta per account/ancestor
+    ActivitySketch activity;        // Most frequently posted-to accounts (Space-Saving)
 
     /***** Helper Functions *****/
     /*------------------------------------------------------------------------
@@ -51,6 +184,23 @@ private:
     -----------------------------------------------------------------------*/
     void deleteTree(Account *node);
 
+    /*------------------------------------------------------------------------
+      Frees the block of accounts loaded by buildFromTable.
+
+      Precondition:  Every account of the block has been destroyed.
+      Post-condition: baseAccounts is null.
+    -----------------------------------------------------------------------*/
+    void releaseBaseAccounts();
+
+    /*------------------------------------------------------------------------
+      Builds the description index of every account if buildFromTable
+      deferred it. Safe to call from concurrent readers of the tree.
+
+      Precondition:  No concurrent writer.
+      Post-condition: descriptionIndex indexes every account in accountMap.
+    -----------------------------------------------------------------------*/
+    void ensureDescriptionIndex();
+
     /*------------------------------------------------------------------------
       Determines the parent account number based on the current account number.
 
@@ -63,18 +213,137 @@ private:
       Cleans and formats an account description by removing unnecessary
       characters and trimming leading or trailing whitespace.
 
-      Precondition:  A valid string reference is provided.
-      Post-condition: Returns the cleaned and formatted string.
+      Precondition:  A valid string view is provided.
+      Post-condition: Returns the cleaned view (a sub-range of the input).
+    -----------------------------------------------------------------------*/
+    string_view cleanDescription(string_view desc) const;
+
+    /*------------------------------------------------------------------------
+      Recursively writes an account and its sub-accounts to a stream. The
+      children of account N are the accounts numbered N*10..N*10+9 whose
+      parent is N, so only that key range is visited.
+
+      Precondition:  A valid account pointer, stream, and indentation level are provided.
+      Post-condition: The subtree is written in the printTree layout.
+    -----------------------------------------------------------------------*/
+    void printTreeRecursive(Account *account, ostream &out, int indent);
+
+    /*------------------------------------------------------------------------
+      Marks the cached text of an account dirty, and the balance lines of all
+      its ancestors; postingsChanged also re-renders the account's existing
+      transaction lines (appended postings are picked up without it).
+
+      Precondition:  A valid account pointer is provided.
+      Post-condition: The next printTree re-renders the marked parts.
+    -----------------------------------------------------------------------*/
+    void invalidateRendering(Account *account, bool postingsChanged);
+
+    /*------------------------------------------------------------------------
+      Bumps the query-cache version of an account and of all its ancestors,
+      the only subtrees whose aggregates a change to the account can move.
+
+      Precondition:  A valid account pointer is provided.
+      Post-condition: Cached aggregates of those accounts are stale.
+    -----------------------------------------------------------------------*/
+    void invalidateAggregates(Account *account);
+
+    /*------------------------------------------------------------------------
+      Computes an aggregate over an account and its descendants by scanning
+      their posting columns (BALANCE uses the balances and period series).
+
+      Precondition:  A valid account pointer is provided.
+      Post-condition: Returns the aggregate.
+    -----------------------------------------------------------------------*/
+    double computeAggregate(Account *account, QueryCache::Metric metric, int fromDate, int toDate) const;
+
+    /*------------------------------------------------------------------------
+      Adds a transaction to an account and, if it is dated, records its
+      signed amount in the period series of the account and its ancestors.
+      A loader replaying saved postings passes enforceFloor = false: the
+      postings were valid when made, but not necessarily in file order.
+
+      Precondition:  A valid account pointer and transaction data are provided.
+      Post-condition: The transaction is posted and the period series updated.
     -----------------------------------------------------------------------*/
-    string cleanDescription(const string &desc) const;
+    void recordPosting(Account *account, double amount, char debitOrCredit, int date, bool enforceFloor = true);
 
     /*------------------------------------------------------------------------
-      Recursively writes the ForestTree structure to a file.
+      Records a dated delta in the period series of an account and all of
+      its ancestors.
 
-      Precondition:  A valid account pointer, file stream, and indentation level are provided.
-      Post-condition: The tree structure is recursively written to the file in a readable format.
+      Precondition:  A valid account pointer and YYYYMMDD date are provided.
+      Post-condition: Each series on the ancestor chain is updated in O(log P).
     -----------------------------------------------------------------------*/
-    void printTreeRecursive(Account *account, ofstream &file, int indent);
+    void recordPeriodDelta(Account *account, int date, double delta);
+
+    /*------------------------------------------------------------------------
+      Collects an account followed by all of its descendants. Descendants of
+      account N can only be numbered N*10..N*10+9, N*100..N*100+99, and so on,
+      so only those key ranges of `accountMap` are visited.
+
+      Precondition:  A valid account pointer is provided.
+      Post-condition: The account and its descendants are appended to `out`.
+    -----------------------------------------------------------------------*/
+    void collectSubtree(Account *account, vector<Account *> &out) const;
+
+    /*------------------------------------------------------------------------
+      Looks up an account by number.
+
+      Precondition:  None.
+      Post-condition: Returns the account; throws invalid_argument if not found.
+    -----------------------------------------------------------------------*/
+    Account *requireAccount(int accountNumber) const;
+
+    // Dated delta of one account, recorded in its period series and its ancestors'
+    struct DatedDelta {
+        Account *account;
+        int date;
+        double delta;
+    };
+
+    // Balance delta and subtree hash term of one account in a bulk change
+    struct NetDelta {
+        double balance = 0.0;
+        uint64_t hash = 0;
+    };
+
+    // Net effect of a bulk change: balance deltas merged over every affected account and ancestor
+    struct NetDeltas {
+        unordered_map<Account *, NetDelta> balances;    // Balance delta and hash term per account
+        vector<DatedDelta> dated;                       // Merged per account and date
+    };
+
+    /*------------------------------------------------------------------------
+      Adds a balance delta and hash term of an account to the account and
+      every ancestor in `net`, or a dated delta of the account, or applies
+      `net`: each balance, subtree hash and cache entry is updated once,
+      and each dated delta is recorded along the ancestor chain.
+
+      Precondition:  account is in the tree; the date is a valid YYYYMMDD value.
+      Post-condition: applyNetDeltas leaves invariants 4, 8 and 9 holding.
+    -----------------------------------------------------------------------*/
+    void mergeNetDelta(NetDeltas &net, Account *account, double delta, uint64_t hashTerm) const;
+
+    void mergeNetDatedDelta(NetDeltas &net, Account *account, int date, double delta) const;
+
+    void applyNetDeltas(const NetDeltas &net);
+
+    /*------------------------------------------------------------------------
+      Compiles the posting rule of every account into its slot.
+
+      Precondition:  None.
+      Post-condition: Invariant 12 holds for the current rules.
+    -----------------------------------------------------------------------*/
+    void compileRules();
+
+    /*------------------------------------------------------------------------
+      Returns the account alone, or followed by all of its descendants when
+      includeSubtree is true.
+
+      Precondition:  None.
+      Post-condition: Returns the accounts; throws if the account does not exist.
+    -----------------------------------------------------------------------*/
+    vector<Account *> selectAccounts(int accountNumber, bool includeSubtree) const;
 
 public:
     /***** Constructor *****/
@@ -107,14 +376,34 @@ public:
     /***** Build from File *****/
     /*------------------------------------------------------------------------
       Builds the ForestTree structure by reading account data from a file.
+      A printed balance is a subtree balance (as printTree writes it): each
+      account opens at it minus its subtree's postings, rounded to cents.
 
       Precondition:  A valid filename with properly formatted account and
                      transaction data is provided.
       Post-condition: The tree is populated with accounts and transactions based
-                      on the file data.
+                      on the file data; postings the rules reject are skipped
+                      and leave the printed balances unchanged.
     -----------------------------------------------------------------------*/
     void buildFromFile(const string &filename);
 
+    /***** Build from Table *****/
+    /*------------------------------------------------------------------------
+      Replaces the contents of the tree with a chart compiled into static
+      data (e.g. BASE_CHART from BaseChart.h). Nothing is parsed: the
+      accounts are constructed in one block, link to their parents by table
+      index, and keep views of the table's descriptions instead of copies.
+      The description index is built on the first searchByDescription.
+      Sub-accounts and postings are then added on top as usual.
+
+      Precondition:  The table outlives the tree's use of its accounts; its
+                     entries are ordered by account number and every parent
+                     index refers to an earlier entry.
+      Post-condition: The tree holds exactly the table's accounts; throws
+                      invalid_argument (leaving the tree empty) on a malformed table.
+    -----------------------------------------------------------------------*/
+    void buildFromTable(const ChartTable &table);
+
     /***** Add Account *****/
     /*------------------------------------------------------------------------
       Adds a new account to the ForestTree.
@@ -122,12 +411,15 @@ public:
       Precondition:  A unique account number, description, and initial balance are provided.
       Post-condition: The new account is added to the tree, mapped in `accountMap`,
                       and associated with its parent account (if applicable).
+                      The description is interned in the tree's string pool.
     -----------------------------------------------------------------------*/
-    void addAccount(int accountNumber, const string &description, double initialBalance);
+    void addAccount(int accountNumber, string_view description, double initialBalance);
 
     /***** Remove Account *****/
     /*------------------------------------------------------------------------
-      Removes an account from the ForestTree by its account number.
+      Removes an account from the ForestTree by its account number. Its
+      children stay as top-level accounts; the ancestors' balances, dated
+      movements and hashes lose the postings of the whole removed subtree.
 
       Precondition:  A valid account number is provided.
       Post-condition: The account is removed from the tree and `accountMap` if it exists.
@@ -143,6 +435,80 @@ public:
     -----------------------------------------------------------------------*/
     void addTransaction(int accountNumber, const Transaction &transaction);
 
+    /*------------------------------------------------------------------------
+      Posts a transaction to an account directly from its fields: they are
+      written into the account's posting columns with no Transaction object
+      in between. Once the account's slot has room (see reservePostings), the
+      whole path (validation, balances, period series, caches) allocates
+      nothing.
+
+      Precondition:  An existing account number, 'D' or 'C', and a date that
+                     is 0 (undated) or a valid YYYYMMDD value.
+      Post-condition: The posting is stored with the account's next ID;
+                      throws invalid_argument (changing nothing) for a bad
+                      type or date or a credit above the balance.
+    -----------------------------------------------------------------------*/
+    void emplaceTransaction(int accountNumber, double amount, char debitOrCredit, int date = 0);
+
+    /*------------------------------------------------------------------------
+      Reserves room for `count` postings in an account's slot.
+
+      Precondition:  An existing account number is provided.
+      Post-condition: The account holds up to `count` postings without growing.
+    -----------------------------------------------------------------------*/
+    void reservePostings(int accountNumber, size_t count);
+
+    /***** Post Journal Entry *****/
+    /*------------------------------------------------------------------------
+      Posts every leg of a journal entry as one operation. The entry must
+      balance, every account must exist, and each credit leg must be covered
+      by its account's balance as it stands after the earlier legs. The legs'
+      deltas are merged per account, so an ancestor shared by several legs
+      is updated once with the net delta (as are its period series and
+      cache entries). Like every mutation, it must not run concurrently with
+      other calls on the tree (LedgerServer runs it under its write lock).
+
+      Precondition:  A JournalEntry is provided.
+      Post-condition: Either every leg is stored (each with its account's
+                      next ID) and balances are adjusted, or, if the entry is
+                      rejected, invalid_argument is thrown and nothing
+                      changes. Once the legs' slots have room, posting an
+                      entry allocates nothing.
+    -----------------------------------------------------------------------*/
+    void postEntry(const JournalEntry &entry);
+
+    /***** Posting Rules *****/
+    /*------------------------------------------------------------------------
+      Sets or removes the validation rule of a subtree (see PostingRules.h)
+      and recompiles the rule of every account. Rules are configuration:
+      initialize and the build functions keep them.
+
+      Precondition:  A valid account number (the subtree need not exist yet).
+      Post-condition: Every later posting is checked against the new rules;
+                      setPostingRule throws invalid_argument for a bad rule,
+                      removePostingRule returns false if there was none.
+    -----------------------------------------------------------------------*/
+    void setPostingRule(int subtree, const PostingRules::Rule &rule);
+
+    bool removePostingRule(int subtree);
+
+    const PostingRules &getPostingRules() const;
+
+    /*------------------------------------------------------------------------
+      Checks n postings given as arrays against the rules, without posting
+      them: account existence, type, amount and limit. The balance floor is
+      only known when a posting is applied and is checked then. Safe to call
+      from a thread other than the (single) writer while accounts and rules
+      are not changed.
+
+      Precondition:  Every array holds n elements.
+      Post-condition: slots[i] receives the slot of posting i's account (-1 if
+                      unknown) and verdicts[i] its PostingRules::Verdict;
+                      returns the number of postings that failed.
+    -----------------------------------------------------------------------*/
+    size_t validatePostings(const int *accountNumbers, const double *amounts, const char *debitOrCredit,
+                            size_t n, int *slots, unsigned char *verdicts) const;
+
     /***** Remove Transaction *****/
     /*------------------------------------------------------------------------
       Removes a transaction from a specific account by its transaction ID.
@@ -152,6 +518,33 @@ public:
     -----------------------------------------------------------------------*/
     void removeTransaction(int accountNumber, int transactionID);
 
+    /***** Bulk Removal and Reversal *****/
+    /*------------------------------------------------------------------------
+      Removes every posting of an account (or of its whole subtree) that
+      matches a filter. Each affected account is compacted in one pass and
+      renumbered once; the net balance and dated corrections are merged and
+      applied to each ancestor once.
+
+      Precondition:  An existing account number is provided.
+      Post-condition: Returns the number of postings removed.
+    -----------------------------------------------------------------------*/
+    size_t removePostings(int accountNumber, const PostingFilter &filter, bool includeSubtree = true);
+
+    /*------------------------------------------------------------------------
+      Posts an offsetting entry (opposite type, same amount) for every
+      posting of an account (or subtree) that matches a filter, dated
+      reversalDate or, if it is 0, the original posting's date. Every
+      reversal is checked against the posting rules, in order, before any
+      is stored; net corrections are applied to each ancestor once.
+
+      Precondition:  An existing account number; reversalDate is 0 or valid.
+      Post-condition: Returns the number of postings reversed; throws
+                      invalid_argument (changing nothing) if a reversal is
+                      rejected.
+    -----------------------------------------------------------------------*/
+    size_t reversePostings(int accountNumber, const PostingFilter &filter, bool includeSubtree = true,
+                           int reversalDate = 0);
+
     /***** Search Account *****/
     /*------------------------------------------------------------------------
       Searches for an account in the ForestTree by its account number.
@@ -161,14 +554,223 @@ public:
     -----------------------------------------------------------------------*/
     Account *searchAccount(int accountNumber);
 
+    /*------------------------------------------------------------------------
+      Returns every account in the tree, keyed and ordered by account number.
+
+      Precondition:  None.
+      Post-condition: Returns a read-only reference valid until the tree changes.
+    -----------------------------------------------------------------------*/
+    const map<int, Account *> &getAccountMap() const;
+
+    /***** Subtree Hashes *****/
+    /*------------------------------------------------------------------------
+      Returns the accounts whose parent is the given account, or, for 0, the
+      accounts with no parent, in account number order. Two ledgers compare
+      by descending from the top-level accounts only into children whose
+      subtree hashes (Account::getSubtreeHash) differ.
+
+      Precondition:  accountNumber is 0 or an existing account number.
+      Post-condition: Returns the children; throws invalid_argument for an
+                      unknown account.
+    -----------------------------------------------------------------------*/
+    vector<Account *> getChildren(int accountNumber) const;
+
+    /*------------------------------------------------------------------------
+      Returns the hash of the whole ledger: the sum of the top-level
+      accounts' subtree hashes, equal for two trees with the same accounts
+      and postings (e.g. a primary and a replica at the same log position).
+
+      Precondition:  None.
+      Post-condition: Returns the hash; visits every account once.
+    -----------------------------------------------------------------------*/
+    uint64_t getTreeHash() const;
+
+    /*------------------------------------------------------------------------
+      Recomputes every subtree hash from the accounts and postings and
+      compares it with the maintained one.
+
+      Precondition:  None.
+      Post-condition: Returns true if all match; the numbers of accounts
+                      whose hash differs are appended to `mismatched`.
+    -----------------------------------------------------------------------*/
+    bool verifyHashes(vector<int> *mismatched = nullptr) const;
+
+    /***** Balance Recomputation *****/
+    /*------------------------------------------------------------------------
+      Recomputes every balance from the postings instead of trusting the
+      incrementally propagated one: a balance is the opening balance plus
+      the signed postings of the account and of every account below it.
+      The accounts' own postings are summed in parallel, then each level
+      of the hierarchy (deepest first; at most five, one per digit) adds
+      its children's totals in parallel. Children are added in account
+      number order, so the result does not depend on the thread count.
+      Every balance is set to exactly the recomputed one.
+
+      Precondition:  No other thread uses the tree; threads is the number
+                     of threads to use (0 for one per hardware thread).
+      Post-condition: Returns the number of accounts whose stored balance
+                      differed in cents; they are appended to `mismatches`.
+    -----------------------------------------------------------------------*/
+    size_t recomputeBalances(vector<BalanceMismatch> *mismatches = nullptr, unsigned threads = 0);
+
     /***** Print Tree *****/
     /*------------------------------------------------------------------------
-      Prints the entire ForestTree structure to a file.
+      Prints the entire ForestTree structure to a file or a stream. Text of
+      accounts unchanged since the previous print is reused from a cache.
 
-      Precondition:  A valid filename is provided.
-      Post-condition: The tree structure is written to the file in a readable format.
+      Precondition:  A valid filename / stream is provided.
+      Post-condition: The tree structure is written in a readable format.
     -----------------------------------------------------------------------*/
     void printTree(const string &filename);
+
+    void printTree(ostream &out);
+
+    /***** Dated Balances *****/
+    /*------------------------------------------------------------------------
+      Returns the balance of an account (including its sub-accounts) at the
+      end of the period containing the given date. Undated postings and
+      initial balances count as opening balance.
+
+      Precondition:  An existing account number and a YYYYMMDD date are provided.
+      Post-condition: Returns the balance in O(log P); throws if the account
+                      does not exist.
+    -----------------------------------------------------------------------*/
+    double balanceAt(int accountNumber, int date);
+
+    /*------------------------------------------------------------------------
+      Returns the net dated movement of an account (including its
+      sub-accounts) over the periods between two dates, inclusive.
+
+      Precondition:  An existing account number and YYYYMMDD dates are provided.
+      Post-condition: Returns the movement in O(log P); throws if the account
+                      does not exist.
+    -----------------------------------------------------------------------*/
+    double periodMovement(int accountNumber, int fromDate, int toDate);
+
+    /*------------------------------------------------------------------------
+      Selects the bucketing granularity of dated balances and rebuilds the
+      period series from the existing postings.
+
+      Precondition:  None.
+      Post-condition: All period queries use the new granularity.
+    -----------------------------------------------------------------------*/
+    void setPeriodGranularity(PeriodBalances::Granularity granularity);
+
+    /***** Posting Aggregates *****/
+    /*------------------------------------------------------------------------
+      Aggregates the postings of an account, or of the account and all its
+      descendants when includeSubtree is true, using the vectorized kernels
+      in PostingKernels over each account's posting columns.
+
+      postingFilteredSum selects postings by type ('D', 'C', or 0 for both)
+      whose amount is at least minAmount. postingRange returns false if there
+      are no postings.
+
+      Precondition:  An existing account number is provided.
+      Post-condition: Returns the aggregate; throws if the account does not exist.
+    -----------------------------------------------------------------------*/
+    double postingSignedSum(int accountNumber, bool includeSubtree);
+
+    double postingFilteredSum(int accountNumber, char debitOrCredit, double minAmount, bool includeSubtree);
+
+    size_t countPostingsAbove(int accountNumber, double threshold, bool includeSubtree);
+
+    bool postingRange(int accountNumber, bool includeSubtree, double &minAmount, double &maxAmount);
+
+    /***** Posting Store *****/
+    /*------------------------------------------------------------------------
+      Returns the ledger-wide columnar posting store (account, ID, amount,
+      type and date columns, segmented per account) for analytic scans.
+
+      Precondition:  None.
+      Post-condition: Returns a read-only reference valid for the tree's lifetime.
+    -----------------------------------------------------------------------*/
+    const PostingStore &getPostingStore() const;
+
+    /***** Search by Description *****/
+    /*------------------------------------------------------------------------
+      Searches account descriptions by words. Every query word must match a
+      description word exactly or as a prefix (case-insensitive); results are
+      ranked by relevance using the inverted description index.
+
+      Precondition:  None.
+      Post-condition: Returns up to `limit` accounts, best match first.
+    -----------------------------------------------------------------------*/
+    vector<Account *> searchByDescription(const string &query, size_t limit = 20);
+
+    /***** Subtree Aggregates *****/
+    /*------------------------------------------------------------------------
+      Returns an aggregate of an account and all its descendants, served from
+      the query cache when nothing in the subtree changed since it was last
+      computed. Metrics:
+        BALANCE        Balance at the end of the period containing toDate
+                       (the current balance when toDate is 0).
+        DEBITS         Sum of debit postings.
+        CREDITS        Sum of credit postings.
+        TURNOVER       Sum of debit and credit postings.
+        POSTING_COUNT  Number of postings.
+      The posting metrics count postings dated fromDate..toDate (inclusive),
+      or every posting, dated or not, when both dates are 0.
+
+      Precondition:  An existing account number; dates are YYYYMMDD or 0.
+      Post-condition: Returns the aggregate; throws if the account does not exist.
+    -----------------------------------------------------------------------*/
+    double subtreeAggregate(int accountNumber, QueryCache::Metric metric, int fromDate = 0, int toDate = 0);
+
+    QueryCache::Stats getQueryCacheStats() const;
+
+    /***** Top-K Queries *****/
+    /*------------------------------------------------------------------------
+      Return the k accounts with the largest balances, or the k largest
+      postings (by amount), of the whole ledger (accountNumber 0) or of an
+      account and, if includeSubtree, its descendants. Postings are limited
+      to those matching the filter (e.g. its dates, for one period). Both
+      select with a bounded heap (partial sort): O(n log k) for n
+      candidates, with no full sort. Ties rank by account number, then by
+      transaction ID.
+
+      Precondition:  accountNumber is 0 or an existing account.
+      Post-condition: Returns up to k results, largest first; throws
+                      invalid_argument if the account does not exist.
+    -----------------------------------------------------------------------*/
+    vector<Account *> topBalances(size_t k, int accountNumber = 0) const;
+
+    vector<RankedPosting> topPostings(size_t k, int accountNumber = 0, const PostingFilter &filter = PostingFilter(),
+                                      bool includeSubtree = true) const;
+
+    /*------------------------------------------------------------------------
+      Returns the sketch of posting activity by account, updated at constant
+      cost by every posting (post, journal entry, reversal or file load).
+
+      Precondition:  None.
+      Post-condition: Returns a read-only reference valid for the tree's lifetime.
+    -----------------------------------------------------------------------*/
+    const ActivitySketch &getActivitySketch() const;
+
+    /***** Memory *****/
+    /*------------------------------------------------------------------------
+      Reports the heap memory held by the tree, broken down by category.
+      Removals leave their memory as slack (posting columns keep their
+      capacity, the description pool keeps removed text, the table block
+      keeps removed accounts) until compact is called.
+
+      Precondition:  None.
+      Post-condition: Returns the estimate; the tree is unchanged.
+    -----------------------------------------------------------------------*/
+    MemoryStats memoryStats() const;
+
+    /*------------------------------------------------------------------------
+      Compacts the tree after large deletions: packs the posting columns,
+      re-interns the live descriptions into a fresh pool, drops stale cache
+      entries, shrinks the indexes and scratch space, and frees the table
+      block once none of its accounts is left.
+
+      Precondition:  No other thread uses the tree; no view obtained from
+                     the tree (postings, descriptions) is still held.
+      Post-condition: Balances, postings, descriptions and hashes are
+                      unchanged; returns the bytes released.
+    -----------------------------------------------------------------------*/
+    size_t compact();
 };
 
 #endif // FORESTTREE_H
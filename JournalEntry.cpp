@@ -0,0 +1,88 @@
+#include "JournalEntry.h"
+#include "Transaction.h"
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// Constructor: Creates an entry with no legs
+JournalEntry::JournalEntry(int date) : date(0) {
+    clear(date);
+}
+
+// Appends a leg after checking its amount and type
+void JournalEntry::addLeg(int accountNumber, double amount, char debitOrCredit) {
+    if (debitOrCredit != 'D' && debitOrCredit != 'C') {
+        throw invalid_argument("Invalid transaction type. Use 'D' for Debit or 'C' for Credit.");
+    }
+    if (!(amount > 0.0)) {
+        throw invalid_argument("Journal entry amounts must be positive.");
+    }
+    legs.push_back({accountNumber, amount, debitOrCredit});
+}
+
+// Appends a debit leg
+void JournalEntry::debit(int accountNumber, double amount) {
+    addLeg(accountNumber, amount, 'D');
+}
+
+// Appends a credit leg
+void JournalEntry::credit(int accountNumber, double amount) {
+    addLeg(accountNumber, amount, 'C');
+}
+
+// Removes every leg (keeping capacity) and sets the date
+void JournalEntry::clear(int newDate) {
+    if (newDate != 0 && !Transaction::isValidDate(newDate)) {
+        throw invalid_argument("Invalid posting date: " + to_string(newDate) + ". Use YYYY-MM-DD.");
+    }
+    legs.clear();
+    date = newDate;
+}
+
+// Returns the legs
+const vector<JournalEntry::Leg> &JournalEntry::getLegs() const {
+    return legs;
+}
+
+// Returns the posting date
+int JournalEntry::getDate() const {
+    return date;
+}
+
+// Returns the sum of the debit legs
+double JournalEntry::getDebitTotal() const {
+    double total = 0.0;
+    for (const Leg &leg: legs) {
+        if (leg.debitOrCredit == 'D') total += leg.amount;
+    }
+    return total;
+}
+
+// Returns the sum of the credit legs
+double JournalEntry::getCreditTotal() const {
+    double total = 0.0;
+    for (const Leg &leg: legs) {
+        if (leg.debitOrCredit == 'C') total += leg.amount;
+    }
+    return total;
+}
+
+// Compares the totals in whole cents
+bool JournalEntry::isBalanced() const {
+    return llround(getDebitTotal() * 100.0) == llround(getCreditTotal() * 100.0);
+}
+
+// Throws if the entry has fewer than two legs or does not balance
+void JournalEntry::validate() const {
+    if (legs.size() < 2) {
+        throw invalid_argument("A journal entry needs at least two legs.");
+    }
+    if (!isBalanced()) {
+        char totals[96];
+        snprintf(totals, sizeof(totals), "debits %.2f, credits %.2f", getDebitTotal(), getCreditTotal());
+        throw invalid_argument(string("Journal entry is not balanced: ") + totals + ".");
+    }
+}
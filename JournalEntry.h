@@ -0,0 +1,95 @@
+#ifndef JOURNALENTRY_H
+#define JOURNALENTRY_H
+
+/**-- JournalEntry.h --------------------------------------------------------
+  This header file defines the JournalEntry class, a double-entry journal
+  entry: a posting date and two or more legs, each debiting or crediting
+  one account. An entry is balanced when its debits and credits agree to
+  the cent. ForestTree::postEntry applies a balanced entry atomically.
+
+  Basic operations:
+    Constructor:     Creates an entry with no legs and an optional date.
+    addLeg:          Appends a leg (account, amount, 'D' or 'C').
+    debit / credit:  Shorthands for addLeg.
+    clear:           Removes every leg and sets a new date, keeping capacity
+                     so a reused entry does not allocate.
+    Getters:         Legs, date, and debit and credit totals.
+    isBalanced:      Returns whether debits equal credits to the cent.
+    validate:        Throws if the entry cannot be posted.
+
+  Class Invariant:
+    1. Every leg has a positive amount and a type of 'D' or 'C'.
+    2. The date is 0 (undated) or a valid YYYYMMDD value.
+--------------------------------------------------------------------------**/
+
+#include <vector>
+
+using namespace std;
+
+class JournalEntry {
+public:
+    struct Leg {
+        int accountNumber;
+        double amount;          // Positive; the type carries the sign
+        char debitOrCredit;     // 'D' or 'C'
+    };
+
+private:
+    vector<Leg> legs;   // Legs in the order they were added
+    int date;           // Posting date of every leg (YYYYMMDD, 0 if undated)
+
+public:
+    /***** Constructor *****/
+    /*------------------------------------------------------------------------
+      Creates an entry with no legs.
+
+      Precondition:  The date is 0 (undated) or a valid YYYYMMDD value.
+      Post-condition: Throws invalid_argument for an invalid date.
+    -----------------------------------------------------------------------*/
+    explicit JournalEntry(int date = 0);
+
+    /***** Leg Management *****/
+    /*------------------------------------------------------------------------
+      Appends a leg to the entry. Accounts are checked when the entry is posted.
+
+      Precondition:  amount > 0 and debitOrCredit is 'D' or 'C'.
+      Post-condition: The leg is appended; throws invalid_argument otherwise.
+    -----------------------------------------------------------------------*/
+    void addLeg(int accountNumber, double amount, char debitOrCredit);
+
+    void debit(int accountNumber, double amount);
+
+    void credit(int accountNumber, double amount);
+
+    /*------------------------------------------------------------------------
+      Removes every leg and sets the date of the next entry.
+
+      Precondition:  The date is 0 (undated) or a valid YYYYMMDD value.
+      Post-condition: The entry has no legs; its capacity is kept.
+    -----------------------------------------------------------------------*/
+    void clear(int newDate = 0);
+
+    /***** Getters *****/
+    const vector<Leg> &getLegs() const;
+
+    int getDate() const;
+
+    double getDebitTotal() const;
+
+    double getCreditTotal() const;
+
+    /***** Validation *****/
+    /*------------------------------------------------------------------------
+      isBalanced returns whether the debit and credit totals round to the
+      same number of cents; validate also requires at least two legs.
+
+      Precondition:  None.
+      Post-condition: validate throws invalid_argument for an entry that
+                      cannot be posted.
+    -----------------------------------------------------------------------*/
+    bool isBalanced() const;
+
+    void validate() const;
+};
+
+#endif // JOURNALENTRY_H
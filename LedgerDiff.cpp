@@ -0,0 +1,202 @@
+#include "LedgerDiff.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <sstream>
+#include <tuple>
+
+using namespace std;
+
+namespace {
+
+    long long cents(double amount) {
+        return llround(amount * 100.0);
+    }
+
+    bool samePosting(PostingRef a, PostingRef b) {
+        return cents(a.getAmount()) == cents(b.getAmount()) && a.getDebitOrCredit() == b.getDebitOrCredit() &&
+               a.getDate() == b.getDate();
+    }
+
+    LedgerDiff::AccountChange describe(const Account &account) {
+        return {account.getAccountNumber(), string(account.getDescription()), account.getBalance(),
+                account.getTransactions().size()};
+    }
+
+    LedgerDiff::PostingChange postingChange(const Account &account, PostingRef posting) {
+        return {account.getAccountNumber(), posting.getTransactionID(), posting.getAmount(),
+                posting.getDebitOrCredit(), posting.getDate()};
+    }
+
+    void appendPosting(ostringstream &out, char sign, const LedgerDiff::PostingChange &posting) {
+        char line[128];
+        snprintf(line, sizeof(line), "%c posting %d #%d %.2f %c", sign, posting.accountNumber,
+                 posting.transactionID, posting.amount, posting.debitOrCredit);
+        out << line;
+        if (posting.date != 0) {
+            out << ' ' << Transaction::formatDate(posting.date);
+        }
+        out << '\n';
+    }
+}
+
+// Appends an account and its whole subtree
+void LedgerDiff::collect(const ForestTree &tree, const Account *account, vector<AccountChange> &out) {
+    out.push_back(describe(*account));
+    for (const Account *child: tree.getChildren(account->getAccountNumber())) {
+        collect(tree, child, out);
+    }
+}
+
+// Appends the description, balance and posting changes of two same-numbered accounts
+void LedgerDiff::inspect(const Account &before, const Account &after, Report &report) {
+    ++report.accountsInspected;
+    if (before.getDescription() != after.getDescription()) {
+        report.changedDescriptions.push_back({before.getAccountNumber(), string(before.getDescription()),
+                                              string(after.getDescription())});
+    }
+    if (cents(before.getBalance()) != cents(after.getBalance())) {
+        report.balanceChanges.push_back({before.getAccountNumber(), before.getBalance(), after.getBalance()});
+    }
+    diffPostings(before, after, report);
+}
+
+// Merges two sorted child lists: common numbers descend, the rest are removed or added subtrees
+void LedgerDiff::mergeChildren(const ForestTree &before, const ForestTree &after, const vector<Account *> &was,
+                               const vector<Account *> &now, Report &report) {
+    size_t i = 0, j = 0;
+    while (i < was.size() || j < now.size()) {
+        if (j == now.size() || (i < was.size() && was[i]->getAccountNumber() < now[j]->getAccountNumber())) {
+            collect(before, was[i++], report.removedAccounts);
+        } else if (i == was.size() || now[j]->getAccountNumber() < was[i]->getAccountNumber()) {
+            collect(after, now[j++], report.addedAccounts);
+        } else {
+            descend(before, after, was[i++], now[j++], report);
+        }
+    }
+}
+
+// Skips equal subtrees by hash; otherwise inspects the account and descends into its children
+void LedgerDiff::descend(const ForestTree &before, const ForestTree &after, const Account *was, const Account *now,
+                         Report &report) {
+    if (was->getSubtreeHash() == now->getSubtreeHash()) {
+        ++report.subtreesSkipped;
+        return;
+    }
+    inspect(*was, *now, report);
+    mergeChildren(before, after, before.getChildren(was->getAccountNumber()),
+                  after.getChildren(now->getAccountNumber()), report);
+}
+
+// Skips the common prefix of postings, then sorts and merges the rest by content
+void LedgerDiff::diffPostings(const Account &before, const Account &after, Report &report) {
+    PostingView left = before.getTransactions(), right = after.getTransactions();
+    size_t common = 0;
+    while (common < left.size() && common < right.size() && samePosting(left[common], right[common])) {
+        ++common;
+    }
+    if (common == left.size() && common == right.size()) return;
+
+    // Remaining postings as (date, type, cents, index), so equal contents are adjacent
+    typedef tuple<int, char, long long, size_t> Key;
+    vector<Key> removed, added;
+    for (size_t i = common; i < left.size(); ++i) {
+        removed.emplace_back(left[i].getDate(), left[i].getDebitOrCredit(), cents(left[i].getAmount()), i);
+    }
+    for (size_t i = common; i < right.size(); ++i) {
+        added.emplace_back(right[i].getDate(), right[i].getDebitOrCredit(), cents(right[i].getAmount()), i);
+    }
+    sort(removed.begin(), removed.end());
+    sort(added.begin(), added.end());
+
+    auto content = [](const Key &key) { return make_tuple(get<0>(key), get<1>(key), get<2>(key)); };
+    vector<size_t> removedIndexes, addedIndexes;
+    size_t i = 0, j = 0;
+    while (i < removed.size() || j < added.size()) {
+        if (j == added.size() || (i < removed.size() && content(removed[i]) < content(added[j]))) {
+            removedIndexes.push_back(get<3>(removed[i++]));
+        } else if (i == removed.size() || content(added[j]) < content(removed[i])) {
+            addedIndexes.push_back(get<3>(added[j++]));
+        } else {
+            ++i;    // Same content on both sides
+            ++j;
+        }
+    }
+
+    // Report in ledger order
+    sort(removedIndexes.begin(), removedIndexes.end());
+    sort(addedIndexes.begin(), addedIndexes.end());
+    for (size_t index: removedIndexes) {
+        report.removedPostings.push_back(postingChange(before, left[index]));
+    }
+    for (size_t index: addedIndexes) {
+        report.addedPostings.push_back(postingChange(after, right[index]));
+    }
+}
+
+// Descends both hierarchies from the top-level accounts
+LedgerDiff::Report LedgerDiff::compare(const ForestTree &before, const ForestTree &after) {
+    Report report;
+    mergeChildren(before, after, before.getChildren(0), after.getChildren(0), report);
+
+    // An account whose parent exists on one side only is reported on both lists; compare it instead
+    if (!report.addedAccounts.empty() && !report.removedAccounts.empty()) {
+        set<int> added, both;
+        for (const AccountChange &account: report.addedAccounts) added.insert(account.accountNumber);
+        for (const AccountChange &account: report.removedAccounts) {
+            if (added.count(account.accountNumber)) both.insert(account.accountNumber);
+        }
+        if (!both.empty()) {
+            auto moved = [&both](const AccountChange &account) { return both.count(account.accountNumber) > 0; };
+            report.addedAccounts.erase(remove_if(report.addedAccounts.begin(), report.addedAccounts.end(), moved),
+                                       report.addedAccounts.end());
+            report.removedAccounts.erase(remove_if(report.removedAccounts.begin(), report.removedAccounts.end(),
+                                                   moved), report.removedAccounts.end());
+            for (int number: both) {
+                inspect(*before.getAccountMap().at(number), *after.getAccountMap().at(number), report);
+            }
+        }
+    }
+    return report;
+}
+
+// Returns whether a report holds no difference
+bool LedgerDiff::isEmpty(const Report &report) {
+    return report.addedAccounts.empty() && report.removedAccounts.empty() && report.changedDescriptions.empty() &&
+           report.balanceChanges.empty() && report.addedPostings.empty() && report.removedPostings.empty();
+}
+
+// Renders a report as text, one change per line
+string LedgerDiff::formatReport(const Report &report) {
+    ostringstream out;
+    char line[160];
+    for (const AccountChange &account: report.removedAccounts) {
+        snprintf(line, sizeof(line), "- account %d balance %.2f, %zu postings: ", account.accountNumber,
+                 account.balance, account.postings);
+        out << line << account.description << '\n';
+    }
+    for (const AccountChange &account: report.addedAccounts) {
+        snprintf(line, sizeof(line), "+ account %d balance %.2f, %zu postings: ", account.accountNumber,
+                 account.balance, account.postings);
+        out << line << account.description << '\n';
+    }
+    for (const DescriptionChange &change: report.changedDescriptions) {
+        out << "~ description " << change.accountNumber << ": " << change.before << " -> " << change.after << '\n';
+    }
+    for (const BalanceChange &change: report.balanceChanges) {
+        snprintf(line, sizeof(line), "~ balance %d: %.2f -> %.2f (%+.2f)\n", change.accountNumber, change.before,
+                 change.after, change.after - change.before);
+        out << line;
+    }
+    for (const PostingChange &posting: report.removedPostings) {
+        appendPosting(out, '-', posting);
+    }
+    for (const PostingChange &posting: report.addedPostings) {
+        appendPosting(out, '+', posting);
+    }
+    snprintf(line, sizeof(line), "%zu accounts inspected, %zu unchanged subtrees skipped by hash\n",
+             report.accountsInspected, report.subtreesSkipped);
+    out << line;
+    return out.str();
+}
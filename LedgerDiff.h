@@ -0,0 +1,136 @@
+#ifndef LEDGERDIFF_H
+#define LEDGERDIFF_H
+
+/**-- LedgerDiff.h ----------------------------------------------------------
+  This header file defines the LedgerDiff class, a structural comparison of
+  two ledger states (two ForestTree instances, e.g. yesterday's and today's
+  saved charts loaded with buildFromFile). It reports added and removed
+  accounts, changed descriptions, balance deltas, and added and removed
+  postings.
+
+  The comparison descends both hierarchies together from the top-level
+  accounts, merging each account's children by number. Every account keeps
+  an incremental subtree hash (Account::getSubtreeHash, LedgerHash.h), so a
+  subtree whose hash is the same on both sides is skipped without visiting
+  it: the work grows with the size of the change, not of the chart.
+
+  Amounts and balances are compared in whole cents, the precision printTree
+  saves. Postings are matched by content (amount, type and date), not by
+  ID, since removals renumber the IDs that follow: after the common prefix,
+  the remaining postings of an account are sorted and merged.
+
+  Basic operations:
+    compare:        Returns the differences between two trees.
+    isEmpty:        Returns whether a report holds no difference.
+    formatReport:   Renders a report as text, one change per line.
+
+  Helper functions:
+    descend / mergeChildren:
+                    Compare two same-numbered accounts and, if their subtree
+                    hashes differ, merge and compare their children.
+    collect:        Adds an account and its whole subtree to a list.
+    inspect:        Adds the differences of two same-numbered accounts.
+    diffPostings:   Adds the posting differences of one account to a report.
+--------------------------------------------------------------------------**/
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "ForestTree.h"
+
+using namespace std;
+
+class LedgerDiff {
+public:
+    struct AccountChange {
+        int accountNumber;
+        string description;
+        double balance;
+        size_t postings;
+    };
+
+    struct DescriptionChange {
+        int accountNumber;
+        string before;
+        string after;
+    };
+
+    struct BalanceChange {
+        int accountNumber;
+        double before;
+        double after;
+    };
+
+    struct PostingChange {
+        int accountNumber;
+        int transactionID;              // ID in the state the posting belongs to
+        double amount;
+        char debitOrCredit;
+        int date;                       // YYYYMMDD, 0 if undated
+    };
+
+    struct Report {
+        vector<AccountChange> addedAccounts;
+        vector<AccountChange> removedAccounts;
+        vector<DescriptionChange> changedDescriptions;
+        vector<BalanceChange> balanceChanges;
+        vector<PostingChange> addedPostings;
+        vector<PostingChange> removedPostings;
+        size_t subtreesSkipped = 0;     // Subtrees found equal by hash, not visited
+        size_t accountsInspected = 0;   // Accounts in both states compared field by field
+    };
+
+private:
+    /***** Helper Functions *****/
+    /*------------------------------------------------------------------------
+      descend compares two accounts with the same number and, when their
+      subtree hashes differ, merges their children by number: equal numbers
+      descend, the others are added or removed with their subtrees.
+
+      Precondition:  Both accounts have the same number.
+      Post-condition: The differences below them are appended to report.
+    -----------------------------------------------------------------------*/
+    static void descend(const ForestTree &before, const ForestTree &after, const Account *was,
+                        const Account *now, Report &report);
+
+    static void mergeChildren(const ForestTree &before, const ForestTree &after, const vector<Account *> &was,
+                              const vector<Account *> &now, Report &report);
+
+    /*------------------------------------------------------------------------
+      collect appends an account and every account below it (in printTree
+      order); inspect appends the description, balance and posting changes
+      of two accounts with the same number.
+
+      Precondition:  The accounts belong to the trees given.
+      Post-condition: The entries are appended.
+    -----------------------------------------------------------------------*/
+    static void collect(const ForestTree &tree, const Account *account, vector<AccountChange> &out);
+
+    static void inspect(const Account &before, const Account &after, Report &report);
+
+    /*------------------------------------------------------------------------
+      Compares the postings of an account present in both states.
+
+      Precondition:  Both accounts have the same number.
+      Post-condition: The added and removed postings are appended to report.
+    -----------------------------------------------------------------------*/
+    static void diffPostings(const Account &before, const Account &after, Report &report);
+
+public:
+    /***** Compare *****/
+    /*------------------------------------------------------------------------
+      Compares two ledger states.
+
+      Precondition:  Neither tree changes during the call.
+      Post-condition: Returns every difference, each list in printTree order
+                      (postings in ledger order within an account).
+    -----------------------------------------------------------------------*/
+    static Report compare(const ForestTree &before, const ForestTree &after);
+
+    static bool isEmpty(const Report &report);
+
+    /***** Report *****/
+    static string formatReport(const Report &report);
+};
+
+#endif // LEDGERDIFF_H
@@ -0,0 +1,67 @@
+#ifndef LEDGERHASH_H
+#define LEDGERHASH_H
+
+/**-- LedgerHash.h ----------------------------------------------------------
+  This header file defines the hash terms of the account hierarchy's
+  subtree hashes (Account::getSubtreeHash).
+
+  Every account contributes one term for its identity (number, description
+  and opening balance) and one per posting (account number, amount in
+  cents, type and date; not the transaction ID, which a removal renumbers
+  for every later posting, so a removal changes the hash by one term). The
+  subtree hash of an account is
+  the sum, modulo 2^64, of the terms of the account and of every account
+  below it: a parent's hash is its own terms plus its children's hashes.
+  Because the combination is a sum, a posting changes every hash on its
+  ancestor chain by the same term, added in the walk that updates the
+  balances; no hash below the changed account is touched.
+
+  Balances are not hashed: they follow from the opening balances and the
+  postings. The hashes detect divergence between copies of a ledger (e.g.
+  a standby replica); they are not a defence against deliberate forgery.
+
+  Basic operations:
+    mix:            Mixes a value into a hash (splitmix64 finalizer).
+    accountTerm:    Term of an account's number, description and opening balance.
+    postingTerm:    Term of one posting.
+--------------------------------------------------------------------------**/
+
+#include <cmath>
+#include <cstdint>
+#include <string_view>
+
+namespace LedgerHash {
+
+    inline uint64_t mix(uint64_t hash, uint64_t value) {
+        uint64_t z = hash + value + 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    inline uint64_t cents(double amount) {
+        return static_cast<uint64_t>(std::llround(amount * 100.0));
+    }
+
+    /*------------------------------------------------------------------------
+      Return the hash term of an account's identity or of one posting.
+
+      Precondition:  None.
+      Post-condition: Equal inputs give equal terms; amounts count in cents.
+    -----------------------------------------------------------------------*/
+    inline uint64_t accountTerm(int accountNumber, std::string_view description, double openingBalance) {
+        uint64_t text = 14695981039346656037ULL;    // FNV-1a over the description
+        for (char c: description) {
+            text = (text ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+        }
+        return mix(mix(mix(1, static_cast<uint64_t>(accountNumber)), text), cents(openingBalance));
+    }
+
+    inline uint64_t postingTerm(int accountNumber, double amount, char debitOrCredit, int date) {
+        uint64_t when = (static_cast<uint64_t>(static_cast<uint32_t>(date)) << 8) |
+                        static_cast<unsigned char>(debitOrCredit);
+        return mix(mix(mix(2, static_cast<uint64_t>(accountNumber)), cents(amount)), when);
+    }
+}
+
+#endif // LEDGERHASH_H
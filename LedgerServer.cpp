@@ -0,0 +1,415 @@
+#include "LedgerServer.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+    const uint64_t LISTENER_ID = 0;
+    const uint64_t WAKE_ID = 1;
+    const size_t READ_CHUNK = 64 * 1024;
+    const size_t MAX_PENDING_OUTPUT = 4 * 1024 * 1024;    // Stop reading while this much is unsent
+
+    runtime_error systemError(const string &what) {
+        return runtime_error(what + ": " + strerror(errno));
+    }
+}
+
+// Constructor binding the server to a tree and a configuration
+LedgerServer::LedgerServer(ForestTree &tree, const Config &config) : tree(tree), config(config) {
+    if (this->config.workers == 0) {
+        this->config.workers = max(1u, thread::hardware_concurrency());
+    }
+}
+
+// Destructor stopping the server
+LedgerServer::~LedgerServer() {
+    stop();
+}
+
+// Creates the listening socket
+void LedgerServer::openListener() {
+    if (!config.unixPath.empty()) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (config.unixPath.size() >= sizeof(address.sun_path)) {
+            throw runtime_error("Unix socket path too long: " + config.unixPath);
+        }
+        strcpy(address.sun_path, config.unixPath.c_str());
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) throw systemError("socket");
+        unlink(config.unixPath.c_str()); // Replace a stale socket file
+        if (bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+            throw systemError("bind " + config.unixPath);
+        }
+    } else {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(config.port));
+        if (inet_pton(AF_INET, config.host.c_str(), &address.sin_addr) != 1) {
+            throw runtime_error("Invalid address: " + config.host);
+        }
+
+        listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) throw systemError("socket");
+        int on = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+            throw systemError("bind " + config.host + ":" + to_string(config.port));
+        }
+        socklen_t length = sizeof(address);
+        getsockname(listenFd, reinterpret_cast<sockaddr *>(&address), &length);
+        boundPort = ntohs(address.sin_port);
+    }
+
+    if (listen(listenFd, SOMAXCONN) < 0) throw systemError("listen");
+}
+
+// Listens and starts the event loop and the workers
+void LedgerServer::start() {
+    if (running) {
+        throw runtime_error("Server already running");
+    }
+
+    try {
+        openListener();
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0) throw systemError("epoll_create1");
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeFd < 0) throw systemError("eventfd");
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = LISTENER_ID;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) < 0) throw systemError("epoll_ctl");
+        event.data.u64 = WAKE_ID;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) < 0) throw systemError("epoll_ctl");
+    } catch (...) {
+        stop();
+        throw;
+    }
+
+    running = true;
+    for (size_t i = 0; i < config.workers; ++i) {
+        workers.emplace_back(&LedgerServer::workerLoop, this);
+    }
+    loopThread = thread(&LedgerServer::eventLoop, this);
+}
+
+// Closes every connection and joins every thread
+void LedgerServer::stop() {
+    {
+        // Cleared under the queue lock so a worker cannot check `running` and then miss the notify
+        lock_guard<mutex> lock(queueMutex);
+        running = false;
+    }
+    if (wakeFd >= 0) {
+        uint64_t one = 1;
+        (void) !write(wakeFd, &one, sizeof(one));
+    }
+    queueReady.notify_all();
+    if (loopThread.joinable()) loopThread.join();
+    for (thread &worker: workers) worker.join();
+    workers.clear();
+
+    for (auto &entry: connections) {
+        if (!entry.second->closed) close(entry.second->fd);
+    }
+    connections.clear();
+    activeCount = 0;
+    queue.clear();
+    completions.clear();
+
+    if (listenFd >= 0) {
+        close(listenFd);
+        if (!config.unixPath.empty()) unlink(config.unixPath.c_str());
+    }
+    if (epollFd >= 0) close(epollFd);
+    if (wakeFd >= 0) close(wakeFd);
+    listenFd = epollFd = wakeFd = -1;
+}
+
+// Accepts, reads, dispatches and writes until stopped
+void LedgerServer::eventLoop() {
+    epoll_event events[256];
+    char buffer[READ_CHUNK];
+
+    while (running) {
+        int ready = epoll_wait(epollFd, events, 256, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            uint64_t id = events[i].data.u64;
+
+            if (id == LISTENER_ID) { // Accept every pending connection
+                int fd;
+                while ((fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    if (config.unixPath.empty()) {
+                        int on = 1;
+                        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                    }
+                    uint64_t connectionId = nextConnectionId++;
+                    auto connection = make_unique<Connection>(connectionId, fd, tree, config);
+                    epoll_event event{};
+                    event.events = EPOLLIN;
+                    event.data.u64 = connectionId;
+                    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+                        close(fd);
+                        continue;
+                    }
+                    connection->interest = EPOLLIN;
+                    connections.emplace(connectionId, move(connection));
+                    ++acceptedCount;
+                    ++activeCount;
+                }
+                continue;
+            }
+
+            vector<uint64_t> touched;
+            if (id == WAKE_ID) { // Collect finished batches
+                uint64_t count;
+                (void) !read(wakeFd, &count, sizeof(count));
+                if (!running) break;
+
+                vector<Completion> finished;
+                {
+                    lock_guard<mutex> lock(completionMutex);
+                    finished.swap(completions);
+                }
+                for (Completion &completion: finished) {
+                    auto it = connections.find(completion.connectionId);
+                    if (it == connections.end()) continue;
+                    Connection &connection = *it->second;
+                    connection.busy = false;
+                    if (connection.closed) {
+                        connections.erase(it);
+                        continue;
+                    }
+                    if (connection.output.empty()) {
+                        connection.output.swap(completion.output);
+                        connection.outputOffset = 0;
+                    } else {
+                        connection.output += completion.output;
+                    }
+                    touched.push_back(completion.connectionId);
+                }
+            } else {
+                auto it = connections.find(id);
+                if (it == connections.end() || it->second->closed) continue;
+                Connection &connection = *it->second;
+
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    closeConnection(id);
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) {
+                    bool failed = false;
+                    while (true) {
+                        ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+                        if (received > 0) {
+                            connection.input.append(buffer, static_cast<size_t>(received));
+                            if (static_cast<size_t>(received) < sizeof(buffer)) break;
+                        } else if (received == 0) {
+                            connection.peerClosed = true;
+                            if (!connection.input.empty() && connection.input.back() != '\n') {
+                                connection.input += '\n'; // Run a final unterminated command
+                            }
+                            break;
+                        } else if (errno == EINTR) {
+                            continue;
+                        } else {
+                            failed = (errno != EAGAIN && errno != EWOULDBLOCK);
+                            break;
+                        }
+                    }
+                    size_t lastNewline = connection.input.rfind('\n');
+                    size_t unterminated = (lastNewline == string::npos) ? connection.input.size()
+                                                                        : connection.input.size() - lastNewline - 1;
+                    if (failed || unterminated > config.maxLineBytes) {
+                        closeConnection(id);
+                        continue;
+                    }
+                }
+                touched.push_back(id);
+            }
+
+            // Dispatch new lines, write replies and re-arm each affected connection
+            for (uint64_t connectionId: touched) {
+                auto it = connections.find(connectionId);
+                if (it == connections.end()) continue;
+                Connection &connection = *it->second;
+                if (!connection.busy && connection.output.size() - connection.outputOffset < MAX_PENDING_OUTPUT) {
+                    dispatch(connection);
+                }
+                if (!flush(connection)) {
+                    closeConnection(connectionId);
+                    continue;
+                }
+                if (connection.peerClosed && !connection.busy && connection.input.empty() &&
+                    connection.outputOffset == connection.output.size()) {
+                    closeConnection(connectionId);
+                    continue;
+                }
+                updateInterest(connection);
+            }
+        }
+    }
+}
+
+// Runs dispatched batches
+void LedgerServer::workerLoop() {
+    while (true) {
+        Batch batch;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueReady.wait(lock, [this] { return !running || !queue.empty(); });
+            if (!running) return;
+            batch = move(queue.front());
+            queue.pop_front();
+        }
+
+        string output;
+        uint64_t executed = 0;
+        string_view pending(batch.lines);
+        while (!pending.empty()) {
+            size_t newline = pending.find('\n');
+            string_view line = pending.substr(0, newline);
+            pending.remove_prefix(newline + 1);
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            if (!BatchRunner::isCommand(line)) continue;
+
+            if (BatchRunner::isReadOnly(line)) {
+                shared_lock<shared_mutex> lock(treeMutex);
+                output += batch.runner->execute(line);
+            } else {
+                unique_lock<shared_mutex> lock(treeMutex);
+                output += batch.runner->execute(line);
+            }
+            output += '\n';
+            ++executed;
+        }
+        requestCount += executed;
+
+        {
+            lock_guard<mutex> lock(completionMutex);
+            completions.push_back({batch.connectionId, move(output)});
+        }
+        uint64_t one = 1;
+        (void) !write(wakeFd, &one, sizeof(one));
+    }
+}
+
+// Hands a connection's complete lines to the worker pool
+void LedgerServer::dispatch(Connection &connection) {
+    size_t lastNewline = connection.input.rfind('\n');
+    if (lastNewline == string::npos) {
+        return;
+    }
+
+    Batch batch{connection.id, &connection.runner, string()};
+    if (lastNewline + 1 == connection.input.size()) {
+        batch.lines.swap(connection.input);
+    } else {
+        batch.lines.assign(connection.input, 0, lastNewline + 1);
+        connection.input.erase(0, lastNewline + 1);
+    }
+    connection.busy = true;
+
+    {
+        lock_guard<mutex> lock(queueMutex);
+        queue.push_back(move(batch));
+    }
+    queueReady.notify_one();
+}
+
+// Writes as much of a connection's replies as the socket takes; false on a socket error
+bool LedgerServer::flush(Connection &connection) {
+    while (connection.outputOffset < connection.output.size()) {
+        ssize_t sent = send(connection.fd, connection.output.data() + connection.outputOffset,
+                            connection.output.size() - connection.outputOffset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection.outputOffset += static_cast<size_t>(sent);
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+
+    if (connection.outputOffset == connection.output.size()) {
+        connection.output.clear();
+        connection.outputOffset = 0;
+    } else if (connection.outputOffset > connection.output.size() / 2) {
+        connection.output.erase(0, connection.outputOffset);
+        connection.outputOffset = 0;
+    }
+    return true;
+}
+
+// Re-arms the epoll events a connection waits for
+void LedgerServer::updateInterest(Connection &connection) {
+    size_t unsent = connection.output.size() - connection.outputOffset;
+    uint32_t interest = 0;
+    if (!connection.peerClosed && unsent < MAX_PENDING_OUTPUT) {
+        interest |= EPOLLIN;
+    }
+    if (unsent > 0) {
+        interest |= EPOLLOUT;
+    }
+    if (interest != connection.interest) {
+        epoll_event event{};
+        event.events = interest;
+        event.data.u64 = connection.id;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+        connection.interest = interest;
+    }
+}
+
+// Removes a connection; one with a batch in flight is freed when the batch completes
+void LedgerServer::closeConnection(uint64_t id) {
+    auto it = connections.find(id);
+    if (it == connections.end() || it->second->closed) {
+        return;
+    }
+    Connection &connection = *it->second;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.fd, nullptr);
+    close(connection.fd);
+    --activeCount;
+    if (connection.busy) {
+        connection.closed = true;
+    } else {
+        connections.erase(it);
+    }
+}
+
+// Returns the TCP port bound
+int LedgerServer::getPort() const {
+    return boundPort;
+}
+
+// Returns the lock on the tree
+shared_mutex &LedgerServer::getTreeMutex() {
+    return treeMutex;
+}
+
+// Returns the connections and requests served so far
+LedgerServer::Stats LedgerServer::getStats() const {
+    return {acceptedCount.load(), activeCount.load(), requestCount.load()};
+}
@@ -0,0 +1,201 @@
+#ifndef LEDGERSERVER_H
+#define LEDGERSERVER_H
+
+/**-- LedgerServer.h --------------------------------------------------------
+  This header file defines the LedgerServer class, a long-running server that
+  shares one in-memory ForestTree between many local clients over a Unix
+  domain socket or localhost TCP (Linux only).
+
+  Protocol: the BatchRunner line protocol. A client sends commands, one per
+  line, and receives one JSON line per command, in order; "seq" counts the
+  commands of the connection. Clients may pipeline any number of commands
+  without waiting for replies.
+
+  Threading: one event-loop thread does all socket I/O with epoll
+  (non-blocking sockets, level-triggered). Complete lines of a connection are
+  handed, as one batch, to a fixed worker pool; a connection has at most one
+  batch in flight, which keeps its replies in order. Workers run read-only
+  commands (BatchRunner::isReadOnly) under a shared lock on the tree and all other commands under an exclusive lock, so
+  queries from different clients run in parallel. Replies travel back to the
+  event loop through a completion queue and an eventfd.
+
+  Replication: with a ReplicationLog in the configuration, a primary appends
+  each successful mutation to the log under the exclusive lock (LogShipper
+  streams it to replicas), and a replica rejects mutations from its clients
+  while its LogFollower applies the primary's log under the same lock
+  (getTreeMutex).
+
+  File access: export and diff would let any client read and write files as
+  the server process (over TCP, from anywhere that can connect). The server
+  therefore confines them (BatchRunner::confineFiles) to `fileDirectory`,
+  where they take plain file names; they are rejected when it is empty, the
+  default.
+
+  Basic operations:
+    Constructor:   Binds the server to a tree and a configuration.
+    Destructor:    Stops the server.
+    start:         Listens and starts the event loop and the workers.
+    stop:          Closes every connection and joins every thread.
+    getPort:       TCP port bound (useful with port 0).
+    getStats:      Connections and requests served so far.
+    getTreeMutex:  The lock on the tree, for a LogFollower applying alongside.
+
+  Helper functions:
+    openListener:  Creates the listening socket.
+    eventLoop:     Accepts, reads, dispatches and writes until stopped.
+    workerLoop:    Runs dispatched batches.
+    dispatch:      Hands a connection's complete lines to the worker pool.
+    flush:         Writes as much of a connection's replies as the socket takes.
+    updateInterest: Re-arms the epoll events a connection waits for.
+    closeConnection: Removes a connection.
+
+  Class Invariant:
+    1. Only the event-loop thread touches `connections` and socket buffers.
+    2. A connection has at most one batch queued or running at a time.
+    3. Every access to the tree holds `treeMutex`.
+--------------------------------------------------------------------------**/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "BatchRunner.h"
+#include "ForestTree.h"
+
+using namespace std;
+
+class LedgerServer {
+public:
+    struct Config {
+        string unixPath;                  // Unix domain socket path; TCP is used when empty
+        string host = "127.0.0.1";        // TCP address to bind
+        int port = 0;                     // TCP port (0 picks a free port)
+        size_t workers = 0;               // Worker threads (0 = hardware concurrency)
+        size_t maxLineBytes = 64 * 1024;  // Longer lines close the connection
+        ReplicationLog *log = nullptr;    // Replication log of a primary or replica (none if null)
+        string fileDirectory;             // Only directory export and diff reach (disabled if empty)
+    };
+
+    struct Stats {
+        uint64_t accepted;                // Connections accepted
+        uint64_t active;                  // Connections open
+        uint64_t requests;                // Commands executed
+    };
+
+private:
+    struct Connection {
+        uint64_t id;
+        int fd;
+        BatchRunner runner;               // Per-connection sequence numbers
+        string input;                     // Received bytes not yet dispatched
+        string output;                    // Replies not yet written
+        size_t outputOffset = 0;          // Bytes of `output` already written
+        bool busy = false;                // A batch is queued or running
+        bool peerClosed = false;          // Close once the last reply is written
+        bool closed = false;              // Socket closed; freed when the batch in flight completes
+        uint32_t interest = 0;            // epoll events currently armed
+
+        Connection(uint64_t id, int fd, ForestTree &tree, const Config &config) : id(id), fd(fd), runner(tree) {
+            runner.setLog(config.log);
+            runner.confineFiles(config.fileDirectory);
+        }
+    };
+
+    struct Batch {
+        uint64_t connectionId;
+        BatchRunner *runner;
+        string lines;                     // Complete lines, newline-terminated
+    };
+
+    struct Completion {
+        uint64_t connectionId;
+        string output;
+    };
+
+    ForestTree &tree;
+    Config config;
+    shared_mutex treeMutex;
+
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;                      // eventfd: completions are ready, or stop
+    int boundPort = 0;
+    atomic<bool> running{false};
+    thread loopThread;
+    vector<thread> workers;
+
+    unordered_map<uint64_t, unique_ptr<Connection>> connections;
+    uint64_t nextConnectionId = 2;        // 0 and 1 tag the listener and the eventfd
+
+    mutex queueMutex;
+    condition_variable queueReady;
+    deque<Batch> queue;                   // Batches waiting for a worker
+
+    mutex completionMutex;
+    vector<Completion> completions;       // Replies waiting for the event loop
+
+    atomic<uint64_t> acceptedCount{0};
+    atomic<uint64_t> activeCount{0};
+    atomic<uint64_t> requestCount{0};
+
+    void openListener();
+
+    void eventLoop();
+
+    void workerLoop();
+
+    void dispatch(Connection &connection);
+
+    bool flush(Connection &connection);
+
+    void updateInterest(Connection &connection);
+
+    void closeConnection(uint64_t id);
+
+public:
+    /***** Constructor *****/
+    LedgerServer(ForestTree &tree, const Config &config);
+
+    /***** Destructor *****/
+    ~LedgerServer();
+
+    LedgerServer(const LedgerServer &) = delete;
+
+    LedgerServer &operator=(const LedgerServer &) = delete;
+
+    /***** Start / Stop *****/
+    /*------------------------------------------------------------------------
+      Starts listening and serving, or stops and joins every thread. The tree
+      must not be used directly while the server runs.
+
+      Precondition:  start: the server is stopped and the address is free.
+      Post-condition: start: the server accepts connections; throws
+                      runtime_error if the socket cannot be set up.
+                      stop: every connection is closed (a Unix socket file is
+                      removed).
+    -----------------------------------------------------------------------*/
+    void start();
+
+    void stop();
+
+    /***** Accessors *****/
+    int getPort() const;
+
+    Stats getStats() const;
+
+    /*------------------------------------------------------------------------
+      Returns the lock the workers take on the tree (shared for read-only
+      commands, exclusive otherwise), so another thread may change the tree
+      while the server runs by holding it exclusively.
+    -----------------------------------------------------------------------*/
+    shared_mutex &getTreeMutex();
+};
+
+#endif // LEDGERSERVER_H
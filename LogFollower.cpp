@@ -0,0 +1,167 @@
+#include "LogFollower.h"
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+    const int POLL_MILLIS = 100;              // How often a blocked follower checks for stop
+    const size_t READ_CHUNK = 64 * 1024;
+
+    // Opens a connection to the primary's Unix socket; -1 if it is not reachable
+    int connectTo(const string &path) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) return -1;
+        strcpy(address.sun_path, path.c_str());
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+            close(fd);
+            fd = -1;
+        }
+        return fd;
+    }
+}
+
+// Constructor binding the follower to a tree, its lock, a log and a configuration
+LogFollower::LogFollower(ForestTree &tree, shared_mutex &treeMutex, ReplicationLog &log, const Config &config)
+        : treeMutex(treeMutex), log(log), config(config), runner(tree) {}
+
+// Destructor stopping the follower
+LogFollower::~LogFollower() {
+    stop();
+}
+
+// Starts following the primary in a background thread
+void LogFollower::start() {
+    if (running) {
+        throw runtime_error("Log follower already running");
+    }
+    if (!log.isFollower()) {
+        throw runtime_error("A follower needs a replica log");
+    }
+    running = true;
+    following = true;
+    followThread = thread(&LogFollower::followLoop, this);
+}
+
+// Disconnects and joins the thread
+void LogFollower::stop() {
+    running = false;
+    if (followThread.joinable()) followThread.join();
+}
+
+// Returns whether the follower has not stopped for good
+bool LogFollower::isFollowing() const {
+    return following;
+}
+
+// Connects, reconnects after a drop and applies until stopped or until following is impossible
+void LogFollower::followLoop() {
+    while (running) {
+        int fd = connectTo(config.primaryPath);
+        if (fd >= 0) {
+            bool keep = follow(fd);
+            close(fd);
+            if (!keep) {
+                following = false;
+                return;
+            }
+            log.setConnected(false);
+        }
+        for (int waited = 0; running && waited < config.retryMillis; waited += 10) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+    }
+}
+
+// Runs one connection; returns false if the replica must stop following for good
+bool LogFollower::follow(int fd) {
+    char request[64];
+    snprintf(request, sizeof(request), "follow %016" PRIx64 " %" PRIu64 "\n", log.getEpoch(), log.getHead());
+    if (send(fd, request, strlen(request), MSG_NOSIGNAL) < 0) {
+        return true;
+    }
+
+    string input;
+    char buffer[READ_CHUNK];
+    int64_t lastMessage = ReplicationLog::nowMicros();
+    while (running) {
+        pollfd ready{fd, POLLIN, 0};
+        int count = poll(&ready, 1, POLL_MILLIS);
+        if (count < 0 && errno != EINTR) return true;
+        if (count <= 0) {
+            if (ReplicationLog::nowMicros() - lastMessage > config.silenceMillis * 1000LL) return true;
+            continue;
+        }
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) return true;    // The primary went away; reconnect
+        input.append(buffer, static_cast<size_t>(received));
+        lastMessage = ReplicationLog::nowMicros();
+        if (!applyLines(input)) return false;
+    }
+    return true;
+}
+
+// Applies the complete lines received so far, their entries under one exclusive lock; false to stop for good
+bool LogFollower::applyLines(string &input) {
+    size_t end = input.rfind('\n');
+    if (end == string::npos) {
+        return true;
+    }
+
+    unique_lock<shared_mutex> guard(treeMutex, defer_lock);    // Taken at the first entry; heartbeats need none
+    size_t start = 0;
+    while (start <= end) {
+        size_t newline = input.find('\n', start);
+        string line = input.substr(start, newline - start);
+        start = newline + 1;
+
+        try {
+            uint64_t position = 0, epoch = 0, baseHash = 0;
+            int64_t micros = 0;
+            int offset = 0;
+            if (sscanf(line.c_str(), "entry %" SCNu64 " %" SCNd64 " %n", &position, &micros, &offset) == 2 &&
+                offset > 0) {
+                ReplicationLog::Entry entry{position, micros, line.substr(static_cast<size_t>(offset))};
+                if (!guard.owns_lock()) guard.lock();
+                if (position != log.getHead() + 1) {
+                    throw runtime_error("Log entry " + to_string(position) + " does not follow position " +
+                                        to_string(log.getHead()) + ".");
+                }
+                size_t failedBefore = runner.getStats().failed;
+                string result = runner.execute(entry.command);
+                if (runner.getStats().failed != failedBefore) {
+                    throw runtime_error("Log entry " + to_string(position) + " failed on the replica, which has "
+                                        "diverged from the primary: " + result);
+                }
+                log.mirror(entry);
+            } else if (sscanf(line.c_str(), "head %" SCNu64, &position) == 1) {
+                log.noteUpstream(position);
+            } else if (sscanf(line.c_str(), "hello %" SCNx64 " %" SCNx64 " %" SCNu64, &epoch, &baseHash,
+                              &position) == 3) {
+                log.adopt(epoch, baseHash);
+                log.setConnected(true);
+                log.noteUpstream(position);
+            } else if (line.rfind("error ", 0) == 0) {
+                throw runtime_error(line.substr(6));
+            } else {
+                throw runtime_error("Unexpected message from the primary: " + line);
+            }
+        } catch (const exception &e) {
+            log.fail(e.what());
+            return false;
+        }
+    }
+    input.erase(0, end + 1);
+    return true;
+}
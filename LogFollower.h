@@ -0,0 +1,99 @@
+#ifndef LOGFOLLOWER_H
+#define LOGFOLLOWER_H
+
+/**-- LogFollower.h ---------------------------------------------------------
+  This header file defines the LogFollower class, the replica's side of log
+  shipping: it connects to a primary's LogShipper over a Unix domain socket,
+  applies the primary's log to the replica's tree and mirrors it in the
+  replica's ReplicationLog (protocol in LogShipper.h).
+
+  Entries are applied in order through a BatchRunner, every entry received
+  in one read under a single exclusive lock on the tree, the lock the
+  replica's LedgerServer takes for writes; its clients keep reading between
+  batches. The position is recorded under the same lock, so a read that
+  sees position p sees the tree as the primary had it at p.
+
+  When the connection drops, the follower reconnects and resumes after the
+  last position applied. It stops for good, recording the reason in the log
+  (ReplicationLog::getStatus), when the primary cannot serve it (another
+  start chart, a restarted log, entries no longer retained) or an entry
+  fails on the replica, which means the two trees have diverged.
+
+  Basic operations:
+    Constructor:   Binds the follower to a tree, its lock, a log and a configuration.
+    Destructor:    Stops the follower.
+    start:         Starts following in a background thread.
+    stop:          Disconnects and joins the thread.
+    isFollowing:   Returns whether the follower has not stopped for good.
+
+  Helper functions:
+    followLoop:    Connects, reconnects and applies until stopped.
+    follow:        Runs one connection; returns false to stop for good.
+    applyLines:    Applies the complete lines received so far.
+
+  Class Invariant:
+    1. The tree is changed only under an exclusive lock on treeMutex.
+    2. Every entry applied is mirrored in the log before the lock is released.
+--------------------------------------------------------------------------**/
+
+#include <atomic>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include "BatchRunner.h"
+#include "ForestTree.h"
+#include "ReplicationLog.h"
+
+using namespace std;
+
+class LogFollower {
+public:
+    struct Config {
+        string primaryPath;               // Unix socket of the primary's LogShipper
+        int retryMillis = 200;            // Wait before reconnecting
+        int silenceMillis = 5000;         // Reconnect after this long without a message
+    };
+
+private:
+    shared_mutex &treeMutex;
+    ReplicationLog &log;
+    Config config;
+    BatchRunner runner;                   // Applies entries; no log, so entries are not re-appended
+    atomic<bool> running{false};
+    atomic<bool> following{false};
+    thread followThread;
+
+    void followLoop();
+
+    bool follow(int fd);
+
+    bool applyLines(string &input);
+
+public:
+    /***** Constructor *****/
+    LogFollower(ForestTree &tree, shared_mutex &treeMutex, ReplicationLog &log, const Config &config);
+
+    /***** Destructor *****/
+    ~LogFollower();
+
+    LogFollower(const LogFollower &) = delete;
+
+    LogFollower &operator=(const LogFollower &) = delete;
+
+    /***** Start / Stop *****/
+    /*------------------------------------------------------------------------
+      Starts following the primary, or disconnects and joins the thread.
+
+      Precondition:  start: the follower is stopped; the log's role is
+                     REPLICA and its base hash is the tree's getTreeHash.
+      Post-condition: start: the tree follows the primary's log, connecting
+                      (and reconnecting) in the background.
+    -----------------------------------------------------------------------*/
+    void start();
+
+    void stop();
+
+    bool isFollowing() const;
+};
+
+#endif // LOGFOLLOWER_H
@@ -0,0 +1,202 @@
+#include "LogShipper.h"
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+    const int POLL_MILLIS = 100;              // How often blocked threads check for stop
+    const int HANDSHAKE_MILLIS = 5000;        // Time a replica has to send its follow line
+    const size_t MAX_REQUEST_BYTES = 256;
+
+    runtime_error systemError(const string &what) {
+        return runtime_error(what + ": " + strerror(errno));
+    }
+
+    // Reads the replica's follow line; false on timeout, error or malformed request
+    bool readFollow(int fd, const atomic<bool> &running, uint64_t &epoch, uint64_t &position) {
+        string request;
+        int waited = 0;
+        while (request.find('\n') == string::npos) {
+            if (!running || waited >= HANDSHAKE_MILLIS || request.size() > MAX_REQUEST_BYTES) return false;
+            pollfd ready{fd, POLLIN, 0};
+            int count = poll(&ready, 1, POLL_MILLIS);
+            waited += POLL_MILLIS;
+            if (count < 0 && errno != EINTR) return false;
+            if (count <= 0) continue;
+            char buffer[MAX_REQUEST_BYTES];
+            ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+            if (received <= 0) return false;
+            request.append(buffer, static_cast<size_t>(received));
+        }
+        return sscanf(request.c_str(), "follow %" SCNx64 " %" SCNu64, &epoch, &position) == 2;
+    }
+}
+
+// Constructor binding the shipper to a log and a configuration
+LogShipper::LogShipper(ReplicationLog &log, const Config &config) : log(log), config(config) {}
+
+// Destructor stopping the shipper
+LogShipper::~LogShipper() {
+    stop();
+}
+
+// Listens on the Unix socket and starts accepting replicas
+void LogShipper::start() {
+    if (running) {
+        throw runtime_error("Log shipper already running");
+    }
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (config.unixPath.empty() || config.unixPath.size() >= sizeof(address.sun_path)) {
+        throw runtime_error("Invalid Unix socket path: " + config.unixPath);
+    }
+    strcpy(address.sun_path, config.unixPath.c_str());
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) throw systemError("socket");
+    unlink(config.unixPath.c_str()); // Replace a stale socket file
+    if (bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+        listen(listenFd, SOMAXCONN) < 0) {
+        runtime_error error = systemError("bind " + config.unixPath);
+        close(listenFd);
+        listenFd = -1;
+        throw error;
+    }
+
+    running = true;
+    acceptThread = thread(&LogShipper::acceptLoop, this);
+}
+
+// Disconnects every replica and joins every thread
+void LogShipper::stop() {
+    running = false;
+    if (acceptThread.joinable()) acceptThread.join();
+    {
+        lock_guard<mutex> guard(replicaMutex);
+        for (int fd: replicas) shutdown(fd, SHUT_RDWR); // Unblocks a send to a stalled replica
+    }
+    for (thread &sender: senders) sender.join();
+    senders.clear();
+    finished.clear();
+
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(config.unixPath.c_str());
+        listenFd = -1;
+    }
+}
+
+// Accepts replicas until stopped, one sending thread each
+void LogShipper::acceptLoop() {
+    while (running) {
+        reapSenders();
+        pollfd ready{listenFd, POLLIN, 0};
+        if (poll(&ready, 1, POLL_MILLIS) <= 0) continue;
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        lock_guard<mutex> guard(replicaMutex);
+        replicas.push_back(fd);
+        senders.emplace_back(&LogShipper::serve, this, fd);
+        ++acceptedCount;
+        ++activeCount;
+    }
+}
+
+// Handshakes with one replica, then streams the log to it until it leaves or the shipper stops
+void LogShipper::serve(int fd) {
+    uint64_t replicaEpoch = 0, position = 0;
+    if (readFollow(fd, running, replicaEpoch, position)) {
+        char line[128];
+        uint64_t epoch = log.getEpoch();
+        if (replicaEpoch != 0 && replicaEpoch != epoch) {
+            sendAll(fd, "error The primary restarted with a new log; restart the replica.\n");
+        } else {
+            snprintf(line, sizeof(line), "hello %016" PRIx64 " %016" PRIx64 " %" PRIu64 "\n", epoch,
+                     log.getBaseHash(), log.getHead());
+            bool open = sendAll(fd, line);
+
+            vector<ReplicationLog::Entry> entries;
+            string batch;
+            chrono::milliseconds heartbeat(config.heartbeatMillis);
+            while (open && running) {
+                if (!log.read(position, config.batchEntries, entries, heartbeat)) {
+                    sendAll(fd, "error The entries after position " + to_string(position) +
+                                " are not retained by the primary.\n");
+                    break;
+                }
+                batch.clear();
+                if (entries.empty()) {
+                    snprintf(line, sizeof(line), "head %" PRIu64 " %" PRId64 "\n", log.getHead(),
+                             ReplicationLog::nowMicros());
+                    batch = line;
+                }
+                for (const ReplicationLog::Entry &entry: entries) {
+                    snprintf(line, sizeof(line), "entry %" PRIu64 " %" PRId64 " ", entry.position,
+                             entry.appendedMicros);
+                    batch += line;
+                    batch += entry.command;
+                    batch += '\n';
+                }
+                open = sendAll(fd, batch);
+                if (!entries.empty()) {
+                    position = entries.back().position;
+                    sentCount += entries.size();
+                }
+            }
+        }
+    }
+
+    lock_guard<mutex> guard(replicaMutex);
+    replicas.erase(find(replicas.begin(), replicas.end(), fd));
+    close(fd);
+    --activeCount;
+    finished.push_back(this_thread::get_id());
+}
+
+// Joins the sending threads of replicas that have left, outside the lock
+void LogShipper::reapSenders() {
+    vector<thread> done;
+    {
+        lock_guard<mutex> guard(replicaMutex);
+        for (thread::id id: finished) {
+            auto sender = find_if(senders.begin(), senders.end(), [id](const thread &t) { return t.get_id() == id; });
+            if (sender != senders.end()) {
+                done.push_back(move(*sender));
+                senders.erase(sender);
+            }
+        }
+        finished.clear();
+    }
+    for (thread &sender: done) sender.join();
+}
+
+// Writes a whole buffer to a socket; false once the peer is gone
+bool LogShipper::sendAll(int fd, const string &data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t sent = send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            offset += static_cast<size_t>(sent);
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns the replicas connected and entries sent so far
+LogShipper::Stats LogShipper::getStats() const {
+    return {acceptedCount.load(), activeCount.load(), sentCount.load()};
+}
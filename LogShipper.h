@@ -0,0 +1,124 @@
+#ifndef LOGSHIPPER_H
+#define LOGSHIPPER_H
+
+/**-- LogShipper.h ----------------------------------------------------------
+  This header file defines the LogShipper class, the primary's side of log
+  shipping: it streams a ReplicationLog to replica processes (LogFollower)
+  over a Unix domain socket (Linux only).
+
+  Protocol (text lines):
+    replica:  follow <epoch> <position>
+                  epoch in hexadecimal, 0 for a replica that has applied
+                  nothing; entries after <position> are wanted.
+    primary:  hello <epoch> <baseHash> <head>
+              entry <position> <appendedMicros> <command>
+              head <position> <micros>
+                  heartbeat, sent when no entry was appended for a while.
+              error <message>
+                  e.g. the entries asked for are no longer retained; the
+                  connection is closed.
+  Epochs and hashes are 16 hexadecimal digits.
+
+  Threading: one thread accepts replicas; each replica has its own sending
+  thread that waits on the log. A slow replica only holds up its own thread:
+  the primary's workers append to the log and never wait for replicas. The
+  accepting thread joins the sending threads of replicas that have left, so
+  reconnecting replicas do not accumulate finished threads.
+
+  Basic operations:
+    Constructor:   Binds the shipper to a log and a configuration.
+    Destructor:    Stops the shipper.
+    start:         Listens and starts accepting replicas.
+    stop:          Disconnects every replica and joins every thread.
+    getStats:      Replicas connected and entries sent so far.
+
+  Helper functions:
+    acceptLoop:    Accepts replicas until stopped.
+    serve:         Handshakes with one replica, then streams the log to it.
+    reapSenders:   Joins the sending threads of replicas that have left.
+    sendAll:       Writes a whole buffer to a socket.
+
+  Class Invariant:
+    1. `replicas` holds the socket of every replica being served, under
+       replicaMutex.
+    2. `senders` holds every sending thread not yet joined; `finished` lists
+       those that have returned, or are about to, under replicaMutex.
+--------------------------------------------------------------------------**/
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ReplicationLog.h"
+
+using namespace std;
+
+class LogShipper {
+public:
+    struct Config {
+        string unixPath;                  // Socket replicas connect to
+        int heartbeatMillis = 200;        // Heartbeat interval when the log is idle
+        size_t batchEntries = 1024;       // Entries read from the log per send
+    };
+
+    struct Stats {
+        uint64_t accepted;                // Replica connections accepted
+        uint64_t active;                  // Replicas being served
+        uint64_t entriesSent;             // Entries sent to all replicas
+    };
+
+private:
+    ReplicationLog &log;
+    Config config;
+    int listenFd = -1;
+    atomic<bool> running{false};
+    thread acceptThread;
+
+    mutex replicaMutex;
+    vector<int> replicas;                 // Sockets of the replicas being served
+    vector<thread> senders;               // Sending threads not yet joined
+    vector<thread::id> finished;          // Senders whose replica has left
+
+    atomic<uint64_t> acceptedCount{0};
+    atomic<uint64_t> activeCount{0};
+    atomic<uint64_t> sentCount{0};
+
+    void acceptLoop();
+
+    void serve(int fd);
+
+    void reapSenders();
+
+    static bool sendAll(int fd, const string &data);
+
+public:
+    /***** Constructor *****/
+    LogShipper(ReplicationLog &log, const Config &config);
+
+    /***** Destructor *****/
+    ~LogShipper();
+
+    LogShipper(const LogShipper &) = delete;
+
+    LogShipper &operator=(const LogShipper &) = delete;
+
+    /***** Start / Stop *****/
+    /*------------------------------------------------------------------------
+      Starts accepting replicas, or disconnects them and joins every thread.
+
+      Precondition:  start: the shipper is stopped and the path is free.
+      Post-condition: start: replicas may connect; throws runtime_error if
+                      the socket cannot be set up. stop: the socket file is
+                      removed.
+    -----------------------------------------------------------------------*/
+    void start();
+
+    void stop();
+
+    /***** Accessors *****/
+    Stats getStats() const;
+};
+
+#endif // LOGSHIPPER_H
@@ -0,0 +1,61 @@
+#ifndef MEMORYUSAGE_H
+#define MEMORYUSAGE_H
+
+/**-- MemoryUsage.h ---------------------------------------------------------
+  This header file defines estimates of the heap memory held by standard
+  containers, used by the memoryBytes functions of the ledger classes and by
+  ForestTree::memoryStats.
+
+  Contiguous storage (vector, string) counts its capacity. Node-based
+  containers count one heap block per element, sized from the element and
+  the usual node layout of libstdc++ on a 64-bit target (tree nodes carry a
+  color and three links, hash nodes a next link and, for keys whose hash is
+  not trivial, the cached hash), plus the bucket array of hash containers.
+  Heap blocks are rounded as glibc malloc does (16-byte multiples with an
+  8-byte header, 32 bytes at least). The results are estimates, accurate to
+  the allocator's bookkeeping, not measurements.
+
+  Basic operations:
+    heapBlock:    Bytes of the heap block that holds a request.
+    vectorBytes:  Bytes reserved by a vector.
+    stringBytes:  Heap bytes of a string (0 when stored inline).
+    treeBytes:    Bytes of the nodes of a map or set.
+    hashBytes:    Bytes of the nodes and buckets of an unordered map or set.
+--------------------------------------------------------------------------**/
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace MemoryUsage {
+
+    inline size_t heapBlock(size_t bytes) {
+        size_t block = (bytes + 8 + 15) & ~static_cast<size_t>(15);
+        return block < 32 ? 32 : block;
+    }
+
+    template<typename T>
+    size_t vectorBytes(const std::vector<T> &values) {
+        return values.capacity() * sizeof(T);
+    }
+
+    inline size_t stringBytes(const std::string &text) {
+        return (text.capacity() > 15) ? heapBlock(text.capacity() + 1) : 0;
+    }
+
+    template<typename Tree>
+    size_t treeBytes(const Tree &tree) {
+        return tree.size() * heapBlock(32 + sizeof(typename Tree::value_type));
+    }
+
+    template<typename Hash>
+    size_t hashBytes(const Hash &hash) {
+        using Key = typename Hash::key_type;
+        size_t cachedHash = std::is_integral<Key>::value ? 0 : sizeof(size_t);
+        return hash.bucket_count() * sizeof(void *) +
+               hash.size() * heapBlock(sizeof(void *) + sizeof(typename Hash::value_type) + cachedHash);
+    }
+}
+
+#endif // MEMORYUSAGE_H
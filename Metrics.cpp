@@ -0,0 +1,260 @@
+#include "Metrics.h"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+    struct AtomicOperationStats {
+        atomic<uint64_t> calls{0};
+        atomic<uint64_t> errors{0};
+        atomic<uint64_t> totalNanos{0};
+        atomic<uint64_t> maxNanos{0};
+        atomic<uint64_t> buckets[Metrics::BUCKET_COUNT] = {};
+    };
+
+    struct Registry {
+        AtomicOperationStats operations[Metrics::OPERATION_COUNT];
+        atomic<uint64_t> counters[Metrics::COUNTER_COUNT] = {};
+    };
+
+    Registry &registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    const char *const COUNTER_NAMES[] = {"loader_bytes", "loader_lines", "loader_parse_errors"};
+}
+
+// Returns whether recording is compiled in
+bool Metrics::enabled() {
+#ifdef CHART_METRICS
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Returns the display name of an operation
+const char *Metrics::operationName(Operation operation) {
+    static const char *const names[] = {"addTransaction", "removeTransaction", "searchAccount", "addAccount",
+                                        "buildFromFile", "printTree", "postEntry"};
+    return names[operation];
+}
+
+// Maps a latency to its bucket: values below 4 get their own bucket, then
+// every power of two [2^e, 2^(e+1)) is split into four equal buckets
+int Metrics::bucketOf(uint64_t nanos) {
+    if (nanos < 4) {
+        return static_cast<int>(nanos);
+    }
+    int exponent = 63 - __builtin_clzll(nanos);
+    int sub = static_cast<int>((nanos >> (exponent - 2)) & 3);
+    return 4 * (exponent - 1) + sub;
+}
+
+// Returns the exclusive upper bound of a bucket in nanoseconds
+uint64_t Metrics::bucketUpperBound(int bucket) {
+    if (bucket < 4) {
+        return static_cast<uint64_t>(bucket) + 1;
+    }
+    if (bucket >= BUCKET_COUNT - 1) {
+        return UINT64_MAX;
+    }
+    int exponent = bucket / 4 + 1;
+    return static_cast<uint64_t>(5 + bucket % 4) << (exponent - 2);
+}
+
+// Records one call of an operation
+void Metrics::record(Operation operation, uint64_t nanos, bool succeeded) {
+#ifdef CHART_METRICS
+    AtomicOperationStats &stats = registry().operations[operation];
+    stats.calls.fetch_add(1, memory_order_relaxed);
+    if (!succeeded) {
+        stats.errors.fetch_add(1, memory_order_relaxed);
+    }
+    stats.totalNanos.fetch_add(nanos, memory_order_relaxed);
+    stats.buckets[bucketOf(nanos)].fetch_add(1, memory_order_relaxed);
+
+    uint64_t seen = stats.maxNanos.load(memory_order_relaxed);
+    while (nanos > seen && !stats.maxNanos.compare_exchange_weak(seen, nanos, memory_order_relaxed)) {
+    }
+#else
+    (void) operation;
+    (void) nanos;
+    (void) succeeded;
+#endif
+}
+
+// Adds to a loader counter
+void Metrics::add(Counter counter, uint64_t amount) {
+#ifdef CHART_METRICS
+    registry().counters[counter].fetch_add(amount, memory_order_relaxed);
+#else
+    (void) counter;
+    (void) amount;
+#endif
+}
+
+// Copies every metric
+Metrics::Snapshot Metrics::snapshot() {
+    Snapshot copy{};
+    Registry &source = registry();
+    for (int op = 0; op < OPERATION_COUNT; ++op) {
+        const AtomicOperationStats &from = source.operations[op];
+        OperationStats &to = copy.operations[op];
+        to.calls = from.calls.load(memory_order_relaxed);
+        to.errors = from.errors.load(memory_order_relaxed);
+        to.totalNanos = from.totalNanos.load(memory_order_relaxed);
+        to.maxNanos = from.maxNanos.load(memory_order_relaxed);
+        for (int b = 0; b < BUCKET_COUNT; ++b) {
+            to.buckets[b] = from.buckets[b].load(memory_order_relaxed);
+        }
+    }
+    for (int c = 0; c < COUNTER_COUNT; ++c) {
+        copy.counters[c] = source.counters[c].load(memory_order_relaxed);
+    }
+    return copy;
+}
+
+// Zeroes every metric
+void Metrics::reset() {
+    Registry &target = registry();
+    for (AtomicOperationStats &stats: target.operations) {
+        stats.calls.store(0, memory_order_relaxed);
+        stats.errors.store(0, memory_order_relaxed);
+        stats.totalNanos.store(0, memory_order_relaxed);
+        stats.maxNanos.store(0, memory_order_relaxed);
+        for (auto &bucket: stats.buckets) {
+            bucket.store(0, memory_order_relaxed);
+        }
+    }
+    for (auto &counter: target.counters) {
+        counter.store(0, memory_order_relaxed);
+    }
+}
+
+// Returns the latency below which the given fraction of calls fall
+uint64_t Metrics::OperationStats::percentile(double fraction) const {
+    uint64_t bucketed = 0;
+    for (uint64_t count: buckets) bucketed += count;
+    if (bucketed == 0) {
+        return 0;
+    }
+
+    double target = fraction * static_cast<double>(bucketed);
+    uint64_t cumulative = 0;
+    for (int b = 0; b < BUCKET_COUNT; ++b) {
+        cumulative += buckets[b];
+        if (static_cast<double>(cumulative) >= target && cumulative > 0) {
+            uint64_t bound = bucketUpperBound(b);
+            return bound < maxNanos ? bound : maxNanos;
+        }
+    }
+    return maxNanos;
+}
+
+// Renders a snapshot in Prometheus text exposition format
+string Metrics::toPrometheus(const Snapshot &snapshot) {
+    ostringstream out;
+
+    out << "# HELP chart_operation_duration_seconds Latency of ForestTree operations.\n"
+        << "# TYPE chart_operation_duration_seconds histogram\n";
+    for (int op = 0; op < OPERATION_COUNT; ++op) {
+        const OperationStats &stats = snapshot.operations[op];
+        const char *name = operationName(static_cast<Operation>(op));
+
+        // Cumulative buckets at powers of two from 256 ns to 2^36 ns (about 69 s)
+        uint64_t cumulative = 0;
+        int bucket = 0;
+        for (int exponent = 8; exponent <= 36; ++exponent) {
+            for (; bucket < 4 * (exponent - 1); ++bucket) {
+                cumulative += stats.buckets[bucket];
+            }
+            out << "chart_operation_duration_seconds_bucket{op=\"" << name << "\",le=\""
+                << static_cast<double>(1ULL << exponent) / 1e9 << "\"} " << cumulative << "\n";
+        }
+        out << "chart_operation_duration_seconds_bucket{op=\"" << name << "\",le=\"+Inf\"} " << stats.calls << "\n"
+            << "chart_operation_duration_seconds_sum{op=\"" << name << "\"} "
+            << static_cast<double>(stats.totalNanos) / 1e9 << "\n"
+            << "chart_operation_duration_seconds_count{op=\"" << name << "\"} " << stats.calls << "\n";
+    }
+
+    out << "# HELP chart_operation_errors_total Operations that ended with an exception.\n"
+        << "# TYPE chart_operation_errors_total counter\n";
+    for (int op = 0; op < OPERATION_COUNT; ++op) {
+        out << "chart_operation_errors_total{op=\"" << operationName(static_cast<Operation>(op)) << "\"} "
+            << snapshot.operations[op].errors << "\n";
+    }
+
+    out << "# HELP chart_operation_latency_seconds Latency percentiles of ForestTree operations.\n"
+        << "# TYPE chart_operation_latency_seconds gauge\n";
+    for (int op = 0; op < OPERATION_COUNT; ++op) {
+        const OperationStats &stats = snapshot.operations[op];
+        const char *name = operationName(static_cast<Operation>(op));
+        for (double q: {0.5, 0.9, 0.99}) {
+            out << "chart_operation_latency_seconds{op=\"" << name << "\",quantile=\"" << q << "\"} "
+                << static_cast<double>(stats.percentile(q)) / 1e9 << "\n";
+        }
+    }
+
+    for (int c = 0; c < COUNTER_COUNT; ++c) {
+        out << "# TYPE chart_" << COUNTER_NAMES[c] << "_total counter\n"
+            << "chart_" << COUNTER_NAMES[c] << "_total " << snapshot.counters[c] << "\n";
+    }
+    return out.str();
+}
+
+// Renders a snapshot as JSON
+string Metrics::toJson(const Snapshot &snapshot) {
+    ostringstream out;
+    out << fixed << setprecision(1);
+    out << "{\n  \"enabled\": " << (enabled() ? "true" : "false") << ",\n  \"operations\": {\n";
+    for (int op = 0; op < OPERATION_COUNT; ++op) {
+        const OperationStats &stats = snapshot.operations[op];
+        double mean = stats.calls ? static_cast<double>(stats.totalNanos) / static_cast<double>(stats.calls) : 0.0;
+        out << "    \"" << operationName(static_cast<Operation>(op)) << "\": {"
+            << "\"calls\": " << stats.calls
+            << ", \"errors\": " << stats.errors
+            << ", \"mean_ns\": " << mean
+            << ", \"p50_ns\": " << stats.percentile(0.5)
+            << ", \"p90_ns\": " << stats.percentile(0.9)
+            << ", \"p99_ns\": " << stats.percentile(0.99)
+            << ", \"max_ns\": " << stats.maxNanos << "}"
+            << (op + 1 < OPERATION_COUNT ? ",\n" : "\n");
+    }
+
+    // Loader throughput is measured against the time spent inside buildFromFile
+    double loadSeconds = static_cast<double>(snapshot.operations[BUILD_FROM_FILE].totalNanos) / 1e9;
+    double bytes = static_cast<double>(snapshot.counters[LOADER_BYTES]);
+    double lines = static_cast<double>(snapshot.counters[LOADER_LINES]);
+    out << "  },\n  \"loader\": {"
+        << "\"bytes\": " << snapshot.counters[LOADER_BYTES]
+        << ", \"lines\": " << snapshot.counters[LOADER_LINES]
+        << ", \"parse_errors\": " << snapshot.counters[LOADER_PARSE_ERRORS]
+        << ", \"bytes_per_second\": " << (loadSeconds > 0 ? bytes / loadSeconds : 0.0)
+        << ", \"lines_per_second\": " << (loadSeconds > 0 ? lines / loadSeconds : 0.0)
+        << "}\n}\n";
+    return out.str();
+}
+
+// Writes the current metrics in Prometheus text format to a file
+void Metrics::writePrometheus(const string &path) {
+    ofstream file(path);
+    if (!file.is_open()) {
+        throw runtime_error("Could not open file for writing: " + path);
+    }
+    file << toPrometheus(snapshot());
+}
+
+// Writes the current metrics as JSON to a file
+void Metrics::writeJson(const string &path) {
+    ofstream file(path);
+    if (!file.is_open()) {
+        throw runtime_error("Could not open file for writing: " + path);
+    }
+    file << toJson(snapshot());
+}
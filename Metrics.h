@@ -0,0 +1,158 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+/**-- Metrics.h -------------------------------------------------------------
+  This header file defines the Metrics class, process-wide instrumentation of
+  the ForestTree hot paths: per-operation call/error counters and latency
+  histograms, plus loader counters (bytes, lines, parse errors).
+
+  Recording is lock-free (relaxed atomics only). It is compiled in only when
+  CHART_METRICS is defined (CMake option CHART_METRICS); otherwise the
+  recording macros expand to nothing and snapshots report zeros, so callers
+  of the API build either way.
+
+  Latencies are kept in log-linear histograms: four buckets per power of two
+  of nanoseconds, so percentiles are accurate to within 25%.
+
+  Basic operations:
+    enabled:          Returns whether recording is compiled in.
+    record:           Records one call of an operation (latency, success).
+    add:              Adds to a loader counter (bytes, lines, parse errors).
+    snapshot:         Returns a consistent-enough copy of every metric.
+    reset:            Zeroes every metric.
+    toPrometheus:     Renders a snapshot in Prometheus text exposition format.
+    toJson:           Renders a snapshot as JSON.
+    writePrometheus / writeJson: Write the rendering to a local file.
+
+  Recording macros:
+    CHART_METRIC_SCOPE(op)       Times the enclosing scope as one call of op;
+                                 a scope left by an exception counts as an error.
+    CHART_METRIC_ADD(counter, n) Adds n to a loader counter.
+--------------------------------------------------------------------------**/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <string>
+
+using namespace std;
+
+class Metrics {
+public:
+    enum Operation {
+        ADD_TRANSACTION, REMOVE_TRANSACTION, SEARCH_ACCOUNT, ADD_ACCOUNT, BUILD_FROM_FILE, PRINT_TREE,
+        POST_ENTRY, OPERATION_COUNT
+    };
+
+    enum Counter { LOADER_BYTES, LOADER_LINES, LOADER_PARSE_ERRORS, COUNTER_COUNT };
+
+    static constexpr int BUCKET_COUNT = 256;    // Log-linear latency buckets
+
+    struct OperationStats {
+        uint64_t calls;                        // Completed calls
+        uint64_t errors;                       // Calls that ended with an exception
+        uint64_t totalNanos;                   // Sum of latencies
+        uint64_t maxNanos;                     // Largest latency
+        uint64_t buckets[BUCKET_COUNT];        // Latency histogram
+
+        /*--------------------------------------------------------------------
+          Returns the latency (in nanoseconds) below which the given fraction
+          of calls fall, using the upper bound of the matching bucket.
+        --------------------------------------------------------------------*/
+        uint64_t percentile(double fraction) const;
+    };
+
+    struct Snapshot {
+        OperationStats operations[OPERATION_COUNT];
+        uint64_t counters[COUNTER_COUNT];
+    };
+
+    /***** Scoped Timer *****/
+    /*------------------------------------------------------------------------
+      Times its own lifetime and records it as one call of an operation.
+    -----------------------------------------------------------------------*/
+    class ScopedTimer {
+    private:
+        Operation operation;
+        int exceptionsAtStart;
+        chrono::steady_clock::time_point start;
+
+    public:
+        explicit ScopedTimer(Operation operation)
+                : operation(operation), exceptionsAtStart(uncaught_exceptions()), start(chrono::steady_clock::now()) {}
+
+        ~ScopedTimer() {
+            auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+            Metrics::record(operation, static_cast<uint64_t>(elapsed), uncaught_exceptions() == exceptionsAtStart);
+        }
+
+        ScopedTimer(const ScopedTimer &) = delete;
+
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+    };
+
+    /***** Recording *****/
+    /*------------------------------------------------------------------------
+      Records one call of an operation, or adds to a loader counter. Both are
+      no-ops when CHART_METRICS is not defined.
+
+      Precondition:  A valid operation / counter is provided.
+      Post-condition: The metric is updated with relaxed atomic operations.
+    -----------------------------------------------------------------------*/
+    static void record(Operation operation, uint64_t nanos, bool succeeded);
+
+    static void add(Counter counter, uint64_t amount);
+
+    static bool enabled();
+
+    /***** Reading *****/
+    /*------------------------------------------------------------------------
+      Copies every metric, or zeroes them. Values recorded concurrently with
+      a snapshot may be partially included.
+
+      Precondition:  None.
+      Post-condition: Returns the copy / metrics are zero.
+    -----------------------------------------------------------------------*/
+    static Snapshot snapshot();
+
+    static void reset();
+
+    /***** Export *****/
+    /*------------------------------------------------------------------------
+      Renders a snapshot as Prometheus text exposition format or JSON, or
+      writes the rendering of the current metrics to a local file.
+
+      Precondition:  A writable path is provided for the write functions.
+      Post-condition: Returns the text / the file is written; throws
+                      runtime_error if the file cannot be written.
+    -----------------------------------------------------------------------*/
+    static string toPrometheus(const Snapshot &snapshot);
+
+    static string toJson(const Snapshot &snapshot);
+
+    static void writePrometheus(const string &path);
+
+    static void writeJson(const string &path);
+
+    static const char *operationName(Operation operation);
+
+    /*------------------------------------------------------------------------
+      Bucket arithmetic of the log-linear histogram.
+    -----------------------------------------------------------------------*/
+    static int bucketOf(uint64_t nanos);
+
+    static uint64_t bucketUpperBound(int bucket);
+};
+
+#ifdef CHART_METRICS
+#define CHART_METRIC_CONCAT_(a, b) a##b
+#define CHART_METRIC_CONCAT(a, b) CHART_METRIC_CONCAT_(a, b)
+#define CHART_METRIC_SCOPE(op) Metrics::ScopedTimer CHART_METRIC_CONCAT(metricTimer, __LINE__)(op)
+#define CHART_METRIC_ADD(counter, n) Metrics::add(counter, n)
+#else
+#define CHART_METRIC_SCOPE(op) ((void) 0)
+#define CHART_METRIC_ADD(counter, n) ((void) (n))
+#endif
+
+#endif // METRICS_H
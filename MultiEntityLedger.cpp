@@ -0,0 +1,267 @@
+#include "MultiEntityLedger.h"
+#include "PostingKernels.h"
+#include "PostingRules.h"
+#include "Transaction.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+/***** EntityLedger *****/
+
+// Constructor: Creates an empty overlay with one (absent) page per PAGE_SIZE accounts
+EntityLedger::EntityLedger(shared_ptr<const ChartSkeleton> skeleton, string name)
+        : skeleton(move(skeleton)), name(move(name)) {
+    if (!this->skeleton) {
+        throw invalid_argument("An entity needs a chart skeleton");
+    }
+    pages.resize((this->skeleton->size() + PAGE_SIZE - 1) / PAGE_SIZE);
+}
+
+// Returns the entity name
+const string &EntityLedger::getName() const {
+    return name;
+}
+
+// Returns the shared skeleton
+const ChartSkeleton &EntityLedger::getSkeleton() const {
+    return *skeleton;
+}
+
+// Returns the skeleton index of an account number, or throws
+int EntityLedger::requireIndex(int accountNumber) const {
+    int index = skeleton->indexOf(accountNumber);
+    if (index < 0) {
+        throw invalid_argument("Account not found: " + to_string(accountNumber));
+    }
+    return index;
+}
+
+// Returns the page of an index, allocating a zeroed page on first use
+EntityLedger::Page &EntityLedger::touch(int index) {
+    unique_ptr<Page> &page = pages[index / PAGE_SIZE];
+    if (!page) {
+        page.reset(new Page());
+        fill(page->deltas, page->deltas + PAGE_SIZE, 0.0);
+        fill(page->slots, page->slots + PAGE_SIZE, -1);
+    }
+    return *page;
+}
+
+// Adds a delta to an account and each of its ancestors
+void EntityLedger::addDelta(int index, double delta) {
+    for (int current = index; current >= 0; current = skeleton->getParent(current)) {
+        touch(current).deltas[current % PAGE_SIZE] += delta;
+    }
+}
+
+// Posts to an account after the checks Account::addTransaction makes
+void EntityLedger::post(int accountNumber, double amount, char debitOrCredit, int date) {
+    int index = requireIndex(accountNumber);
+    if (debitOrCredit != 'D' && debitOrCredit != 'C') {
+        throw invalid_argument("Invalid transaction type. Use 'D' for Debit or 'C' for Credit.");
+    }
+    if (!(amount > 0.0 && amount - amount == 0.0)) {    // Not positive and finite, as PostingRules rejects
+        throw invalid_argument(PostingRules::verdictMessage(PostingRules::BAD_AMOUNT));
+    }
+    if (date != 0 && !Transaction::isValidDate(date)) {
+        throw invalid_argument("Invalid posting date: " + to_string(date) + ". Use YYYY-MM-DD.");
+    }
+    if (debitOrCredit == 'C' && getBalance(accountNumber) < amount) {
+        throw invalid_argument("Transaction is invalid: Insufficient balance for credit transaction.");
+    }
+
+    Page &page = touch(index);
+    int &slot = page.slots[index % PAGE_SIZE];
+    if (slot < 0) {
+        slot = postings.allocateSlot(accountNumber);
+    }
+    postings.append(slot, static_cast<int>(postings.size(slot)) + 1, amount, debitOrCredit, date);
+    addDelta(index, (debitOrCredit == 'D') ? amount : -amount);
+}
+
+// Removes a posting by ID and reverses its delta along the ancestor chain
+void EntityLedger::removePosting(int accountNumber, int transactionID) {
+    int index = requireIndex(accountNumber);
+    const Page *page = pages[index / PAGE_SIZE].get();
+    int slot = page ? page->slots[index % PAGE_SIZE] : -1;
+    if (slot >= 0) {
+        PostingView view = postings.view(slot);
+        const int *ids = view.ids();
+        const int *it = find(ids, ids + view.size(), transactionID);
+        if (it != ids + view.size()) {
+            PostingRef posting = view[static_cast<size_t>(it - ids)];
+            double delta = (posting.getDebitOrCredit() == 'D') ? -posting.getAmount() : posting.getAmount();
+            postings.erase(slot, static_cast<size_t>(it - ids));
+            postings.renumber(slot);
+            addDelta(index, delta);
+            return;
+        }
+    }
+    throw invalid_argument("Transaction not found.");
+}
+
+// Returns the opening balance plus the entity's delta
+double EntityLedger::getBalance(int accountNumber) const {
+    int index = requireIndex(accountNumber);
+    const Page *page = pages[index / PAGE_SIZE].get();
+    return skeleton->getOpeningBalance(index) + (page ? page->deltas[index % PAGE_SIZE] : 0.0);
+}
+
+// Returns a view over the entity's postings of an account
+PostingView EntityLedger::getPostings(int accountNumber) const {
+    int index = requireIndex(accountNumber);
+    const Page *page = pages[index / PAGE_SIZE].get();
+    int slot = page ? page->slots[index % PAGE_SIZE] : -1;
+    return slot >= 0 ? postings.view(slot) : PostingView(&postings, 0, 0);
+}
+
+// Returns the number of overlay pages
+size_t EntityLedger::getPageCount() const {
+    return pages.size();
+}
+
+// Returns the deltas of a page, or nullptr if the page is untouched
+const double *EntityLedger::getDeltaPage(size_t page) const {
+    return pages[page] ? pages[page]->deltas : nullptr;
+}
+
+// Returns the bytes held by the page table, the touched pages and the postings
+size_t EntityLedger::memoryBytes() const {
+    size_t bytes = sizeof(*this) + name.capacity() + pages.capacity() * sizeof(unique_ptr<Page>);
+    for (const auto &page: pages) {
+        if (page) bytes += sizeof(Page);
+    }
+    bytes += postings.getAccountColumn().capacity() * sizeof(int)
+             + postings.getIdColumn().capacity() * sizeof(int)
+             + postings.getAmountColumn().capacity() * sizeof(double)
+             + postings.getCreditColumn().capacity() * sizeof(unsigned char)
+             + postings.getDateColumn().capacity() * sizeof(int);
+    return bytes;
+}
+
+/***** MultiEntityLedger *****/
+
+// Constructor: Creates a ledger with no entities
+MultiEntityLedger::MultiEntityLedger(shared_ptr<const ChartSkeleton> skeleton) : skeleton(move(skeleton)) {
+    if (!this->skeleton) {
+        throw invalid_argument("A multi-entity ledger needs a chart skeleton");
+    }
+}
+
+// Returns the shared skeleton
+const ChartSkeleton &MultiEntityLedger::getSkeleton() const {
+    return *skeleton;
+}
+
+// Adds an entity with no postings
+EntityLedger &MultiEntityLedger::addEntity(const string &name) {
+    if (name.empty()) {
+        throw invalid_argument("Entity name must not be empty");
+    }
+    if (entities.count(name)) {
+        throw invalid_argument("Entity already exists: " + name);
+    }
+    unique_ptr<EntityLedger> &entity = entities[name];
+    entity.reset(new EntityLedger(skeleton, name));
+    return *entity;
+}
+
+// Removes an entity and its postings
+void MultiEntityLedger::removeEntity(const string &name) {
+    if (entities.erase(name) == 0) {
+        throw invalid_argument("Entity not found: " + name);
+    }
+}
+
+// Returns an entity by name
+EntityLedger &MultiEntityLedger::getEntity(const string &name) {
+    auto it = entities.find(name);
+    if (it == entities.end()) {
+        throw invalid_argument("Entity not found: " + name);
+    }
+    return *it->second;
+}
+
+// Returns an entity by name (read-only)
+const EntityLedger &MultiEntityLedger::getEntity(const string &name) const {
+    auto it = entities.find(name);
+    if (it == entities.end()) {
+        throw invalid_argument("Entity not found: " + name);
+    }
+    return *it->second;
+}
+
+// Returns the entity names in order
+vector<string> MultiEntityLedger::getEntityNames() const {
+    vector<string> names;
+    names.reserve(entities.size());
+    for (const auto &pair: entities) {
+        names.push_back(pair.first);
+    }
+    return names;
+}
+
+// Returns the number of entities
+size_t MultiEntityLedger::entityCount() const {
+    return entities.size();
+}
+
+// Sums the opening balances once per entity, then adds each entity's touched delta pages
+vector<double> MultiEntityLedger::consolidatedBalances(const vector<string> &names) const {
+    vector<const EntityLedger *> selected;
+    if (names.empty()) {
+        for (const auto &pair: entities) {
+            selected.push_back(pair.second.get());
+        }
+    } else {
+        for (const string &name: names) {
+            selected.push_back(&getEntity(name));
+        }
+    }
+
+    size_t count = skeleton->size();
+    vector<double> balances(count);
+    double entityCount = static_cast<double>(selected.size());
+    for (size_t i = 0; i < count; ++i) {
+        balances[i] = skeleton->getOpeningBalance(static_cast<int>(i)) * entityCount;
+    }
+    for (const EntityLedger *entity: selected) {
+        for (size_t page = 0; page < entity->getPageCount(); ++page) {
+            const double *deltas = entity->getDeltaPage(page);
+            if (deltas) {
+                size_t first = page * EntityLedger::PAGE_SIZE;
+                PostingKernels::addTo(balances.data() + first, deltas,
+                                      min(static_cast<size_t>(EntityLedger::PAGE_SIZE), count - first));
+            }
+        }
+    }
+    return balances;
+}
+
+// Returns one account's balance summed over the selected entities
+double MultiEntityLedger::consolidatedBalance(int accountNumber, const vector<string> &names) const {
+    if (skeleton->indexOf(accountNumber) < 0) {
+        throw invalid_argument("Account not found: " + to_string(accountNumber));
+    }
+    double total = 0.0;
+    if (names.empty()) {
+        for (const auto &pair: entities) {
+            total += pair.second->getBalance(accountNumber);
+        }
+    } else {
+        for (const string &name: names) {
+            total += getEntity(name).getBalance(accountNumber);
+        }
+    }
+    return total;
+}
+
+// Returns the bytes held by the skeleton and every overlay
+size_t MultiEntityLedger::memoryBytes() const {
+    size_t bytes = sizeof(*this) + skeleton->memoryBytes();
+    for (const auto &pair: entities) {
+        bytes += pair.first.capacity() + pair.second->memoryBytes();
+    }
+    return bytes;
+}
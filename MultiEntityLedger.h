@@ -0,0 +1,232 @@
+#ifndef MULTIENTITYLEDGER_H
+#define MULTIENTITYLEDGER_H
+
+/**-- MultiEntityLedger.h ---------------------------------------------------
+  This header file defines the EntityLedger and MultiEntityLedger classes,
+  a multi-tenant mode in which many legal entities post against the same
+  chart of accounts. The chart is held once, as a shared immutable
+  ChartSkeleton; each EntityLedger holds only its own overlay:
+
+    - balance deltas in pages of PAGE_SIZE accounts, indexed by skeleton
+      index and allocated the first time an account of the page (or one
+      of its descendants) is posted to;
+    - postings in a private PostingStore, with a slot per posted account.
+
+  An entity's balance of an account is the skeleton's opening balance plus
+  the entity's delta, so memory grows with postings and touched pages, not
+  with entities x chart size. Consolidated balances across entities add the
+  delta pages with the PostingKernels::addTo kernel.
+
+  EntityLedger basic operations:
+    Constructor:     Creates an empty overlay over a skeleton.
+    post:            Posts to an account and adds the delta to its ancestors.
+    removePosting:   Removes a posting by ID and reverses its delta.
+    getBalance:      Returns the entity's balance of an account.
+    getPostings:     Returns a view over the entity's postings of an account.
+    getDeltaPage:    Returns a delta page (nullptr if untouched).
+    memoryBytes:     Returns the memory held by the overlay.
+
+  MultiEntityLedger basic operations:
+    Constructor:            Creates a ledger with no entities over a skeleton.
+    addEntity / removeEntity / getEntity / getEntityNames:
+                            Manage the entities by name.
+    consolidatedBalances:   Balance of every account summed over entities.
+    consolidatedBalance:    The same for one account.
+    memoryBytes:            Returns the memory held by skeleton and overlays.
+
+  Class Invariant (EntityLedger):
+    1. deltas[i] of a page is the signed sum of the entity's postings to
+       account i and its descendants; accounts of absent pages have none.
+    2. slots[i] is the account's slot in `postings`, or -1 if it has none.
+    3. Transaction IDs of an account are 1..n, as in Account.
+
+  Neither class is thread-safe; concurrent readers are safe only while no
+  entity is modified.
+--------------------------------------------------------------------------**/
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ChartSkeleton.h"
+#include "PostingStore.h"
+
+using namespace std;
+
+class EntityLedger {
+public:
+    static const int PAGE_SIZE = 64;       // Accounts per overlay page
+
+private:
+    struct Page {
+        double deltas[PAGE_SIZE];          // Balance delta per account
+        int slots[PAGE_SIZE];              // Posting slot per account (-1: none)
+    };
+
+    shared_ptr<const ChartSkeleton> skeleton;   // Shared chart
+    string name;                                // Entity name
+    vector<unique_ptr<Page>> pages;             // Overlay pages (null until touched)
+    PostingStore postings;                      // This entity's postings
+
+    /***** Helper Functions *****/
+    /*------------------------------------------------------------------------
+      Returns the skeleton index of an account number.
+
+      Precondition:  None.
+      Post-condition: Throws invalid_argument if the chart has no such account.
+    -----------------------------------------------------------------------*/
+    int requireIndex(int accountNumber) const;
+
+    /*------------------------------------------------------------------------
+      Returns the page holding an index, allocating it if needed.
+
+      Precondition:  0 <= index < skeleton->size().
+      Post-condition: The page exists; a new page has zero deltas and no slots.
+    -----------------------------------------------------------------------*/
+    Page &touch(int index);
+
+    /*------------------------------------------------------------------------
+      Adds a delta to an account and every ancestor.
+
+      Precondition:  0 <= index < skeleton->size().
+      Post-condition: Invariant 1 holds for the new delta.
+    -----------------------------------------------------------------------*/
+    void addDelta(int index, double delta);
+
+public:
+    /***** Constructor *****/
+    /*------------------------------------------------------------------------
+      Creates an entity with no postings over a shared skeleton.
+
+      Precondition:  skeleton is not null.
+      Post-condition: Every balance equals the skeleton's opening balance.
+    -----------------------------------------------------------------------*/
+    EntityLedger(shared_ptr<const ChartSkeleton> skeleton, string name);
+
+    EntityLedger(const EntityLedger &) = delete;
+
+    EntityLedger &operator=(const EntityLedger &) = delete;
+
+    /***** Getters *****/
+    const string &getName() const;
+
+    const ChartSkeleton &getSkeleton() const;
+
+    /***** Posting Management *****/
+    /*------------------------------------------------------------------------
+      Posts to an account under the rules of Account::addTransaction: the
+      type is 'D' or 'C', the amount positive and finite (PostingRules
+      BAD_AMOUNT), the date 0 or a valid YYYYMMDD value, and a credit may
+      not exceed the account's balance.
+
+      Precondition:  The account is in the skeleton.
+      Post-condition: The posting is stored and the account's and ancestors'
+                      balances are adjusted; throws invalid_argument (and
+                      changes nothing) if the posting is rejected.
+    -----------------------------------------------------------------------*/
+    void post(int accountNumber, double amount, char debitOrCredit, int date = 0);
+
+    /*------------------------------------------------------------------------
+      Removes a posting by transaction ID, reverses its balance adjustment,
+      and renumbers the account's remaining postings.
+
+      Precondition:  The account is in the skeleton.
+      Post-condition: Throws invalid_argument if the posting is not found.
+    -----------------------------------------------------------------------*/
+    void removePosting(int accountNumber, int transactionID);
+
+    /***** Queries *****/
+    /*------------------------------------------------------------------------
+      Returns the entity's balance of an account, or a view over its
+      postings (empty if the entity never posted to it).
+
+      Precondition:  The account is in the skeleton.
+      Post-condition: The view is valid until the entity is modified.
+    -----------------------------------------------------------------------*/
+    double getBalance(int accountNumber) const;
+
+    PostingView getPostings(int accountNumber) const;
+
+    /*------------------------------------------------------------------------
+      Returns the number of pages, and the deltas of one page (PAGE_SIZE
+      values, the last page padded with zeros), or nullptr if no account of
+      the page has been touched.
+
+      Precondition:  page < getPageCount().
+      Post-condition: The pointer is valid until the entity is destroyed.
+    -----------------------------------------------------------------------*/
+    size_t getPageCount() const;
+
+    const double *getDeltaPage(size_t page) const;
+
+    /*------------------------------------------------------------------------
+      Returns the bytes held by this entity's overlay (the skeleton excluded).
+
+      Precondition:  None.
+      Post-condition: Returns the size in bytes.
+    -----------------------------------------------------------------------*/
+    size_t memoryBytes() const;
+};
+
+class MultiEntityLedger {
+private:
+    shared_ptr<const ChartSkeleton> skeleton;              // Chart shared by every entity
+    map<string, unique_ptr<EntityLedger>> entities;        // Entities by name
+
+public:
+    /***** Constructor *****/
+    /*------------------------------------------------------------------------
+      Creates a ledger with no entities over a shared skeleton.
+
+      Precondition:  skeleton is not null.
+      Post-condition: The ledger is empty.
+    -----------------------------------------------------------------------*/
+    explicit MultiEntityLedger(shared_ptr<const ChartSkeleton> skeleton);
+
+    const ChartSkeleton &getSkeleton() const;
+
+    /***** Entity Management *****/
+    /*------------------------------------------------------------------------
+      Adds, removes or returns an entity by name, or lists the names.
+
+      Precondition:  A non-empty name is provided.
+      Post-condition: addEntity throws invalid_argument if the name exists;
+                      removeEntity and getEntity throw it if it does not.
+                      References stay valid until the entity is removed.
+    -----------------------------------------------------------------------*/
+    EntityLedger &addEntity(const string &name);
+
+    void removeEntity(const string &name);
+
+    EntityLedger &getEntity(const string &name);
+
+    const EntityLedger &getEntity(const string &name) const;
+
+    vector<string> getEntityNames() const;
+
+    size_t entityCount() const;
+
+    /***** Consolidation *****/
+    /*------------------------------------------------------------------------
+      Returns the balance of every account summed over the named entities
+      (all entities if names is empty), indexed by skeleton index; or the
+      consolidated balance of one account.
+
+      Precondition:  Every name is an entity of the ledger.
+      Post-condition: Throws invalid_argument for an unknown entity or account.
+    -----------------------------------------------------------------------*/
+    vector<double> consolidatedBalances(const vector<string> &names = {}) const;
+
+    double consolidatedBalance(int accountNumber, const vector<string> &names = {}) const;
+
+    /*------------------------------------------------------------------------
+      Returns the bytes held by the skeleton and every overlay.
+
+      Precondition:  None.
+      Post-condition: Returns the size in bytes.
+    -----------------------------------------------------------------------*/
+    size_t memoryBytes() const;
+};
+
+#endif // MULTIENTITYLEDGER_H
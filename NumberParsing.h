@@ -0,0 +1,38 @@
+#ifndef NUMBERPARSING_H
+#define NUMBERPARSING_H
+
+/**-- NumberParsing.h -------------------------------------------------------
+  This header file defines the integer parsing shared by the text front ends
+  (BatchRunner commands, PostingPipeline feed lines), so that every one of
+  them accepts and rejects the same tokens.
+
+  A token is parsed whole, in place and without allocating: it must be an
+  optional sign followed by decimal digits, and the value must fit the
+  target type. Text that strtol would read only in part, or would clamp or
+  narrow, is rejected.
+
+  Basic operations:
+    parseInt:     Parses a token as an int.
+--------------------------------------------------------------------------**/
+
+#include <charconv>
+#include <string_view>
+#include <system_error>
+
+namespace NumberParsing {
+
+    inline bool parseInt(std::string_view token, int &value) {
+        if (token.size() > 1 && token[0] == '+' && token[1] != '-') {
+            token.remove_prefix(1); // from_chars takes no leading '+'
+        }
+        int parsed = 0;
+        std::from_chars_result result = std::from_chars(token.data(), token.data() + token.size(), parsed);
+        if (token.empty() || result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+}
+
+#endif // NUMBERPARSING_H
@@ -0,0 +1,166 @@
+#include "PeriodBalances.h"
+#include "MemoryUsage.h"
+#include <algorithm>
+
+using namespace std;
+
+// Constructor: Initializes an empty set of series with the given granularity
+PeriodBalances::PeriodBalances(Granularity granularity) : granularity(granularity) {}
+
+// Removes every series
+void PeriodBalances::clear() {
+    series.clear();
+}
+
+// Returns the bucketing granularity
+PeriodBalances::Granularity PeriodBalances::getGranularity() const {
+    return granularity;
+}
+
+// Maps a YYYYMMDD date to days since 1900-01-01 (DAY) or months since 1900-01 (MONTH)
+int PeriodBalances::periodOf(int date) const {
+    int year = date / 10000, month = (date / 100) % 100, day = date % 100;
+    if (granularity == MONTH) {
+        return (year - 1900) * 12 + (month - 1);
+    }
+
+    // Days-from-civil: shift the year to start in March so leap days fall last
+    year -= month <= 2;
+    int era = year / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 693901; // 693901 = days from 0000-03-01 to 1900-01-01
+}
+
+// Returns the sum of the first n buckets of a series
+double PeriodBalances::prefixSum(const Series &s, int n) {
+    double sum = 0.0;
+    for (; n > 0; n -= n & -n) {
+        sum += s.tree[n];
+    }
+    return sum;
+}
+
+// Re-bases and/or enlarges a series so that the period falls inside it
+void PeriodBalances::grow(Series &s, int period) {
+    int size = static_cast<int>(s.tree.size()) - 1;
+    if (size <= 0) {
+        s.origin = period;
+        s.total = 0.0;
+        s.tree.assign(17, 0.0);
+        return;
+    }
+
+    // Extend at least by the current size so repeated growth stays amortized O(1)
+    int newOrigin = s.origin;
+    int newEnd = s.origin + size;
+    if (period < s.origin) {
+        newOrigin = min(period, s.origin - size);
+    } else {
+        newEnd = max(period + 1, s.origin + 2 * size);
+    }
+    int newSize = 1;
+    while (newSize < newEnd - newOrigin) {
+        newSize *= 2;
+    }
+
+    // Undo the Fenwick build to recover the raw buckets
+    vector<double> &raw = s.tree;
+    for (int i = size; i >= 1; --i) {
+        int j = i + (i & -i);
+        if (j <= size) raw[j] -= raw[i];
+    }
+
+    // Place the buckets at their new offsets and rebuild in O(n)
+    vector<double> rebuilt(newSize + 1, 0.0);
+    int shift = s.origin - newOrigin;
+    for (int i = 1; i <= size; ++i) {
+        rebuilt[i + shift] = raw[i];
+    }
+    for (int i = 1; i <= newSize; ++i) {
+        int j = i + (i & -i);
+        if (j <= newSize) rebuilt[j] += rebuilt[i];
+    }
+
+    s.origin = newOrigin;
+    s.tree.swap(rebuilt);
+}
+
+// Adds a signed delta to the bucket of the given date in an account's series
+void PeriodBalances::record(int accountNumber, int date, double delta) {
+    int period = periodOf(date);
+    Series &s = series[accountNumber];
+
+    int size = static_cast<int>(s.tree.size()) - 1;
+    if (size <= 0 || period < s.origin || period >= s.origin + size) {
+        grow(s, period);
+        size = static_cast<int>(s.tree.size()) - 1;
+    }
+
+    for (int i = period - s.origin + 1; i <= size; i += i & -i) {
+        s.tree[i] += delta;
+    }
+    s.total += delta;
+}
+
+// Drops the series of an account
+void PeriodBalances::erase(int accountNumber) {
+    series.erase(accountNumber);
+}
+
+// Shrinks the series table after erasures
+void PeriodBalances::compact() {
+    series.rehash(0);
+}
+
+// Returns the bytes of the series table and of every Fenwick tree
+size_t PeriodBalances::memoryBytes() const {
+    size_t bytes = MemoryUsage::hashBytes(series);
+    for (const auto &pair: series) {
+        bytes += MemoryUsage::vectorBytes(pair.second.tree);
+    }
+    return bytes;
+}
+
+// Returns the sum of an account's deltas up to and including the date's period
+double PeriodBalances::movementThrough(int accountNumber, int date) const {
+    auto it = series.find(accountNumber);
+    if (it == series.end()) {
+        return 0.0;
+    }
+
+    const Series &s = it->second;
+    int size = static_cast<int>(s.tree.size()) - 1;
+    int offset = periodOf(date) - s.origin + 1;
+    if (offset <= 0) {
+        return 0.0;
+    }
+    if (offset >= size) {
+        return s.total;
+    }
+    return prefixSum(s, offset);
+}
+
+// Returns the sum of an account's deltas between two dates (inclusive)
+double PeriodBalances::movementBetween(int accountNumber, int fromDate, int toDate) const {
+    auto it = series.find(accountNumber);
+    if (it == series.end() || fromDate > toDate) {
+        return 0.0;
+    }
+
+    const Series &s = it->second;
+    int size = static_cast<int>(s.tree.size()) - 1;
+    int from = max(periodOf(fromDate) - s.origin, 0);
+    int to = min(periodOf(toDate) - s.origin + 1, size);
+    if (to <= from) {
+        return 0.0;
+    }
+    return prefixSum(s, to) - prefixSum(s, from);
+}
+
+// Returns the sum of all dated deltas recorded for an account
+double PeriodBalances::totalMovement(int accountNumber) const {
+    auto it = series.find(accountNumber);
+    return (it != series.end()) ? it->second.total : 0.0;
+}
@@ -0,0 +1,149 @@
+#ifndef PERIODBALANCES_H
+#define PERIODBALANCES_H
+
+/**-- PeriodBalances.h ------------------------------------------------------
+  This header file defines the PeriodBalances class, a compact time series of
+  dated balance movements per account. Movements are bucketed by period (day
+  or month) and stored in one Fenwick (binary indexed) tree per account, so
+  the movement up to a date or between two dates is answered in O(log P),
+  where P is the number of periods covered by the account.
+
+  Each account's series holds the movements of its whole subtree: the
+  ForestTree records a dated posting once for the posted account and once for
+  every ancestor, in the same walk that updates balances.
+
+  Basic operations:
+    Constructor:       Constructs an empty series set with a granularity.
+    clear:             Removes all series.
+    getGranularity:    Returns the bucketing granularity (DAY or MONTH).
+    record:            Adds a dated delta to an account's series.
+    erase:             Drops the series of an account.
+    movementThrough:   Sum of an account's deltas up to and including a date.
+    movementBetween:   Sum of an account's deltas between two dates (inclusive).
+    totalMovement:     Sum of all dated deltas recorded for an account.
+    compact:           Shrinks the series table after erasures.
+    memoryBytes:       Returns the memory held by every series.
+
+  Helper functions:
+    periodOf:          Maps a YYYYMMDD date to its period number.
+    prefixSum:         Fenwick prefix sum over the first n buckets of a series.
+    grow:              Re-bases or enlarges a series so a period fits in it.
+
+  Class Invariant:
+    1. Every series covers the periods [origin, origin + size) with size a power of two.
+    2. total equals the sum of all buckets of the series.
+--------------------------------------------------------------------------**/
+
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+class PeriodBalances {
+public:
+    enum Granularity { DAY, MONTH };
+
+private:
+    struct Series {
+        int origin;           // Period number of bucket 1
+        double total;         // Sum of every bucket
+        vector<double> tree;  // Fenwick tree, 1-based (tree[0] unused)
+    };
+
+    Granularity granularity;                // Bucketing granularity
+    unordered_map<int, Series> series;      // Series keyed by account number
+
+    /***** Helper Functions *****/
+    /*------------------------------------------------------------------------
+      Maps a YYYYMMDD date to its period number (days since 1900-01-01 for
+      DAY, months since 1900-01 for MONTH).
+
+      Precondition:  A valid YYYYMMDD date is provided.
+      Post-condition: Returns the period number.
+    -----------------------------------------------------------------------*/
+    int periodOf(int date) const;
+
+    /*------------------------------------------------------------------------
+      Returns the sum of the first n buckets of a series.
+
+      Precondition:  0 <= n < s.tree.size().
+      Post-condition: Returns the prefix sum.
+    -----------------------------------------------------------------------*/
+    static double prefixSum(const Series &s, int n);
+
+    /*------------------------------------------------------------------------
+      Re-bases and/or enlarges a series so that the given period falls inside
+      it, preserving every recorded bucket.
+
+      Precondition:  A valid series and period number are provided.
+      Post-condition: The series covers the period.
+    -----------------------------------------------------------------------*/
+    static void grow(Series &s, int period);
+
+public:
+    /***** Constructor *****/
+    /*------------------------------------------------------------------------
+      Constructs an empty set of series with the given granularity.
+
+      Precondition:  None.
+      Post-condition: No account has a series.
+    -----------------------------------------------------------------------*/
+    explicit PeriodBalances(Granularity granularity = MONTH);
+
+    /***** Clear *****/
+    /*------------------------------------------------------------------------
+      Removes every series.
+
+      Precondition:  None.
+      Post-condition: No account has a series.
+    -----------------------------------------------------------------------*/
+    void clear();
+
+    Granularity getGranularity() const;
+
+    /***** Record / Erase *****/
+    /*------------------------------------------------------------------------
+      Adds a signed delta to the bucket of the given date in an account's
+      series, creating the series on first use.
+
+      Precondition:  A valid account number and YYYYMMDD date are provided.
+      Post-condition: The bucket and the series total are updated in O(log P).
+    -----------------------------------------------------------------------*/
+    void record(int accountNumber, int date, double delta);
+
+    /*------------------------------------------------------------------------
+      Drops the series of an account, if any.
+
+      Precondition:  None.
+      Post-condition: The account has no series.
+    -----------------------------------------------------------------------*/
+    void erase(int accountNumber);
+
+    /***** Queries *****/
+    /*------------------------------------------------------------------------
+      Returns dated movement sums for an account's series. Accounts without a
+      series have no dated movement.
+
+      Precondition:  Valid YYYYMMDD dates are provided, fromDate <= toDate.
+      Post-condition: Returns the requested sum in O(log P).
+    -----------------------------------------------------------------------*/
+    double movementThrough(int accountNumber, int date) const;
+
+    double movementBetween(int accountNumber, int fromDate, int toDate) const;
+
+    double totalMovement(int accountNumber) const;
+
+    /***** Memory *****/
+    /*------------------------------------------------------------------------
+      Shrinks the series table to its entries (each series is already a
+      power of two sized to the periods it covers).
+
+      Precondition:  None.
+      Post-condition: Every series is unchanged.
+    -----------------------------------------------------------------------*/
+    void compact();
+
+    size_t memoryBytes() const;
+};
+
+#endif // PERIODBALANCES_H
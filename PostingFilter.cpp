@@ -0,0 +1,12 @@
+#include "PostingFilter.h"
+
+using namespace std;
+
+// Returns whether a posting matches the ID, amount, date and type bounds
+bool PostingFilter::matches(int transactionID, double amount, char debitOrCredit, int date) const {
+    bool dated = fromDate != 0 || toDate != 0;
+    return transactionID >= fromID && transactionID <= toID &&
+           amount >= minAmount && amount <= maxAmount &&
+           (type == '\0' || debitOrCredit == type) &&
+           (!dated || (date != 0 && (fromDate == 0 || date >= fromDate) && (toDate == 0 || date <= toDate)));
+}
@@ -0,0 +1,42 @@
+#ifndef POSTINGFILTER_H
+#define POSTINGFILTER_H
+
+/**-- PostingFilter.h -------------------------------------------------------
+  This header file defines the PostingFilter structure, a predicate over
+  postings used by the bulk operations of ForestTree (removePostings and
+  reversePostings). A posting matches when every bound holds:
+
+    fromID..toID           Transaction ID range (inclusive)
+    minAmount..maxAmount   Amount range (inclusive); equal bounds select one amount
+    fromDate..toDate       Posting date range (inclusive, YYYYMMDD); 0 leaves
+                           a side open. With either bound set, undated
+                           postings do not match.
+    type                   'D', 'C', or '\0' for both
+
+  The default filter matches every posting.
+--------------------------------------------------------------------------**/
+
+#include <climits>
+#include <limits>
+
+using namespace std;
+
+struct PostingFilter {
+    int fromID = 1;
+    int toID = INT_MAX;
+    double minAmount = -numeric_limits<double>::infinity();
+    double maxAmount = numeric_limits<double>::infinity();
+    int fromDate = 0;
+    int toDate = 0;
+    char type = '\0';
+
+    /*------------------------------------------------------------------------
+      Returns whether a posting with the given fields matches every bound.
+
+      Precondition:  None.
+      Post-condition: Returns true if the posting matches.
+    -----------------------------------------------------------------------*/
+    bool matches(int transactionID, double amount, char debitOrCredit, int date) const;
+};
+
+#endif // POSTINGFILTER_H
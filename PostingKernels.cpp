@@ -0,0 +1,247 @@
+#include "PostingKernels.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define POSTING_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+    /***** Scalar Kernels *****/
+
+    double signedSumScalar(const double *amounts, const unsigned char *credit, size_t n) {
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            sum += credit[i] ? -amounts[i] : amounts[i];
+        }
+        return sum;
+    }
+
+    double filteredSumScalar(const double *amounts, const unsigned char *credit, size_t n,
+                             int typeFilter, double minAmount) {
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            bool typeMatches = typeFilter == PostingKernels::ANY_TYPE || credit[i] == typeFilter;
+            if (typeMatches && amounts[i] >= minAmount) {
+                sum += amounts[i];
+            }
+        }
+        return sum;
+    }
+
+    size_t countAboveScalar(const double *amounts, size_t n, double threshold) {
+        size_t count = 0;
+        for (size_t i = 0; i < n; ++i) {
+            count += amounts[i] > threshold;
+        }
+        return count;
+    }
+
+    void minMaxScalar(const double *amounts, size_t n, double &minAmount, double &maxAmount) {
+        double lo = amounts[0], hi = amounts[0];
+        for (size_t i = 1; i < n; ++i) {
+            lo = min(lo, amounts[i]);
+            hi = max(hi, amounts[i]);
+        }
+        minAmount = lo;
+        maxAmount = hi;
+    }
+
+    void addToScalar(double *sums, const double *values, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            sums[i] += values[i];
+        }
+    }
+
+#ifdef POSTING_KERNELS_AVX2
+
+    /***** AVX2 Kernels *****/
+
+    // Widens four 0/1 type flags into a lane mask (all ones where the flag is set)
+    __attribute__((target("avx2")))
+    inline __m256d flagMask(const unsigned char *flags) {
+        uint32_t packed;
+        memcpy(&packed, flags, sizeof(packed));
+        __m256i wide = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(static_cast<int>(packed)));
+        return _mm256_castsi256_pd(_mm256_cmpgt_epi64(wide, _mm256_setzero_si256()));
+    }
+
+    __attribute__((target("avx2")))
+    inline double horizontalSum(__m256d v) {
+        __m128d low = _mm256_castpd256_pd128(v);
+        __m128d high = _mm256_extractf128_pd(v, 1);
+        low = _mm_add_pd(low, high);
+        return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+    }
+
+    __attribute__((target("avx2")))
+    double signedSumAvx2(const double *amounts, const unsigned char *credit, size_t n) {
+        const __m256d signBit = _mm256_set1_pd(-0.0);
+        __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            // Flip the sign bit of credit lanes, then accumulate
+            __m256d a0 = _mm256_xor_pd(_mm256_loadu_pd(amounts + i), _mm256_and_pd(flagMask(credit + i), signBit));
+            __m256d a1 = _mm256_xor_pd(_mm256_loadu_pd(amounts + i + 4), _mm256_and_pd(flagMask(credit + i + 4), signBit));
+            acc0 = _mm256_add_pd(acc0, a0);
+            acc1 = _mm256_add_pd(acc1, a1);
+        }
+        double sum = horizontalSum(_mm256_add_pd(acc0, acc1));
+        return sum + signedSumScalar(amounts + i, credit + i, n - i);
+    }
+
+    __attribute__((target("avx2")))
+    double filteredSumAvx2(const double *amounts, const unsigned char *credit, size_t n,
+                           int typeFilter, double minAmount) {
+        const __m256d floor = _mm256_set1_pd(minAmount);
+        const __m256d allOnes = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        __m256d acc = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d a = _mm256_loadu_pd(amounts + i);
+            __m256d keep = _mm256_cmp_pd(a, floor, _CMP_GE_OQ);
+            if (typeFilter != PostingKernels::ANY_TYPE) {
+                __m256d isCredit = flagMask(credit + i);
+                __m256d typeMask = (typeFilter == PostingKernels::CREDIT_ONLY) ? isCredit
+                                                                               : _mm256_xor_pd(isCredit, allOnes);
+                keep = _mm256_and_pd(keep, typeMask);
+            }
+            acc = _mm256_add_pd(acc, _mm256_and_pd(a, keep));
+        }
+        return horizontalSum(acc) + filteredSumScalar(amounts + i, credit + i, n - i, typeFilter, minAmount);
+    }
+
+    __attribute__((target("avx2,popcnt")))
+    size_t countAboveAvx2(const double *amounts, size_t n, double threshold) {
+        const __m256d limit = _mm256_set1_pd(threshold);
+        size_t count = 0;
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d above = _mm256_cmp_pd(_mm256_loadu_pd(amounts + i), limit, _CMP_GT_OQ);
+            count += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(_mm256_movemask_pd(above))));
+        }
+        return count + countAboveScalar(amounts + i, n - i, threshold);
+    }
+
+    __attribute__((target("avx2")))
+    void minMaxAvx2(const double *amounts, size_t n, double &minAmount, double &maxAmount) {
+        if (n < 4) {
+            minMaxScalar(amounts, n, minAmount, maxAmount);
+            return;
+        }
+        __m256d lo = _mm256_loadu_pd(amounts), hi = lo;
+        size_t i = 4;
+        for (; i + 4 <= n; i += 4) {
+            __m256d a = _mm256_loadu_pd(amounts + i);
+            lo = _mm256_min_pd(lo, a);
+            hi = _mm256_max_pd(hi, a);
+        }
+        double lanes[4];
+        _mm256_storeu_pd(lanes, lo);
+        double loValue = min(min(lanes[0], lanes[1]), min(lanes[2], lanes[3]));
+        _mm256_storeu_pd(lanes, hi);
+        double hiValue = max(max(lanes[0], lanes[1]), max(lanes[2], lanes[3]));
+        for (; i < n; ++i) {
+            loValue = min(loValue, amounts[i]);
+            hiValue = max(hiValue, amounts[i]);
+        }
+        minAmount = loValue;
+        maxAmount = hiValue;
+    }
+
+    __attribute__((target("avx2")))
+    void addToAvx2(double *sums, const double *values, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_pd(sums + i, _mm256_add_pd(_mm256_loadu_pd(sums + i), _mm256_loadu_pd(values + i)));
+            _mm256_storeu_pd(sums + i + 4, _mm256_add_pd(_mm256_loadu_pd(sums + i + 4),
+                                                         _mm256_loadu_pd(values + i + 4)));
+        }
+        addToScalar(sums + i, values + i, n - i);
+    }
+
+#endif // POSTING_KERNELS_AVX2
+
+    bool detectAvx2() {
+#ifdef POSTING_KERNELS_AVX2
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+
+    bool useSimd = detectAvx2();
+}
+
+// Returns true if the AVX2 kernels can run on this CPU
+bool PostingKernels::simdAvailable() {
+    static const bool available = detectAvx2();
+    return available;
+}
+
+// Returns true if the AVX2 kernels are currently selected
+bool PostingKernels::simdEnabled() {
+    return useSimd;
+}
+
+// Enables or disables the AVX2 kernels (ignored without AVX2 support)
+void PostingKernels::setSimdEnabled(bool enabled) {
+    useSimd = enabled && simdAvailable();
+}
+
+// Returns the sum of debits minus the sum of credits
+double PostingKernels::signedSum(const double *amounts, const unsigned char *credit, size_t n) {
+#ifdef POSTING_KERNELS_AVX2
+    if (useSimd) return signedSumAvx2(amounts, credit, n);
+#endif
+    return signedSumScalar(amounts, credit, n);
+}
+
+// Returns the sum of amounts of the selected type at or above the minimum
+double PostingKernels::filteredSum(const double *amounts, const unsigned char *credit, size_t n,
+                                   int typeFilter, double minAmount) {
+#ifdef POSTING_KERNELS_AVX2
+    if (useSimd) return filteredSumAvx2(amounts, credit, n, typeFilter, minAmount);
+#endif
+    return filteredSumScalar(amounts, credit, n, typeFilter, minAmount);
+}
+
+// Returns the number of amounts strictly greater than the threshold
+size_t PostingKernels::countAbove(const double *amounts, size_t n, double threshold) {
+#ifdef POSTING_KERNELS_AVX2
+    if (useSimd) return countAboveAvx2(amounts, n, threshold);
+#endif
+    return countAboveScalar(amounts, n, threshold);
+}
+
+// Computes the smallest and largest amount
+bool PostingKernels::minMax(const double *amounts, size_t n, double &minAmount, double &maxAmount) {
+    if (n == 0) {
+        return false;
+    }
+#ifdef POSTING_KERNELS_AVX2
+    if (useSimd) {
+        minMaxAvx2(amounts, n, minAmount, maxAmount);
+        return true;
+    }
+#endif
+    minMaxScalar(amounts, n, minAmount, maxAmount);
+    return true;
+}
+
+// Adds one array into another, element by element
+void PostingKernels::addTo(double *sums, const double *values, size_t n) {
+#ifdef POSTING_KERNELS_AVX2
+    if (useSimd) {
+        addToAvx2(sums, values, n);
+        return;
+    }
+#endif
+    addToScalar(sums, values, n);
+}
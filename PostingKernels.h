@@ -0,0 +1,92 @@
+#ifndef POSTINGKERNELS_H
+#define POSTINGKERNELS_H
+
+/**-- PostingKernels.h ------------------------------------------------------
+  This header file declares aggregation kernels over column-wise posting
+  data: a contiguous array of amounts and a parallel array of type flags
+  (0 for Debit, 1 for Credit). Each kernel has an AVX2 implementation and a
+  portable scalar fallback; the AVX2 path is selected at run time when the
+  CPU supports it.
+
+  Basic operations:
+    simdAvailable:  Returns true if the AVX2 kernels can run on this CPU.
+    setSimdEnabled: Enables or disables the AVX2 path (e.g. for comparison).
+    signedSum:      Sum of debits minus sum of credits.
+    filteredSum:    Sum of amounts of one type (or both) at or above a minimum.
+    countAbove:     Number of amounts strictly greater than a threshold.
+    minMax:         Smallest and largest amount.
+    addTo:          Element-wise addition of one array into another.
+
+  Notes:
+    1. Amounts are non-negative; the type flag carries the sign.
+    2. SIMD sums may differ from scalar sums in the last bits because the
+       additions are performed in a different order.
+--------------------------------------------------------------------------**/
+
+#include <cstddef>
+
+namespace PostingKernels {
+
+    // Type filter values for filteredSum
+    const int ANY_TYPE = -1;
+    const int DEBIT_ONLY = 0;
+    const int CREDIT_ONLY = 1;
+
+    /*------------------------------------------------------------------------
+      Reports and controls whether the AVX2 kernels are used.
+
+      Precondition:  None.
+      Post-condition: setSimdEnabled(true) has no effect on CPUs without AVX2.
+    -----------------------------------------------------------------------*/
+    bool simdAvailable();
+
+    bool simdEnabled();
+
+    void setSimdEnabled(bool enabled);
+
+    /*------------------------------------------------------------------------
+      Returns the sum of debit amounts minus the sum of credit amounts.
+
+      Precondition:  amounts and credit point to n elements each.
+      Post-condition: Returns the signed sum (0 for n == 0).
+    -----------------------------------------------------------------------*/
+    double signedSum(const double *amounts, const unsigned char *credit, size_t n);
+
+    /*------------------------------------------------------------------------
+      Returns the sum of the amounts of the selected type (ANY_TYPE,
+      DEBIT_ONLY or CREDIT_ONLY) that are greater than or equal to minAmount.
+
+      Precondition:  amounts and credit point to n elements each.
+      Post-condition: Returns the filtered, unsigned sum.
+    -----------------------------------------------------------------------*/
+    double filteredSum(const double *amounts, const unsigned char *credit, size_t n,
+                       int typeFilter, double minAmount);
+
+    /*------------------------------------------------------------------------
+      Returns the number of amounts strictly greater than the threshold.
+
+      Precondition:  amounts points to n elements.
+      Post-condition: Returns the count.
+    -----------------------------------------------------------------------*/
+    size_t countAbove(const double *amounts, size_t n, double threshold);
+
+    /*------------------------------------------------------------------------
+      Computes the smallest and largest amount.
+
+      Precondition:  amounts points to n elements.
+      Post-condition: Returns false (outputs untouched) if n == 0; otherwise
+                      stores the extremes and returns true.
+    -----------------------------------------------------------------------*/
+    bool minMax(const double *amounts, size_t n, double &minAmount, double &maxAmount);
+
+    /*------------------------------------------------------------------------
+      Adds values[i] to sums[i] for every i (e.g. to roll balance arrays up).
+
+      Precondition:  sums and values point to n elements each and do not
+                     partially overlap.
+      Post-condition: sums holds the element-wise totals.
+    -----------------------------------------------------------------------*/
+    void addTo(double *sums, const double *values, size_t n);
+}
+
+#endif // POSTINGKERNELS_H
@@ -0,0 +1,301 @@
+#include "PostingPipeline.h"
+#include "NumberParsing.h"
+#include "SpscQueue.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+    using Clock = chrono::steady_clock;
+    using Batch = vector<PostingPipeline::Posting>;
+
+    double secondsBetween(Clock::time_point from, Clock::time_point to) {
+        return chrono::duration<double>(to - from).count();
+    }
+
+    // Pops batches from `in`, applies `work` to each posting (or to the whole batch, if it
+    // takes one) and pushes the batch to `out`
+    template<typename Work>
+    void runStage(SpscQueue<Batch> &in, SpscQueue<Batch> *out, PostingPipeline::StageStats &stats, Work work) {
+        Batch batch;
+        while (true) {
+            auto waitStart = Clock::now();
+            bool received = in.pop(batch);
+            auto workStart = Clock::now();
+            stats.waitSeconds += secondsBetween(waitStart, workStart);
+            if (!received) break;
+
+            if constexpr (is_invocable_v<Work, Batch &>) {
+                work(batch);
+            } else {
+                for (PostingPipeline::Posting &posting: batch) {
+                    work(posting);
+                }
+            }
+            stats.items += batch.size();
+            auto workEnd = Clock::now();
+            stats.busySeconds += secondsBetween(workStart, workEnd);
+
+            if (out) {
+                out->push(move(batch));
+                batch = Batch();
+                stats.waitSeconds += secondsBetween(workEnd, Clock::now());
+            }
+        }
+        if (out) out->close();
+    }
+
+    const char *const WHITESPACE_OR_COMMA = " \t\r\n\v\f,";
+}
+
+// Constructors binding the pipeline to a tree and a configuration
+PostingPipeline::PostingPipeline(ForestTree &tree) : PostingPipeline(tree, Config()) {}
+
+PostingPipeline::PostingPipeline(ForestTree &tree, const Config &config) : tree(tree), config(config) {
+    if (this->config.batchSize == 0) this->config.batchSize = 1;
+    if (this->config.queueCapacity == 0) this->config.queueCapacity = 1;
+}
+
+// Returns the display name of a stage
+const char *PostingPipeline::stageName(Stage stage) {
+    static const char *const names[] = {"read", "parse", "validate", "apply", "journal"};
+    return names[stage];
+}
+
+// Parses one feed line into a posting; sets `error` if the line is malformed
+void PostingPipeline::parseLine(Posting &posting) {
+    const string &text = posting.text;
+    string_view fields[5];
+    size_t count = 0, position = 0;
+    while (count < 5) {
+        size_t start = text.find_first_not_of(WHITESPACE_OR_COMMA, position);
+        if (start == string::npos) break;
+        size_t end = text.find_first_of(WHITESPACE_OR_COMMA, start);
+        if (end == string::npos) end = text.size();
+        fields[count++] = string_view(text).substr(start, end - start);
+        position = end;
+    }
+    if (count < 3 || count > 4) {
+        posting.error = "Expected <account> <amount> <D|C> [<YYYY-MM-DD>]";
+        return;
+    }
+
+    // Numbers are parsed in place: each field ends at a delimiter or at the end of the line
+    if (!NumberParsing::parseInt(fields[0], posting.accountNumber)) {
+        posting.error = "Invalid account number: " + string(fields[0]);
+        return;
+    }
+
+    char *end = nullptr;
+    posting.amount = strtod(fields[1].data(), &end);
+    if (end != fields[1].data() + fields[1].size()) {
+        posting.error = "Invalid amount: " + string(fields[1]);
+        return;
+    }
+
+    string_view type = fields[2];
+    posting.type = (type == "D" || type == "d" || type == "Debit") ? 'D'
+                 : (type == "C" || type == "c" || type == "Credit") ? 'C' : '\0';
+
+    if (count == 4) {
+        try {
+            posting.date = Transaction::parseDate(string(fields[3]));
+        } catch (const exception &e) {
+            posting.error = e.what();
+        }
+    }
+}
+
+// Ingests every posting of a feed
+PostingPipeline::Report PostingPipeline::run(istream &feed, ostream *journal, ostream *rejects) {
+    Report report;
+    SpscQueue<Batch> toParse(config.queueCapacity), toValidate(config.queueCapacity),
+            toApply(config.queueCapacity), toJournal(config.queueCapacity);
+
+    // Journaled batches return to the reader, whose lines then reuse their string buffers.
+    // A batch is only created while none is waiting here, so at most every queue plus one
+    // batch per stage is ever alive, and the return queue never fills.
+    SpscQueue<Batch> recycled(4 * toParse.capacity() + STAGE_COUNT + 1);
+    auto started = Clock::now();
+
+    // parse: fields of each line
+    thread parser([&] {
+        StageStats &stats = report.stages[PARSE];
+        runStage(toParse, &toValidate, stats, [&stats](Posting &posting) {
+            parseLine(posting);
+            if (!posting.error.empty()) ++stats.rejected;
+        });
+    });
+
+    // validate: checks that do not depend on balances, over the columns of a whole batch
+    thread validator([&] {
+        StageStats &stats = report.stages[VALIDATE];
+        vector<int> accountNumbers, slots;
+        vector<double> amounts;
+        vector<char> types;
+        vector<unsigned char> verdicts;
+        runStage(toValidate, &toApply, stats, [&](Batch &batch) {
+            accountNumbers.resize(batch.size());
+            amounts.resize(batch.size());
+            types.resize(batch.size());
+            slots.resize(batch.size());
+            verdicts.resize(batch.size());
+            for (size_t i = 0; i < batch.size(); ++i) {
+                accountNumbers[i] = batch[i].accountNumber;
+                amounts[i] = batch[i].amount;
+                types[i] = batch[i].type;
+            }
+            tree.validatePostings(accountNumbers.data(), amounts.data(), types.data(), batch.size(), slots.data(),
+                                  verdicts.data());
+
+            for (size_t i = 0; i < batch.size(); ++i) {
+                Posting &posting = batch[i];
+                if (!posting.error.empty()) continue;
+                PostingRules::Verdict verdict = static_cast<PostingRules::Verdict>(verdicts[i]);
+                if (verdict == PostingRules::BAD_TYPE) {
+                    posting.error = PostingRules::verdictMessage(verdict);
+                } else if (verdict == PostingRules::BAD_AMOUNT) {
+                    posting.error = "Amount must be positive";
+                } else if (verdict != PostingRules::OK) {
+                    posting.error = PostingRules::verdictMessage(verdict);
+                }
+                if (!posting.error.empty()) ++stats.rejected;
+            }
+        });
+    });
+
+    // apply: the only thread that writes to the tree
+    thread applier([&] {
+        StageStats &stats = report.stages[APPLY];
+        runStage(toApply, &toJournal, stats, [this, &stats](Posting &posting) {
+            if (!posting.error.empty()) return;
+            try {
+                tree.emplaceTransaction(posting.accountNumber, posting.amount, posting.type, posting.date);
+            } catch (const exception &e) {
+                posting.error = e.what();
+                ++stats.rejected;
+            }
+        });
+    });
+
+    // journal: replayable record of applied postings, and the rejects
+    thread journaler([&] {
+        StageStats &stats = report.stages[JOURNAL];
+        char buffer[96];
+        runStage(toJournal, &recycled, stats, [&](Posting &posting) {
+            if (!posting.error.empty()) {
+                ++report.rejected;
+                if (rejects) {
+                    *rejects << "line " << posting.lineNumber << ": " << posting.error << ": " << posting.text << '\n';
+                }
+                return;
+            }
+            ++report.applied;
+            if (journal) {
+                int length = snprintf(buffer, sizeof(buffer), "post %d %.2f %c", posting.accountNumber,
+                                      posting.amount, posting.type);
+                journal->write(buffer, length);
+                if (posting.date != 0) {
+                    *journal << ' ' << Transaction::formatDate(posting.date);
+                }
+                *journal << '\n';
+            }
+        });
+        if (journal) journal->flush();
+        if (rejects) rejects->flush();
+    });
+
+    // read: the calling thread
+    {
+        StageStats &stats = report.stages[READ];
+        Batch batch;
+        batch.reserve(config.batchSize);
+        size_t used = 0;                // Postings of `batch` filled so far
+        long long lineNumber = 0;
+        auto workStart = Clock::now();
+        while (true) {
+            if (used == batch.size()) batch.emplace_back();
+            Posting &posting = batch[used];
+            if (!getline(feed, posting.text)) break;
+            ++lineNumber;
+            size_t start = posting.text.find_first_not_of(" \t\r");
+            if (start == string::npos || posting.text[start] == '#') continue;
+
+            posting.lineNumber = lineNumber;
+            posting.accountNumber = 0;
+            posting.amount = 0.0;
+            posting.type = '\0';
+            posting.date = 0;
+            posting.error.clear();
+            if (++used == config.batchSize) {
+                stats.items += used;
+                auto workEnd = Clock::now();
+                stats.busySeconds += secondsBetween(workStart, workEnd);
+                toParse.push(move(batch));
+                if (!recycled.tryPop(batch)) {
+                    batch = Batch();
+                    batch.reserve(config.batchSize);
+                }
+                used = 0;
+                workStart = Clock::now();
+                stats.waitSeconds += secondsBetween(workEnd, workStart);
+            }
+        }
+        batch.resize(used);
+        stats.items += used;
+        stats.busySeconds += secondsBetween(workStart, Clock::now());
+        if (!batch.empty()) toParse.push(move(batch));
+        toParse.close();
+    }
+
+    parser.join();
+    validator.join();
+    applier.join();
+    journaler.join();
+    report.seconds = secondsBetween(started, Clock::now());
+
+    SpscQueue<Batch> *queues[] = {&toParse, &toValidate, &toApply, &toJournal};
+    for (int i = 0; i < STAGE_COUNT - 1; ++i) {
+        report.queues[i].capacity = queues[i]->capacity();
+        report.queues[i].maxDepth = queues[i]->maxDepth();
+        report.queues[i].meanDepth = queues[i]->meanDepth();
+    }
+    return report;
+}
+
+// Renders a report as text
+string PostingPipeline::formatReport(const Report &report) {
+    ostringstream out;
+    char line[160];
+    snprintf(line, sizeof(line), "%-9s %12s %10s %10s %10s %14s\n", "stage", "items", "rejected", "busy s", "wait s",
+             "items/busy s");
+    out << line;
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        const StageStats &stats = report.stages[i];
+        double rate = stats.busySeconds > 0 ? static_cast<double>(stats.items) / stats.busySeconds : 0.0;
+        snprintf(line, sizeof(line), "%-9s %12llu %10llu %10.3f %10.3f %14.0f\n", stageName(static_cast<Stage>(i)),
+                 static_cast<unsigned long long>(stats.items), static_cast<unsigned long long>(stats.rejected),
+                 stats.busySeconds, stats.waitSeconds, rate);
+        out << line;
+    }
+    for (int i = 0; i < STAGE_COUNT - 1; ++i) {
+        const QueueStats &queue = report.queues[i];
+        snprintf(line, sizeof(line), "queue %s -> %s: capacity %zu batches, max depth %zu, mean depth %.1f\n",
+                 stageName(static_cast<Stage>(i)), stageName(static_cast<Stage>(i + 1)), queue.capacity,
+                 queue.maxDepth, queue.meanDepth);
+        out << line;
+    }
+    snprintf(line, sizeof(line), "applied %llu, rejected %llu in %.3f s (%.0f postings/s)\n",
+             static_cast<unsigned long long>(report.applied), static_cast<unsigned long long>(report.rejected),
+             report.seconds, report.seconds > 0 ? static_cast<double>(report.applied) / report.seconds : 0.0);
+    out << line;
+    return out.str();
+}
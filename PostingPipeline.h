@@ -0,0 +1,121 @@
+#ifndef POSTINGPIPELINE_H
+#define POSTINGPIPELINE_H
+
+/**-- PostingPipeline.h -----------------------------------------------------
+  This header file defines the PostingPipeline class, which ingests a feed of
+  postings into a ForestTree through five stages that run concurrently, each
+  on its own thread, connected by bounded single-producer/single-consumer
+  queues (SpscQueue):
+
+    read      Reads feed lines (the calling thread).
+    parse     Splits a line into account, amount, type and date.
+    validate  Checks what does not depend on balances, a batch at a time
+              (ForestTree::validatePostings): the type is D or C, the amount
+              is positive and finite, the account exists, and the posting
+              rules accept the type and amount.
+    apply     Posts through ForestTree::emplaceTransaction, which checks the
+              balance floor of the rules and updates the ancestors.
+    journal   Writes each applied posting as a replayable "post" command, and
+              each rejected line with its reason.
+
+  Lines travel in batches so that queue traffic is per batch, not per
+  posting. A full queue blocks its producer, so a slow stage throttles the
+  stages before it and memory stays bounded by the queue capacities.
+
+  Journaled batches are handed back to the reader and refilled in place, so
+  once the pipeline is warm a line is read into an existing string buffer and
+  reaches the tree (ForestTree::emplaceTransaction) without any allocation.
+
+  Feed format: one posting per line, "<account> <amount> <D|C> [<YYYY-MM-DD>]",
+  with fields separated by spaces or commas. Blank lines and lines starting
+  with '#' are skipped.
+
+  Basic operations:
+    Constructor:   Binds the pipeline to a tree and a configuration.
+    run:           Ingests a feed and returns the per-stage report.
+    formatReport:  Renders a report as text.
+
+  Helper functions:
+    parseLine:     Parses one feed line into a posting.
+--------------------------------------------------------------------------**/
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include "ForestTree.h"
+
+using namespace std;
+
+class PostingPipeline {
+public:
+    enum Stage { READ, PARSE, VALIDATE, APPLY, JOURNAL, STAGE_COUNT };
+
+    struct Config {
+        size_t batchSize = 256;         // Lines per batch
+        size_t queueCapacity = 64;      // Batches per queue
+    };
+
+    struct StageStats {
+        uint64_t items = 0;             // Lines handled
+        uint64_t rejected = 0;          // Lines this stage rejected
+        double busySeconds = 0.0;       // Time spent working
+        double waitSeconds = 0.0;       // Time blocked on an empty input or a full output queue
+    };
+
+    struct QueueStats {
+        size_t capacity = 0;            // Batches
+        size_t maxDepth = 0;            // Largest depth seen at a push
+        double meanDepth = 0.0;         // Mean depth seen at a push
+    };
+
+    struct Report {
+        StageStats stages[STAGE_COUNT];
+        QueueStats queues[STAGE_COUNT - 1];    // queues[i] feeds stage i + 1
+        uint64_t applied = 0;
+        uint64_t rejected = 0;
+        double seconds = 0.0;                  // Wall time of the run
+    };
+
+    struct Posting {
+        long long lineNumber = 0;
+        string text;                    // Raw line (kept for rejects)
+        int accountNumber = 0;
+        double amount = 0.0;
+        char type = '\0';
+        int date = 0;
+        string error;                   // Non-empty once rejected
+    };
+
+private:
+    ForestTree &tree;
+    Config config;
+
+    static void parseLine(Posting &posting);
+
+public:
+    /***** Constructor *****/
+    explicit PostingPipeline(ForestTree &tree);
+
+    PostingPipeline(ForestTree &tree, const Config &config);
+
+    /***** Run *****/
+    /*------------------------------------------------------------------------
+      Ingests every posting of a feed. Rejected lines are reported and skipped;
+      they never stop the feed. The tree must not be used by other threads
+      during the run.
+
+      Precondition:  journal and rejects may be null (nothing is written).
+      Post-condition: Every valid posting is applied in feed order; returns
+                      the per-stage and per-queue statistics.
+    -----------------------------------------------------------------------*/
+    Report run(istream &feed, ostream *journal, ostream *rejects);
+
+    /***** Report *****/
+    static string formatReport(const Report &report);
+
+    static const char *stageName(Stage stage);
+};
+
+#endif // POSTINGPIPELINE_H
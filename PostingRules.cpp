@@ -0,0 +1,127 @@
+#include "PostingRules.h"
+#include "MemoryUsage.h"
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// Sets the rule of a subtree after checking it
+void PostingRules::setRule(int subtree, const Rule &rule) {
+    if (subtree < 1 || subtree > 99999) {
+        throw invalid_argument("Invalid account number: " + to_string(subtree) + ".");
+    }
+    if (isnan(rule.floor) || isnan(rule.limit) || !(rule.limit > 0.0)) {
+        throw invalid_argument("A rule needs a floor and a positive limit.");
+    }
+    if (rule.types == 0 || (rule.types & ~(DEBITS | CREDITS)) != 0) {
+        throw invalid_argument("A rule must accept debits, credits or both.");
+    }
+    rules[subtree] = rule;
+}
+
+// Removes the rule of a subtree; returns false if it had none
+bool PostingRules::removeRule(int subtree) {
+    return rules.erase(subtree) > 0;
+}
+
+// Removes every rule
+void PostingRules::clearRules() {
+    rules.clear();
+}
+
+// Returns the configured rules
+const map<int, PostingRules::Rule> &PostingRules::getRules() const {
+    return rules;
+}
+
+// Returns the rule of the nearest number prefix that has one
+PostingRules::Rule PostingRules::ruleFor(int accountNumber) const {
+    if (!rules.empty()) {
+        for (int prefix = accountNumber; prefix > 0; prefix /= 10) {
+            auto it = rules.find(prefix);
+            if (it != rules.end()) {
+                return it->second;
+            }
+        }
+    }
+    return Rule();
+}
+
+// Compiles an account's rule into its slot of the check table
+void PostingRules::compileSlot(int slot, int accountNumber) {
+    size_t index = static_cast<size_t>(slot);
+    if (index >= floors.size()) {
+        size_t size = max(index + 1, floors.size() * 2);
+        floors.resize(size, 0.0);
+        limits.resize(size, numeric_limits<double>::infinity());
+        types.resize(size, DEBITS | CREDITS);
+    }
+    Rule rule = ruleFor(accountNumber);
+    floors[index] = rule.floor;
+    limits[index] = rule.limit;
+    types[index] = rule.types;
+}
+
+// Drops the compiled table
+void PostingRules::resetTable() {
+    floors.clear();
+    limits.clear();
+    types.clear();
+}
+
+// Checks arrays of postings against the table, all checks but the floor
+size_t PostingRules::checkBatch(const int *slots, const double *amounts, const char *debitOrCredit, size_t n,
+                                unsigned char *verdicts) const {
+    size_t failed = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int slot = slots[i];
+        double amount = amounts[i];
+        unsigned char mask = (debitOrCredit[i] == 'D') ? DEBITS : (debitOrCredit[i] == 'C') ? CREDITS : 0;
+        bool known = slot >= 0 && static_cast<size_t>(slot) < limits.size();
+        size_t index = known ? static_cast<size_t>(slot) : 0;
+        Verdict verdict = OK;
+        if (known) {    // Predictable: unknown accounts are rare
+            verdict = (amount > limits[index]) ? OVER_LIMIT : verdict;
+            verdict = ((types[index] & mask) == 0) ? TYPE_NOT_ALLOWED : verdict;
+        }
+        verdict = known ? verdict : UNKNOWN_ACCOUNT;
+        verdict = !(amount > 0.0 && amount - amount == 0.0) ? BAD_AMOUNT : verdict;
+        verdict = (mask == 0) ? BAD_TYPE : verdict;
+        verdicts[i] = verdict;
+        failed += verdict != OK;
+    }
+    return failed;
+}
+
+// Checks one posting against the rule of an account number, all checks but the floor
+PostingRules::Verdict PostingRules::checkNumber(int accountNumber, double amount, char debitOrCredit) const {
+    unsigned char mask = (debitOrCredit == 'D') ? DEBITS : (debitOrCredit == 'C') ? CREDITS : 0;
+    Rule rule = ruleFor(accountNumber);
+    Verdict verdict = OK;
+    verdict = (amount > rule.limit) ? OVER_LIMIT : verdict;
+    verdict = ((rule.types & mask) == 0) ? TYPE_NOT_ALLOWED : verdict;
+    verdict = !(amount > 0.0 && amount - amount == 0.0) ? BAD_AMOUNT : verdict;
+    verdict = (mask == 0) ? BAD_TYPE : verdict;
+    return verdict;
+}
+
+// Returns the error message of a verdict
+const char *PostingRules::verdictMessage(Verdict verdict) {
+    switch (verdict) {
+        case OK: return "OK";
+        case UNKNOWN_ACCOUNT: return "Account not found";
+        case BAD_TYPE: return "Invalid transaction type. Use 'D' for Debit or 'C' for Credit.";
+        case BAD_AMOUNT: return "Amount must be a positive, finite number";
+        case TYPE_NOT_ALLOWED: return "Transaction is invalid: this posting type is not allowed on the account.";
+        case OVER_LIMIT: return "Transaction is invalid: amount exceeds the posting limit of the account.";
+        case BELOW_FLOOR: return "Transaction is invalid: Insufficient balance for credit transaction.";
+    }
+    return "Invalid posting";
+}
+
+// Returns the bytes of the configured rules and of the compiled table
+size_t PostingRules::memoryBytes() const {
+    return MemoryUsage::treeBytes(rules) + MemoryUsage::vectorBytes(floors) + MemoryUsage::vectorBytes(limits) +
+           MemoryUsage::vectorBytes(types);
+}
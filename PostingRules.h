@@ -0,0 +1,159 @@
+#ifndef POSTINGRULES_H
+#define POSTINGRULES_H
+
+/**-- PostingRules.h --------------------------------------------------------
+  This header file defines the PostingRules class, the posting validation
+  rules of a ForestTree.
+
+  A rule applies to a subtree, named by the account number at its top, and
+  sets:
+    - floor:  the lowest balance a credit may leave (0 by default, so a
+              credit may not exceed the balance; -infinity allows negative
+              balances, e.g. on liability classes);
+    - limit:  the largest amount of a single posting (+infinity by default);
+    - types:  whether debits and/or credits are accepted.
+  An account follows the rule of the nearest number prefix that has one
+  (itself, its parent number, ...), or the default rule.
+
+  Rules are compiled into a flat check table indexed by account slot: one
+  floor, one limit and one type mask per slot. A check is a few loads and
+  comparisons combined without branches, and runs before anything is stored.
+  checkBatch applies the checks that do not depend on balances to arrays of
+  postings, e.g. in the validate stage of PostingPipeline.
+
+  Basic operations:
+    setRule / removeRule / clearRules: Configure the rules by subtree.
+    getRules:         Returns the configured rules by subtree.
+    ruleFor:          Returns the rule an account number follows.
+    compileSlot:      Compiles the rule of an account into its slot.
+    resetTable:       Drops the compiled table.
+    check:            Checks one posting against its slot and the balance.
+    checkBatch:       Checks arrays of postings, balances excepted.
+    checkNumber:      Checks a posting by account number, balances excepted.
+    verdictMessage:   Error message of a verdict.
+    memoryBytes:      Returns the memory held by the rules and the table.
+
+  Class Invariant:
+    1. Every live slot of the tree's accounts was compiled from the current
+       rules (the ForestTree recompiles on account and rule changes).
+    2. floors, limits and types have the same size.
+--------------------------------------------------------------------------**/
+
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+class PostingRules {
+public:
+    enum Verdict : unsigned char {
+        OK, UNKNOWN_ACCOUNT, BAD_TYPE, BAD_AMOUNT, TYPE_NOT_ALLOWED, OVER_LIMIT, BELOW_FLOOR
+    };
+
+    // Type mask bits
+    static const unsigned char DEBITS = 1;
+    static const unsigned char CREDITS = 2;
+
+    struct Rule {
+        double floor = 0.0;                                     // Lowest balance a credit may leave
+        double limit = numeric_limits<double>::infinity();      // Largest single posting
+        unsigned char types = DEBITS | CREDITS;                 // Accepted posting types
+    };
+
+private:
+    map<int, Rule> rules;          // Configured rules by subtree (top account number)
+    vector<double> floors;         // Compiled floor per slot
+    vector<double> limits;         // Compiled limit per slot
+    vector<unsigned char> types;   // Compiled type mask per slot
+
+public:
+    /***** Rule Configuration *****/
+    /*------------------------------------------------------------------------
+      Sets or removes the rule of a subtree, or removes every rule.
+
+      Precondition:  subtree is a valid account number; rule.types is not 0.
+      Post-condition: The rules are updated; the table must be recompiled.
+                      setRule throws invalid_argument for a bad rule.
+    -----------------------------------------------------------------------*/
+    void setRule(int subtree, const Rule &rule);
+
+    bool removeRule(int subtree);
+
+    void clearRules();
+
+    const map<int, Rule> &getRules() const;
+
+    /*------------------------------------------------------------------------
+      Returns the rule of the nearest number prefix of an account that has
+      one, or the default rule.
+
+      Precondition:  None.
+      Post-condition: Returns the rule.
+    -----------------------------------------------------------------------*/
+    Rule ruleFor(int accountNumber) const;
+
+    /***** Check Table *****/
+    /*------------------------------------------------------------------------
+      Compiles the rule of an account into its slot, or drops the table.
+
+      Precondition:  slot >= 0.
+      Post-condition: check(slot, ...) follows ruleFor(accountNumber).
+    -----------------------------------------------------------------------*/
+    void compileSlot(int slot, int accountNumber);
+
+    void resetTable();
+
+    /*------------------------------------------------------------------------
+      Checks one posting of a compiled slot against the account's current
+      balance (for a credit, the balance must stay at or above the floor).
+
+      Precondition:  The slot was compiled.
+      Post-condition: Returns OK or the first failed check, in the order
+                      BAD_TYPE, BAD_AMOUNT (not positive and finite), TYPE_NOT_ALLOWED,
+                      OVER_LIMIT, BELOW_FLOOR.
+    -----------------------------------------------------------------------*/
+    Verdict check(int slot, double amount, char debitOrCredit, double balance) const {
+        unsigned char mask = (debitOrCredit == 'D') ? DEBITS : (debitOrCredit == 'C') ? CREDITS : 0;
+        bool credit = mask == CREDITS;
+        Verdict verdict = OK;
+        verdict = (credit && balance < amount + floors[slot]) ? BELOW_FLOOR : verdict;
+        verdict = (amount > limits[slot]) ? OVER_LIMIT : verdict;
+        verdict = ((types[slot] & mask) == 0) ? TYPE_NOT_ALLOWED : verdict;
+        verdict = !(amount > 0.0 && amount - amount == 0.0) ? BAD_AMOUNT : verdict;   // Not positive and finite
+        verdict = (mask == 0) ? BAD_TYPE : verdict;
+        return verdict;
+    }
+
+    /*------------------------------------------------------------------------
+      Checks n postings given as arrays, every check but the balance floor
+      (balances are only known when each posting is applied). A slot of -1
+      marks an unknown account.
+
+      Precondition:  Every array holds n elements; slots are -1 or compiled.
+      Post-condition: verdicts[i] holds OK or the first failed check of
+                      posting i, in the order BAD_TYPE, BAD_AMOUNT,
+                      UNKNOWN_ACCOUNT, TYPE_NOT_ALLOWED, OVER_LIMIT; returns
+                      the number of postings that failed.
+    -----------------------------------------------------------------------*/
+    size_t checkBatch(const int *slots, const double *amounts, const char *debitOrCredit, size_t n,
+                      unsigned char *verdicts) const;
+
+    /*------------------------------------------------------------------------
+      Checks one posting against the rule an account number follows, every
+      check but the balance floor, for an account with no compiled slot yet
+      (e.g. while a loader works out opening balances).
+
+      Precondition:  None.
+      Post-condition: Returns OK or the first failed check, in the order
+                      BAD_TYPE, BAD_AMOUNT, TYPE_NOT_ALLOWED, OVER_LIMIT.
+    -----------------------------------------------------------------------*/
+    Verdict checkNumber(int accountNumber, double amount, char debitOrCredit) const;
+
+    static const char *verdictMessage(Verdict verdict);
+
+    size_t memoryBytes() const;
+};
+
+#endif // POSTINGRULES_H
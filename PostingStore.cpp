@@ -0,0 +1,293 @@
+#include "PostingStore.h"
+#include "MemoryUsage.h"
+#include <stdexcept>
+
+using namespace std;
+
+/***** PostingRef *****/
+
+PostingRef::PostingRef(const PostingStore *store, size_t position) : store(store), position(position) {}
+
+// Returns the transaction ID of the posting
+int PostingRef::getTransactionID() const {
+    return store->getIdColumn()[position];
+}
+
+// Returns the amount of the posting
+double PostingRef::getAmount() const {
+    return store->getAmountColumn()[position];
+}
+
+// Returns 'D' for Debit or 'C' for Credit
+char PostingRef::getDebitOrCredit() const {
+    return store->getCreditColumn()[position] ? 'C' : 'D';
+}
+
+// Returns the posting date (YYYYMMDD, 0 if undated)
+int PostingRef::getDate() const {
+    return store->getDateColumn()[position];
+}
+
+// Materializes the posting as a Transaction value
+Transaction PostingRef::toTransaction() const {
+    Transaction transaction(getAmount(), getDebitOrCredit(), getDate());
+    transaction.setTransactionID(getTransactionID());
+    return transaction;
+}
+
+/***** PostingView *****/
+
+PostingView::PostingView(const PostingStore *store, size_t offset, size_t count)
+        : store(store), offset(offset), count(count) {}
+
+const int *PostingView::ids() const {
+    return store->getIdColumn().data() + offset;
+}
+
+const double *PostingView::amounts() const {
+    return store->getAmountColumn().data() + offset;
+}
+
+const unsigned char *PostingView::credits() const {
+    return store->getCreditColumn().data() + offset;
+}
+
+const int *PostingView::dates() const {
+    return store->getDateColumn().data() + offset;
+}
+
+/***** PostingStore *****/
+
+// Constructor: Initializes an empty store
+PostingStore::PostingStore() = default;
+
+// Removes every slot and posting
+void PostingStore::clear() {
+    accountColumn.clear();
+    idColumn.clear();
+    amountColumn.clear();
+    creditColumn.clear();
+    dateColumn.clear();
+    segments.clear();
+    freeSlots.clear();
+}
+
+// Reserves an empty slot for an account, reusing released slots first
+int PostingStore::allocateSlot(int accountNumber) {
+    if (accountNumber <= 0) {
+        throw invalid_argument("Posting slots require a positive account number.");
+    }
+
+    Segment segment{accountColumn.size(), 0, 0, accountNumber};
+    if (!freeSlots.empty()) {
+        int slot = freeSlots.back();
+        freeSlots.pop_back();
+        segments[slot] = segment;
+        return slot;
+    }
+    segments.push_back(segment);
+    return static_cast<int>(segments.size()) - 1;
+}
+
+// Frees a slot; its column range becomes slack
+void PostingStore::releaseSlot(int slot) {
+    Segment &segment = segments[slot];
+    fill(accountColumn.begin() + segment.offset, accountColumn.begin() + segment.offset + segment.size, 0);
+    segment = Segment{0, 0, 0, 0};
+    freeSlots.push_back(slot);
+}
+
+// Makes room for one more posting, doubling the segment when it is full
+void PostingStore::reserveOne(int slot) {
+    const Segment &segment = segments[slot];
+    if (segment.size < segment.capacity) {
+        return;
+    }
+    grow(slot, max<size_t>(4, segment.capacity * 2));
+}
+
+// Reserves room for a number of postings in a slot
+void PostingStore::reserve(int slot, size_t capacity) {
+    if (capacity > segments[slot].capacity) {
+        grow(slot, capacity);
+    }
+}
+
+// Reserves room for further postings, at least doubling the segment when it grows
+void PostingStore::reserveMore(int slot, size_t count) {
+    const Segment &segment = segments[slot];
+    if (segment.size + count > segment.capacity) {
+        grow(slot, max(segment.size + count, max<size_t>(4, segment.capacity * 2)));
+    }
+}
+
+// Grows a segment in place or relocates it to the end of the columns
+void PostingStore::grow(int slot, size_t newCapacity) {
+    Segment &segment = segments[slot];
+    size_t end = accountColumn.size();
+
+    // The last segment (or an empty one) simply extends the columns
+    if (segment.offset + segment.capacity == end || segment.capacity == 0) {
+        size_t offset = (segment.offset + segment.capacity == end) ? segment.offset : end;
+        size_t newEnd = offset + newCapacity;
+        accountColumn.resize(newEnd, 0);
+        idColumn.resize(newEnd, 0);
+        amountColumn.resize(newEnd, 0.0);
+        creditColumn.resize(newEnd, 0);
+        dateColumn.resize(newEnd, 0);
+        segment.offset = offset;
+        segment.capacity = newCapacity;
+        return;
+    }
+
+    // Otherwise relocate the segment to the end and leave slack behind
+    size_t newOffset = end;
+    size_t newEnd = end + newCapacity;
+    accountColumn.resize(newEnd, 0);
+    idColumn.resize(newEnd, 0);
+    amountColumn.resize(newEnd, 0.0);
+    creditColumn.resize(newEnd, 0);
+    dateColumn.resize(newEnd, 0);
+    for (size_t i = 0; i < segment.size; ++i) {
+        accountColumn[newOffset + i] = accountColumn[segment.offset + i];
+        idColumn[newOffset + i] = idColumn[segment.offset + i];
+        amountColumn[newOffset + i] = amountColumn[segment.offset + i];
+        creditColumn[newOffset + i] = creditColumn[segment.offset + i];
+        dateColumn[newOffset + i] = dateColumn[segment.offset + i];
+        accountColumn[segment.offset + i] = 0;
+    }
+    segment.offset = newOffset;
+    segment.capacity = newCapacity;
+}
+
+// Appends a posting to a slot's segment
+void PostingStore::append(int slot, int transactionID, double amount, char debitOrCredit, int date) {
+    reserveOne(slot);
+    Segment &segment = segments[slot];
+    size_t position = segment.offset + segment.size++;
+    accountColumn[position] = segment.accountNumber;
+    idColumn[position] = transactionID;
+    amountColumn[position] = amount;
+    creditColumn[position] = (debitOrCredit == 'C');
+    dateColumn[position] = date;
+}
+
+// Removes the posting at an index of a slot's segment, keeping order
+void PostingStore::erase(int slot, size_t index) {
+    Segment &segment = segments[slot];
+    size_t first = segment.offset + index, last = segment.offset + segment.size;
+    copy(idColumn.begin() + first + 1, idColumn.begin() + last, idColumn.begin() + first);
+    copy(amountColumn.begin() + first + 1, amountColumn.begin() + last, amountColumn.begin() + first);
+    copy(creditColumn.begin() + first + 1, creditColumn.begin() + last, creditColumn.begin() + first);
+    copy(dateColumn.begin() + first + 1, dateColumn.begin() + last, dateColumn.begin() + first);
+    accountColumn[last - 1] = 0;
+    --segment.size;
+}
+
+// Reassigns sequential IDs 1..n within a slot
+void PostingStore::renumber(int slot) {
+    const Segment &segment = segments[slot];
+    for (size_t i = 0; i < segment.size; ++i) {
+        idColumn[segment.offset + i] = static_cast<int>(i) + 1;
+    }
+}
+
+// Returns a view over a slot's postings
+PostingView PostingStore::view(int slot) const {
+    const Segment &segment = segments[slot];
+    return PostingView(this, segment.offset, segment.size);
+}
+
+// Returns the number of postings in a slot
+size_t PostingStore::size(int slot) const {
+    return segments[slot].size;
+}
+
+// Packs the live segments in memory order and releases the slack
+void PostingStore::compact() {
+    while (!segments.empty() && segments.back().accountNumber == 0) {
+        segments.pop_back();
+    }
+    freeSlots.erase(remove_if(freeSlots.begin(), freeSlots.end(),
+                              [this](int slot) { return static_cast<size_t>(slot) >= segments.size(); }),
+                    freeSlots.end());
+
+    vector<int> order;
+    for (size_t slot = 0; slot < segments.size(); ++slot) {
+        if (segments[slot].accountNumber != 0) order.push_back(static_cast<int>(slot));
+    }
+    sort(order.begin(), order.end(), [this](int a, int b) { return segments[a].offset < segments[b].offset; });
+
+    size_t live = postingCount();
+    vector<int> accounts, ids, dates;
+    vector<double> amounts;
+    vector<unsigned char> credits;
+    accounts.reserve(live);
+    ids.reserve(live);
+    amounts.reserve(live);
+    credits.reserve(live);
+    dates.reserve(live);
+    for (int slot: order) {
+        Segment &segment = segments[slot];
+        auto first = static_cast<ptrdiff_t>(segment.offset), last = first + static_cast<ptrdiff_t>(segment.size);
+        size_t offset = accounts.size();
+        accounts.insert(accounts.end(), accountColumn.begin() + first, accountColumn.begin() + last);
+        ids.insert(ids.end(), idColumn.begin() + first, idColumn.begin() + last);
+        amounts.insert(amounts.end(), amountColumn.begin() + first, amountColumn.begin() + last);
+        credits.insert(credits.end(), creditColumn.begin() + first, creditColumn.begin() + last);
+        dates.insert(dates.end(), dateColumn.begin() + first, dateColumn.begin() + last);
+        segment.offset = offset;
+        segment.capacity = segment.size;
+    }
+    accountColumn.swap(accounts);
+    idColumn.swap(ids);
+    amountColumn.swap(amounts);
+    creditColumn.swap(credits);
+    dateColumn.swap(dates);
+    segments.shrink_to_fit();
+    freeSlots.shrink_to_fit();
+}
+
+// Returns the number of postings stored
+size_t PostingStore::postingCount() const {
+    size_t count = 0;
+    for (const Segment &segment: segments) {
+        count += segment.size;
+    }
+    return count;
+}
+
+// Returns the bytes of the live postings (every column) and of the live slots
+size_t PostingStore::bytesUsed() const {
+    size_t perPosting = 3 * sizeof(int) + sizeof(double) + sizeof(unsigned char);
+    size_t liveSlots = segments.size() - freeSlots.size();
+    return postingCount() * perPosting + liveSlots * sizeof(Segment);
+}
+
+// Returns the bytes of the columns and slot tables as allocated
+size_t PostingStore::bytesReserved() const {
+    return MemoryUsage::vectorBytes(accountColumn) + MemoryUsage::vectorBytes(idColumn) +
+           MemoryUsage::vectorBytes(amountColumn) + MemoryUsage::vectorBytes(creditColumn) +
+           MemoryUsage::vectorBytes(dateColumn) + MemoryUsage::vectorBytes(segments) +
+           MemoryUsage::vectorBytes(freeSlots);
+}
+
+const vector<int> &PostingStore::getAccountColumn() const {
+    return accountColumn;
+}
+
+const vector<int> &PostingStore::getIdColumn() const {
+    return idColumn;
+}
+
+const vector<double> &PostingStore::getAmountColumn() const {
+    return amountColumn;
+}
+
+const vector<unsigned char> &PostingStore::getCreditColumn() const {
+    return creditColumn;
+}
+
+const vector<int> &PostingStore::getDateColumn() const {
+    return dateColumn;
+}
@@ -0,0 +1,323 @@
+#ifndef POSTINGSTORE_H
+#define POSTINGSTORE_H
+
+/**-- PostingStore.h --------------------------------------------------------
+  This header file defines the PostingStore class, a ledger-wide columnar
+  store for postings, together with the PostingView and PostingRef classes
+  through which an Account exposes its postings.
+
+  Postings are kept in parallel columns (account, ID, amount, credit flag,
+  date). Each account owns a slot that maps to one contiguous segment of the
+  columns, so per-account access is a sequential run and whole-ledger scans
+  walk the segments in memory order. A full segment grows in place when it
+  ends the columns, and is otherwise relocated to the end; the abandoned
+  range becomes slack that compact() reclaims.
+
+  Basic operations:
+    Constructor:      Constructs an empty store.
+    clear:            Removes every slot and posting.
+    allocateSlot:     Reserves a slot (empty segment) for an account.
+    releaseSlot:      Frees a slot and its postings.
+    append:           Appends a posting to a slot's segment.
+    erase:            Removes the posting at an index of a slot's segment.
+    eraseIf:          Removes every posting of a slot that matches a predicate,
+                      in one compaction pass.
+    renumber:         Reassigns sequential IDs (1..n) within a slot.
+    reserve:          Reserves room for a number of postings in a slot.
+    reserveMore:      Reserves room for a number of further postings, growing
+                      geometrically.
+    view:             Returns a PostingView over a slot's postings.
+    forEachSegment:   Visits live segments in memory order.
+    compact:          Packs the live segments and releases slack and free slots.
+    postingCount:     Number of postings stored.
+    bytesUsed / bytesReserved: Bytes of live postings and segments, and of
+                      the columns and tables as allocated.
+    Column getters:   Provide read-only access to the ledger-wide columns.
+
+  Class Invariant:
+    1. A live slot's postings occupy [offset, offset + size) of every column.
+    2. Column positions not covered by a live segment have account number 0.
+--------------------------------------------------------------------------**/
+
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include "Transaction.h"
+
+using namespace std;
+
+class PostingStore;
+
+/*----------------------------------------------------------------------------
+  PostingRef is a lightweight handle to one posting in a PostingStore. It
+  offers the same getters as Transaction, and operator-> so existing code
+  written against Transaction pointers keeps working unchanged.
+----------------------------------------------------------------------------*/
+class PostingRef {
+private:
+    const PostingStore *store;   // Store holding the posting
+    size_t position;             // Absolute column position
+
+public:
+    PostingRef(const PostingStore *store, size_t position);
+
+    int getTransactionID() const;
+
+    double getAmount() const;
+
+    char getDebitOrCredit() const;
+
+    int getDate() const;
+
+    Transaction toTransaction() const;
+
+    const PostingRef *operator->() const { return this; }
+};
+
+/*----------------------------------------------------------------------------
+  PostingView is a read-only, non-owning range over one account's postings.
+  It iterates as PostingRef values and exposes the raw columns for kernels.
+----------------------------------------------------------------------------*/
+class PostingView {
+private:
+    const PostingStore *store;   // Store holding the postings
+    size_t offset;               // First column position
+    size_t count;                // Number of postings
+
+public:
+    class Iterator {
+    private:
+        const PostingStore *store;
+        size_t position;
+
+    public:
+        Iterator(const PostingStore *store, size_t position) : store(store), position(position) {}
+
+        PostingRef operator*() const { return PostingRef(store, position); }
+
+        Iterator &operator++() { ++position; return *this; }
+
+        bool operator!=(const Iterator &other) const { return position != other.position; }
+
+        bool operator==(const Iterator &other) const { return position == other.position; }
+    };
+
+    PostingView(const PostingStore *store, size_t offset, size_t count);
+
+    size_t size() const { return count; }
+
+    bool empty() const { return count == 0; }
+
+    PostingRef operator[](size_t index) const { return PostingRef(store, offset + index); }
+
+    Iterator begin() const { return Iterator(store, offset); }
+
+    Iterator end() const { return Iterator(store, offset + count); }
+
+    /*------------------------------------------------------------------------
+      Raw column pointers for this view (valid until the store is modified).
+    -----------------------------------------------------------------------*/
+    const int *ids() const;
+
+    const double *amounts() const;
+
+    const unsigned char *credits() const;
+
+    const int *dates() const;
+};
+
+class PostingStore {
+private:
+    struct Segment {
+        size_t offset;       // First column position
+        size_t size;         // Number of postings
+        size_t capacity;     // Reserved column positions
+        int accountNumber;   // Owning account (0 if the slot is free)
+    };
+
+    vector<int> accountColumn;              // Account number per position (0 for slack)
+    vector<int> idColumn;                   // Transaction ID per position
+    vector<double> amountColumn;            // Amount per position
+    vector<unsigned char> creditColumn;     // 1 for Credit, 0 for Debit
+    vector<int> dateColumn;                 // Posting date (YYYYMMDD, 0 if undated)
+    vector<Segment> segments;               // Segment per slot
+    vector<int> freeSlots;                  // Released slots available for reuse
+
+    /***** Helper Function *****/
+    /*------------------------------------------------------------------------
+      Makes room for at least one more posting in a slot's segment, growing
+      it in place or relocating it to the end of the columns.
+
+      Precondition:  A live slot is provided.
+      Post-condition: The segment's capacity exceeds its size.
+    -----------------------------------------------------------------------*/
+    void reserveOne(int slot);
+
+    /*------------------------------------------------------------------------
+      Grows a slot's segment to a new capacity, in place when it ends the
+      columns (or is empty), otherwise by relocating it to the end.
+
+      Precondition:  A live slot and newCapacity > its capacity are provided.
+      Post-condition: The segment's capacity is newCapacity; postings are kept.
+    -----------------------------------------------------------------------*/
+    void grow(int slot, size_t newCapacity);
+
+public:
+    /***** Constructor *****/
+    PostingStore();
+
+    /***** Clear *****/
+    /*------------------------------------------------------------------------
+      Removes every slot and posting.
+
+      Precondition:  No account still refers to a slot of this store.
+      Post-condition: The store is empty.
+    -----------------------------------------------------------------------*/
+    void clear();
+
+    /***** Slot Management *****/
+    /*------------------------------------------------------------------------
+      Reserves an empty slot for an account, or frees a slot and its postings.
+
+      Precondition:  A valid account number / live slot is provided.
+      Post-condition: allocateSlot returns the slot number.
+    -----------------------------------------------------------------------*/
+    int allocateSlot(int accountNumber);
+
+    void releaseSlot(int slot);
+
+    /***** Posting Management *****/
+    /*------------------------------------------------------------------------
+      Appends a posting to a slot, removes the posting at an index of a slot,
+      or reassigns sequential IDs 1..n within a slot.
+
+      Precondition:  A live slot (and a valid index for erase) is provided.
+      Post-condition: The slot's segment is updated; other slots are unchanged.
+    -----------------------------------------------------------------------*/
+    void append(int slot, int transactionID, double amount, char debitOrCredit, int date);
+
+    void erase(int slot, size_t index);
+
+    void renumber(int slot);
+
+    /*------------------------------------------------------------------------
+      Removes every posting of a slot for which remove(PostingRef) returns
+      true, shifting the kept postings down in one pass (order is kept).
+      remove is called once per posting, in order, before anything moves
+      past it, so it may record what it removes.
+
+      Precondition:  A live slot is provided.
+      Post-condition: Returns the number of postings removed; IDs are not
+                      renumbered.
+    -----------------------------------------------------------------------*/
+    template<typename Predicate>
+    size_t eraseIf(int slot, Predicate remove) {
+        Segment &segment = segments[slot];
+        size_t first = segment.offset, last = first + segment.size, write = first;
+        for (size_t read = first; read < last; ++read) {
+            if (remove(PostingRef(this, read))) continue;
+            if (write != read) {
+                idColumn[write] = idColumn[read];
+                amountColumn[write] = amountColumn[read];
+                creditColumn[write] = creditColumn[read];
+                dateColumn[write] = dateColumn[read];
+            }
+            ++write;
+        }
+        fill(accountColumn.begin() + static_cast<ptrdiff_t>(write), accountColumn.begin() + static_cast<ptrdiff_t>(last), 0);
+        segment.size = write - first;
+        return last - write;
+    }
+
+    /*------------------------------------------------------------------------
+      Reserves room for `capacity` postings in a slot, so appends up to that
+      size neither grow nor relocate its segment.
+
+      Precondition:  A live slot is provided.
+      Post-condition: The slot's capacity is at least `capacity`.
+    -----------------------------------------------------------------------*/
+    void reserve(int slot, size_t capacity);
+
+    /*------------------------------------------------------------------------
+      Reserves room for `count` postings beyond a slot's current size. The
+      segment at least doubles when it grows, so repeated calls stay
+      amortized O(1) per posting.
+
+      Precondition:  A live slot is provided.
+      Post-condition: The next `count` appends to the slot allocate nothing.
+    -----------------------------------------------------------------------*/
+    void reserveMore(int slot, size_t count);
+
+    /***** Access *****/
+    /*------------------------------------------------------------------------
+      Returns a view over a slot's postings, and the number of postings.
+
+      Precondition:  A live slot is provided.
+      Post-condition: The view is valid until the store is modified.
+    -----------------------------------------------------------------------*/
+    PostingView view(int slot) const;
+
+    size_t size(int slot) const;
+
+    /*------------------------------------------------------------------------
+      Visits every live, non-empty segment in memory order, calling
+      visit(accountNumber, view). Consecutive calls touch consecutive column
+      ranges, so a whole-ledger scan streams through memory.
+
+      Precondition:  None.
+      Post-condition: visit has been called once per non-empty segment.
+    -----------------------------------------------------------------------*/
+    template<typename Visitor>
+    void forEachSegment(Visitor visit) const {
+        vector<int> order;
+        for (size_t slot = 0; slot < segments.size(); ++slot) {
+            if (segments[slot].accountNumber != 0 && segments[slot].size > 0) {
+                order.push_back(static_cast<int>(slot));
+            }
+        }
+        sort(order.begin(), order.end(), [this](int a, int b) {
+            return segments[a].offset < segments[b].offset;
+        });
+        for (int slot: order) {
+            visit(segments[slot].accountNumber, view(slot));
+        }
+    }
+
+    /***** Compaction *****/
+    /*------------------------------------------------------------------------
+      Rewrites the columns with the live segments packed in memory order,
+      each with no spare capacity, drops the free slots at the end of the
+      slot table, and returns the freed memory to the allocator. The next
+      posting to an account relocates its segment once, growing it
+      geometrically again.
+
+      Precondition:  None.
+      Post-condition: Every column position belongs to a live posting; slots
+                      and postings are unchanged; views are invalidated.
+    -----------------------------------------------------------------------*/
+    void compact();
+
+    /***** Statistics *****/
+    size_t postingCount() const;
+
+    size_t bytesUsed() const;
+
+    size_t bytesReserved() const;
+
+    /***** Ledger-Wide Columns *****/
+    /*------------------------------------------------------------------------
+      Read-only access to the whole columns. Positions whose account number
+      is 0 are slack and must be skipped.
+    -----------------------------------------------------------------------*/
+    const vector<int> &getAccountColumn() const;
+
+    const vector<int> &getIdColumn() const;
+
+    const vector<double> &getAmountColumn() const;
+
+    const vector<unsigned char> &getCreditColumn() const;
+
+    const vector<int> &getDateColumn() const;
+};
+
+#endif // POSTINGSTORE_H
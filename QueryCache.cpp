@@ -0,0 +1,118 @@
+#include "QueryCache.h"
+#include "MemoryUsage.h"
+
+using namespace std;
+
+// Hashes a (account, metric, period) key
+size_t QueryCache::KeyHash::operator()(const Key &key) const {
+    uint64_t h = static_cast<uint32_t>(key.accountNumber);
+    h = h * 0x9E3779B97F4A7C15ULL + static_cast<uint32_t>(key.metric);
+    h = h * 0x9E3779B97F4A7C15ULL + static_cast<uint32_t>(key.fromDate);
+    h = h * 0x9E3779B97F4A7C15ULL + static_cast<uint32_t>(key.toDate);
+    return static_cast<size_t>(h ^ (h >> 29));
+}
+
+// Constructor for an empty cache
+QueryCache::QueryCache(size_t capacity) : capacity(capacity == 0 ? 1 : capacity) {}
+
+// Returns the current version of a slot (0 until first bumped)
+uint64_t QueryCache::versionOf(int slot) const {
+    return (static_cast<size_t>(slot) < versions.size()) ? versions[slot] : 0;
+}
+
+// Looks up a current result
+bool QueryCache::lookup(int accountNumber, int slot, Metric metric, int fromDate, int toDate, double &value) {
+    lock_guard<mutex> guard(lock);
+    auto it = entries.find(Key{accountNumber, metric, fromDate, toDate});
+    if (it != entries.end() && it->second.slot == slot && it->second.version == versionOf(slot)) {
+        value = it->second.value;
+        ++stats.hits;
+        return true;
+    }
+    ++stats.misses;
+    return false;
+}
+
+// Caches a result at the slot's current version
+void QueryCache::store(int accountNumber, int slot, Metric metric, int fromDate, int toDate, double value) {
+    lock_guard<mutex> guard(lock);
+    Key key{accountNumber, metric, fromDate, toDate};
+    if (entries.size() >= capacity && entries.find(key) == entries.end()) {
+        evict();
+    }
+    entries[key] = Entry{value, slot, versionOf(slot)};
+}
+
+// Drops stale results; drops everything if all of them are current
+void QueryCache::evict() {
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.version != versionOf(it->second.slot)) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (entries.size() >= capacity) {
+        entries.clear();
+    }
+}
+
+// Bumps the version of a slot
+void QueryCache::invalidate(int slot) {
+    if (static_cast<size_t>(slot) >= versions.size()) {
+        versions.resize(static_cast<size_t>(slot) + 1, 0);
+    }
+    versions[slot] = ++clock;
+    ++stats.invalidations;
+}
+
+// Drops every result and version
+void QueryCache::clear() {
+    lock_guard<mutex> guard(lock);
+    entries.clear();
+    versions.clear();
+}
+
+// Drops the stale results and shrinks the result table
+void QueryCache::compact() {
+    lock_guard<mutex> guard(lock);
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.version != versionOf(it->second.slot)) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    entries.rehash(0);
+}
+
+// Returns the bytes of the result table and of the slot versions
+size_t QueryCache::memoryBytes() const {
+    lock_guard<mutex> guard(lock);
+    return MemoryUsage::hashBytes(entries) + MemoryUsage::vectorBytes(versions);
+}
+
+// Returns the cache statistics
+QueryCache::Stats QueryCache::getStats() const {
+    lock_guard<mutex> guard(lock);
+    Stats current = stats;
+    current.entries = entries.size();
+    return current;
+}
+
+// Returns the display name of a metric
+const char *QueryCache::metricName(Metric metric) {
+    static const char *const names[] = {"balance", "debits", "credits", "turnover", "postings"};
+    return names[metric];
+}
+
+// Parses a metric name
+bool QueryCache::parseMetric(string_view name, Metric &metric) {
+    for (int i = 0; i < METRIC_COUNT; ++i) {
+        if (name == metricName(static_cast<Metric>(i))) {
+            metric = static_cast<Metric>(i);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,151 @@
+#ifndef QUERYCACHE_H
+#define QUERYCACHE_H
+
+/**-- QueryCache.h ----------------------------------------------------------
+  This header file defines the QueryCache class, a read-through cache of
+  subtree aggregate results keyed by (account, metric, period).
+
+  Results are versioned rather than erased. Every account slot carries a
+  version, and a cached result remembers the version of its account at the
+  time it was computed; it is served only while the two are equal. When a
+  posting changes, the ForestTree bumps the version of the posted account and
+  of every ancestor, which are exactly the subtrees whose aggregates moved.
+  Results for unrelated accounts stay valid, and invalidation costs O(depth)
+  whatever the number of cached results.
+
+  Versions come from one ledger-wide counter, so an account that reuses the
+  slot (or the number) of a removed account never matches its stale results.
+
+  Lookups and stores are serialized by an internal mutex, so concurrent
+  readers of the tree (e.g. the ledger server's shared lock) may use the
+  cache. Versions are only bumped by writers of the tree.
+
+  Basic operations:
+    Constructor:   Constructs an empty cache holding up to a number of results.
+    lookup:        Returns a cached result if it is still current.
+    store:         Caches a result at the account's current version.
+    invalidate:    Bumps the version of one account slot.
+    clear:         Drops every result and version.
+    compact:       Drops the stale results.
+    memoryBytes:   Returns the memory held by results and versions.
+    getStats:      Hits, misses, invalidations and cached results.
+    metricName / parseMetric: Names of the metrics.
+
+  Helper functions:
+    versionOf:     Current version of a slot.
+    evict:         Drops stale results, or everything, when the cache is full.
+
+  Class Invariant:
+    1. A result is current iff its version equals the version of its slot.
+    2. entries.size() <= capacity.
+--------------------------------------------------------------------------**/
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+class QueryCache {
+public:
+    enum Metric { BALANCE, DEBITS, CREDITS, TURNOVER, POSTING_COUNT, METRIC_COUNT };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t invalidations = 0;     // Slot versions bumped
+        size_t entries = 0;             // Results cached (current or stale)
+    };
+
+private:
+    struct Key {
+        int accountNumber;
+        int metric;
+        int fromDate;
+        int toDate;
+
+        bool operator==(const Key &other) const {
+            return accountNumber == other.accountNumber && metric == other.metric &&
+                   fromDate == other.fromDate && toDate == other.toDate;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &key) const;
+    };
+
+    struct Entry {
+        double value;
+        int slot;                       // Slot whose version the result depends on
+        uint64_t version;
+    };
+
+    size_t capacity;
+    uint64_t clock = 0;                 // Last version handed out
+    vector<uint64_t> versions;          // Version per posting-store slot
+    unordered_map<Key, Entry, KeyHash> entries;
+    mutable mutex lock;                 // Guards entries and the statistics
+    Stats stats;
+
+    uint64_t versionOf(int slot) const;
+
+    void evict();
+
+public:
+    /***** Constructor *****/
+    explicit QueryCache(size_t capacity = 65536);
+
+    /***** Lookup / Store *****/
+    /*------------------------------------------------------------------------
+      Looks up the result of a metric over a period (dates 0 for all time)
+      for the account in the given slot.
+
+      Precondition:  slot is the account's posting-store slot.
+      Post-condition: Returns true and sets `value` if a current result is
+                      cached; counts a hit or a miss.
+    -----------------------------------------------------------------------*/
+    bool lookup(int accountNumber, int slot, Metric metric, int fromDate, int toDate, double &value);
+
+    /*------------------------------------------------------------------------
+      Caches a result computed at the account's current version.
+
+      Precondition:  The tree has not changed since the result was computed.
+      Post-condition: The result is served by lookup until the slot's
+                      version is bumped.
+    -----------------------------------------------------------------------*/
+    void store(int accountNumber, int slot, Metric metric, int fromDate, int toDate, double value);
+
+    /***** Invalidation *****/
+    /*------------------------------------------------------------------------
+      Bumps the version of a slot, making every result of its account stale.
+
+      Precondition:  Called by a writer of the tree (no concurrent lookups).
+      Post-condition: The slot has a version no result was computed at.
+    -----------------------------------------------------------------------*/
+    void invalidate(int slot);
+
+    void clear();
+
+    /*------------------------------------------------------------------------
+      Drops every stale result (one whose slot was invalidated since) and
+      shrinks the result table to the current ones.
+
+      Precondition:  Called by a writer of the tree.
+      Post-condition: Only current results are cached.
+    -----------------------------------------------------------------------*/
+    void compact();
+
+    /***** Statistics *****/
+    Stats getStats() const;
+
+    size_t memoryBytes() const;
+
+    static const char *metricName(Metric metric);
+
+    static bool parseMetric(string_view name, Metric &metric);
+};
+
+#endif // QUERYCACHE_H
@@ -0,0 +1,124 @@
+#include "RenderCache.h"
+#include "MemoryUsage.h"
+#include <cstdio>
+
+using namespace std;
+
+// Returns the entry of a slot, growing the table as needed
+RenderCache::Entry &RenderCache::entryOf(int slot) {
+    if (static_cast<size_t>(slot) >= entries.size()) {
+        entries.resize(static_cast<size_t>(slot) + 1);
+    }
+    return entries[slot];
+}
+
+// Formats an account line: indent, number, description padded to 30, balance
+void RenderCache::renderHeader(string &out, const Account *account, int indent) {
+    out.assign(static_cast<size_t>(indent) * 2, ' ');
+    out += to_string(account->getAccountNumber());
+    out += ' ';
+    string_view description = account->getDescription();
+    out.append(description.data(), description.size());
+    if (description.size() < 30) {
+        out.append(30 - description.size(), ' ');
+    }
+    char balance[64];
+    snprintf(balance, sizeof(balance), " %.2f\n", account->getBalance());
+    out += balance;
+}
+
+// Formats one transaction line, indented one level deeper than its account
+void RenderCache::appendPosting(string &out, const PostingRef &posting, int indent) {
+    out.append(static_cast<size_t>(indent + 1) * 2, ' ');
+    char line[96];
+    snprintf(line, sizeof(line), "Transaction ID: %d, Amount: %.2f, Type: %s", posting.getTransactionID(),
+             posting.getAmount(), posting.getDebitOrCredit() == 'D' ? "Debit" : "Credit");
+    out += line;
+    if (posting.getDate() != 0) {
+        out += ", Date: ";
+        out += Transaction::formatDate(posting.getDate());
+    }
+    out += '\n';
+}
+
+// Writes an account's block, re-rendering only its dirty parts
+void RenderCache::write(const Account *account, int indent, ostream &out) {
+    Entry &entry = entryOf(account->getSlot());
+    bool moved = (entry.indent != indent);
+
+    if (entry.headerDirty || moved) {
+        renderHeader(entry.header, account, indent);
+        entry.headerDirty = false;
+    }
+
+    PostingView postings = account->getTransactions();
+    if (entry.bodyDirty || moved || postings.size() < entry.renderedPostings) {
+        entry.body.clear();
+        entry.renderedPostings = 0;
+        entry.bodyDirty = false;
+    }
+    for (size_t i = entry.renderedPostings; i < postings.size(); ++i) {
+        appendPosting(entry.body, postings[i], indent);
+    }
+    entry.renderedPostings = postings.size();
+    entry.indent = indent;
+
+    out.write(entry.header.data(), static_cast<streamsize>(entry.header.size()));
+    if (!postings.empty()) {
+        out.write(entry.body.data(), static_cast<streamsize>(entry.body.size()));
+        out.put('\n'); // Blank line after an account's transactions
+    }
+}
+
+// Marks an account's header (balance line) dirty
+void RenderCache::invalidateHeader(int slot) {
+    if (static_cast<size_t>(slot) < entries.size()) {
+        entries[slot].headerDirty = true;
+    }
+}
+
+// Marks an account's posting lines dirty
+void RenderCache::invalidateBody(int slot) {
+    if (static_cast<size_t>(slot) < entries.size()) {
+        entries[slot].bodyDirty = true;
+    }
+}
+
+// Drops the cache of a slot
+void RenderCache::erase(int slot) {
+    if (static_cast<size_t>(slot) < entries.size()) {
+        entries[slot] = Entry();
+    }
+}
+
+// Drops every cached block
+void RenderCache::clear() {
+    entries.clear();
+}
+
+// Drops trailing empty entries and releases spare capacity
+void RenderCache::compact() {
+    while (!entries.empty() && entries.back().indent < 0 && entries.back().header.empty() &&
+           entries.back().body.empty()) {
+        entries.pop_back();
+    }
+    entries.shrink_to_fit();
+}
+
+// Returns the bytes of cached text
+size_t RenderCache::bytesCached() const {
+    size_t bytes = 0;
+    for (const Entry &entry: entries) {
+        bytes += entry.header.capacity() + entry.body.capacity();
+    }
+    return bytes;
+}
+
+// Returns the bytes of cached text and of the entry table
+size_t RenderCache::memoryBytes() const {
+    size_t bytes = MemoryUsage::vectorBytes(entries);
+    for (const Entry &entry: entries) {
+        bytes += MemoryUsage::stringBytes(entry.header) + MemoryUsage::stringBytes(entry.body);
+    }
+    return bytes;
+}
@@ -0,0 +1,98 @@
+#ifndef RENDERCACHE_H
+#define RENDERCACHE_H
+
+/**-- RenderCache.h ---------------------------------------------------------
+  This header file defines the RenderCache class, which keeps the printTree
+  text of every account so that re-exporting the chart only re-renders what
+  changed since the previous export.
+
+  Each account's block is cached in two parts, indexed by the account's
+  posting-store slot:
+    header   "<indent><number> <description padded to 30> <balance>"
+    body     One "Transaction ID: ..." line per posting.
+
+  The ForestTree marks a header dirty when the account's balance changes
+  (a posting anywhere in its subtree), and a body dirty when existing postings
+  change (a removal renumbers them). Appended postings need no mark: the body
+  renders only the postings added since it was last rendered. A block is also
+  re-rendered when the account's depth (indent) changed, e.g. after its parent
+  was removed.
+
+  Basic operations:
+    write:             Writes an account's block, re-rendering only dirty parts.
+    invalidateHeader:  Marks an account's header dirty.
+    invalidateBody:    Marks an account's posting lines dirty.
+    erase:             Drops the cache of a slot (account removed).
+    clear:             Drops every cached block.
+    bytesCached:       Bytes of cached text.
+    compact:           Releases the entries of slots past the last cached block.
+    memoryBytes:       Bytes of cached text and of the entry table.
+
+  Helper functions:
+    renderHeader:      Formats an account line.
+    appendPosting:     Formats one transaction line.
+--------------------------------------------------------------------------**/
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Account.h"
+
+using namespace std;
+
+class RenderCache {
+private:
+    struct Entry {
+        string header;
+        string body;
+        int indent = -1;                 // Indent the block was rendered at
+        size_t renderedPostings = 0;     // Postings already in `body`
+        bool headerDirty = true;
+        bool bodyDirty = true;
+    };
+
+    vector<Entry> entries;               // Indexed by posting-store slot
+
+    Entry &entryOf(int slot);
+
+    static void renderHeader(string &out, const Account *account, int indent);
+
+    static void appendPosting(string &out, const PostingRef &posting, int indent);
+
+public:
+    /***** Write *****/
+    /*------------------------------------------------------------------------
+      Writes an account's block (header, postings, and a blank line if it has
+      postings) at the given indent, in the printTree layout.
+
+      Precondition:  The account belongs to the tree that owns this cache.
+      Post-condition: The block is written; its cache is up to date.
+    -----------------------------------------------------------------------*/
+    void write(const Account *account, int indent, ostream &out);
+
+    /***** Invalidation *****/
+    void invalidateHeader(int slot);
+
+    void invalidateBody(int slot);
+
+    void erase(int slot);
+
+    void clear();
+
+    /*------------------------------------------------------------------------
+      Drops the empty entries at the end of the table (slots of removed
+      accounts) and releases the table's spare capacity.
+
+      Precondition:  None.
+      Post-condition: Every cached block is kept.
+    -----------------------------------------------------------------------*/
+    void compact();
+
+    /***** Statistics *****/
+    size_t bytesCached() const;
+
+    size_t memoryBytes() const;
+};
+
+#endif // RENDERCACHE_H
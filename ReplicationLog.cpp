@@ -0,0 +1,158 @@
+#include "ReplicationLog.h"
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+using namespace std;
+
+// Constructor creating an empty log; a primary draws a non-zero epoch
+ReplicationLog::ReplicationLog(Role role, uint64_t baseHash, size_t maxEntries)
+        : role(role), epoch(0), baseHash(baseHash), maxEntries(maxEntries) {
+    if (role == PRIMARY) {
+        random_device device;
+        mt19937_64 generator((static_cast<uint64_t>(device()) << 32) ^ device() ^
+                             static_cast<uint64_t>(nowMicros()));
+        while (epoch == 0) epoch = generator();
+    }
+}
+
+// Stores an entry at the head, dropping the oldest beyond maxEntries
+void ReplicationLog::store(Entry entry) {
+    head = entry.position;
+    entries.push_back(move(entry));
+    if (maxEntries > 0 && entries.size() > maxEntries) {
+        entries.pop_front();
+        ++firstRetained;
+    }
+}
+
+// Appends a command applied on the primary at the next position
+uint64_t ReplicationLog::append(string_view command) {
+    uint64_t position;
+    {
+        lock_guard<mutex> guard(lock);
+        position = head + 1;
+        store({position, nowMicros(), string(command)});
+    }
+    appended.notify_all();
+    return position;
+}
+
+// Stores an entry of the primary applied on the replica
+void ReplicationLog::mirror(const Entry &entry) {
+    {
+        lock_guard<mutex> guard(lock);
+        if (entry.position != head + 1) {
+            throw runtime_error("Log entry " + to_string(entry.position) + " does not follow position " +
+                                to_string(head) + ".");
+        }
+        int64_t delay = nowMicros() - entry.appendedMicros;
+        lastDelayMicros = delay;
+        maxDelayMicros = max(maxDelayMicros, delay);
+        upstreamPosition = max(upstreamPosition, entry.position);
+        lastContactMicros = nowMicros();
+        store(entry);
+    }
+    appended.notify_all();
+}
+
+// Checks a primary's epoch and start hash, taking the epoch if nothing was applied yet
+void ReplicationLog::adopt(uint64_t primaryEpoch, uint64_t primaryBaseHash) {
+    lock_guard<mutex> guard(lock);
+    if (primaryBaseHash != baseHash) {
+        throw runtime_error("The primary started from a different chart; load the same --input.");
+    }
+    if (epoch != 0 && epoch != primaryEpoch) {
+        throw runtime_error("The primary restarted with a new log after position " + to_string(head) +
+                            " was applied; restart the replica.");
+    }
+    epoch = primaryEpoch;
+}
+
+// Copies up to `limit` entries after a position, waiting up to `wait` for one
+bool ReplicationLog::read(uint64_t after, size_t limit, vector<Entry> &out, chrono::milliseconds wait) const {
+    out.clear();
+    unique_lock<mutex> guard(lock);
+    if (after + 1 < firstRetained || after > head) {
+        return false;
+    }
+    appended.wait_for(guard, wait, [&] { return head > after || after + 1 < firstRetained; });
+    if (after + 1 < firstRetained) {
+        return false;   // Dropped while waiting
+    }
+    size_t first = static_cast<size_t>(after + 1 - firstRetained);
+    size_t last = min(entries.size(), first + limit);
+    for (size_t i = first; i < last; ++i) {
+        out.push_back(entries[i]);
+    }
+    return true;
+}
+
+// Returns the position of the last entry
+uint64_t ReplicationLog::getHead() const {
+    lock_guard<mutex> guard(lock);
+    return head;
+}
+
+// Returns the epoch (0 for a replica that has not met its primary yet)
+uint64_t ReplicationLog::getEpoch() const {
+    lock_guard<mutex> guard(lock);
+    return epoch;
+}
+
+// Returns the tree hash at position 0
+uint64_t ReplicationLog::getBaseHash() const {
+    return baseHash;
+}
+
+// Returns whether the log mirrors a primary's
+bool ReplicationLog::isFollower() const {
+    return role == REPLICA;
+}
+
+// Records the primary's head position as reported by any message
+void ReplicationLog::noteUpstream(uint64_t primaryHead) {
+    lock_guard<mutex> guard(lock);
+    upstreamPosition = max(upstreamPosition, primaryHead);
+    lastContactMicros = nowMicros();
+}
+
+// Records whether the replica is connected to its primary
+void ReplicationLog::setConnected(bool isConnected) {
+    lock_guard<mutex> guard(lock);
+    if (isConnected && !connected) {
+        ++connections;
+        error.clear();
+    }
+    connected = isConnected;
+}
+
+// Records why the replica stopped following
+void ReplicationLog::fail(const string &reason) {
+    lock_guard<mutex> guard(lock);
+    connected = false;
+    error = reason;
+}
+
+// Returns the position, retention and lag figures
+ReplicationLog::Status ReplicationLog::getStatus() const {
+    lock_guard<mutex> guard(lock);
+    Status status;
+    status.role = role;
+    status.epoch = epoch;
+    status.position = head;
+    status.firstRetained = firstRetained;
+    status.connected = connected;
+    status.upstreamPosition = max(upstreamPosition, head);
+    status.lastDelayMicros = lastDelayMicros;
+    status.maxDelayMicros = maxDelayMicros;
+    status.sinceContactMicros = (lastContactMicros < 0) ? -1 : nowMicros() - lastContactMicros;
+    status.reconnects = (connections > 0) ? connections - 1 : 0;
+    status.error = error;
+    return status;
+}
+
+// Returns the current steady-clock time in microseconds
+int64_t ReplicationLog::nowMicros() {
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
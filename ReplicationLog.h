@@ -0,0 +1,191 @@
+#ifndef REPLICATIONLOG_H
+#define REPLICATIONLOG_H
+
+/**-- ReplicationLog.h ------------------------------------------------------
+  This header file defines the ReplicationLog class, the operation log of a
+  ledger process taking part in log shipping (LogShipper, LogFollower).
+
+  On a primary, every command that changes the tree (BatchRunner::isMutation)
+  is appended once it has succeeded, under the server's exclusive lock, so
+  log order is apply order. Positions count from 1; position 0 is the tree
+  the process started with. Commands are stored as their BatchRunner text,
+  which replays deterministically on any tree in the same state.
+
+  On a replica the log mirrors the primary's: each entry is applied and then
+  stored at the primary's position, and the replica records what it knows of
+  the primary (its head position, the delay of the last entry applied, the
+  time since the last message) so lag can be measured.
+
+  A log is identified by an epoch drawn when the primary starts and by the
+  hash of its starting tree (ForestTree::getTreeHash): a replica resumes by
+  position only from the same epoch, and starts only from the same tree.
+
+  Timestamps are microseconds of the steady clock, which on Linux is shared
+  by every process of the machine; delays between processes on different
+  hosts are not meaningful.
+
+  Basic operations:
+    Constructor:     Creates the log of a primary (new epoch) or of a replica.
+    append:          Appends a command at the next position (primary).
+    mirror:          Stores an entry applied from the primary (replica).
+    adopt:           Checks or takes the primary's epoch and start hash (replica).
+    read:            Waits for and copies the entries after a position.
+    getHead / getEpoch / getBaseHash / isFollower: Identity and position.
+    noteUpstream / setConnected / fail: Replica-side view of the primary.
+    getStatus:       Position, retention and lag figures.
+    nowMicros:       Current steady-clock time in microseconds.
+
+  Class Invariant:
+    1. entries holds the positions firstRetained..head, in order (none when
+       firstRetained == head + 1).
+    2. A primary's epoch is never 0; a replica's is 0 until it adopts one.
+    3. Every member is accessed under `lock`.
+--------------------------------------------------------------------------**/
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+class ReplicationLog {
+public:
+    enum Role { PRIMARY, REPLICA };
+
+    struct Entry {
+        uint64_t position;
+        int64_t appendedMicros;         // When the primary appended it
+        string command;                 // BatchRunner command line
+    };
+
+    struct Status {
+        Role role;
+        uint64_t epoch;
+        uint64_t position;              // Last entry applied (head)
+        uint64_t firstRetained;         // Oldest entry a follower can still read
+        // Replica only
+        bool connected;                 // Following the primary now
+        uint64_t upstreamPosition;      // Primary's head, as last reported
+        int64_t lastDelayMicros;        // Append-to-apply delay of the last entry
+        int64_t maxDelayMicros;         // Largest such delay so far
+        int64_t sinceContactMicros;     // Time since the last message from the primary (-1: never)
+        uint64_t reconnects;            // Connections made after the first
+        string error;                   // Why following stopped, if it did
+    };
+
+private:
+    mutable mutex lock;
+    mutable condition_variable appended;
+    Role role;
+    uint64_t epoch;
+    uint64_t baseHash;                  // ForestTree::getTreeHash at position 0
+    size_t maxEntries;                  // Entries kept in memory (0: all)
+    deque<Entry> entries;
+    uint64_t firstRetained = 1;
+    uint64_t head = 0;
+
+    bool connected = false;
+    uint64_t upstreamPosition = 0;
+    int64_t lastDelayMicros = 0;
+    int64_t maxDelayMicros = 0;
+    int64_t lastContactMicros = -1;
+    uint64_t connections = 0;
+    string error;
+
+    void store(Entry entry);
+
+public:
+    /***** Constructor *****/
+    /*------------------------------------------------------------------------
+      Creates an empty log for a tree whose getTreeHash is baseHash. A
+      primary draws a new epoch; a replica adopts its primary's.
+
+      Precondition:  None.
+      Post-condition: The log is at position 0.
+    -----------------------------------------------------------------------*/
+    ReplicationLog(Role role, uint64_t baseHash, size_t maxEntries = 0);
+
+    ReplicationLog(const ReplicationLog &) = delete;
+
+    ReplicationLog &operator=(const ReplicationLog &) = delete;
+
+    /***** Append *****/
+    /*------------------------------------------------------------------------
+      Appends a command that has just been applied to the primary's tree.
+
+      Precondition:  The role is PRIMARY; the command holds no newline.
+      Post-condition: Returns its position; waiting readers are woken. The
+                      oldest entry is dropped beyond maxEntries.
+    -----------------------------------------------------------------------*/
+    uint64_t append(string_view command);
+
+    /*------------------------------------------------------------------------
+      Stores an entry of the primary that has just been applied to the
+      replica's tree.
+
+      Precondition:  The role is REPLICA.
+      Post-condition: The entry is the new head and the delay figures are
+                      updated; throws runtime_error if its position is not
+                      head + 1.
+    -----------------------------------------------------------------------*/
+    void mirror(const Entry &entry);
+
+    /*------------------------------------------------------------------------
+      Checks a primary's identity against the replica's: a replica that has
+      applied nothing takes the primary's epoch; the start hashes must match.
+
+      Precondition:  The role is REPLICA.
+      Post-condition: Throws runtime_error if the replica cannot follow this
+                      primary (other start tree, or a new epoch after
+                      entries were applied).
+    -----------------------------------------------------------------------*/
+    void adopt(uint64_t primaryEpoch, uint64_t primaryBaseHash);
+
+    /***** Read *****/
+    /*------------------------------------------------------------------------
+      Copies up to `limit` entries after position `after` into out (cleared
+      first), waiting up to `wait` for one to be appended.
+
+      Precondition:  None.
+      Post-condition: Returns false, copying nothing, if the entries after
+                      `after` are no longer retained or `after` is beyond
+                      the head; true otherwise (out may be empty after the
+                      wait).
+    -----------------------------------------------------------------------*/
+    bool read(uint64_t after, size_t limit, vector<Entry> &out, chrono::milliseconds wait) const;
+
+    /***** Accessors *****/
+    uint64_t getHead() const;
+
+    uint64_t getEpoch() const;
+
+    uint64_t getBaseHash() const;
+
+    bool isFollower() const;
+
+    /***** Replica Status *****/
+    /*------------------------------------------------------------------------
+      Record what a replica learns of its primary: its head position (from
+      any message), whether the connection is up, or why following stopped.
+
+      Precondition:  The role is REPLICA.
+      Post-condition: getStatus reflects the update.
+    -----------------------------------------------------------------------*/
+    void noteUpstream(uint64_t primaryHead);
+
+    void setConnected(bool isConnected);
+
+    void fail(const string &reason);
+
+    Status getStatus() const;
+
+    static int64_t nowMicros();
+};
+
+#endif // REPLICATIONLOG_H
@@ -0,0 +1,147 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+/**-- SpscQueue.h -----------------------------------------------------------
+  This header file defines the SpscQueue class template, a bounded lock-free
+  ring buffer between exactly one producer thread and one consumer thread.
+
+  push blocks while the queue is full (backpressure) and pop blocks while it
+  is empty; a blocked side spins briefly and then yields its time slice. The
+  producer closes the queue when it is done, after which pop drains the
+  remaining items and then returns false.
+
+  The producer also samples the depth at every push, so the queue reports
+  its largest and mean depth.
+
+  Basic operations:
+    Constructor:   Constructs an empty queue (capacity rounded up to a power of two).
+    push:          Appends an item, waiting while the queue is full.
+    pop:           Removes the oldest item, waiting while the queue is empty.
+    tryPop:        Removes the oldest item if there is one, without waiting.
+    close:         Marks the end of the stream.
+    size:          Current number of items.
+    capacity:      Maximum number of items.
+    maxDepth / meanDepth: Depth samples taken at every push.
+
+  Class Invariant:
+    1. 0 <= tail - head <= capacity.
+    2. Slots [head, tail) (modulo capacity) hold the queued items, oldest first.
+--------------------------------------------------------------------------**/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+template<typename T>
+class SpscQueue {
+private:
+    vector<T> slots;
+    size_t mask;
+
+    alignas(64) atomic<size_t> head{0};     // Next slot to pop (consumer)
+    alignas(64) atomic<size_t> tail{0};     // Next slot to push (producer)
+    atomic<bool> closed{false};
+
+    uint64_t pushes = 0;                    // Producer-side depth samples
+    uint64_t depthSum = 0;
+    size_t deepest = 0;
+
+    // Spins, then yields, between polls of a blocked side
+    static void backoff(unsigned &spins) {
+        if (++spins < 64) return;
+        this_thread::yield();
+    }
+
+public:
+    /***** Constructor *****/
+    explicit SpscQueue(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) rounded <<= 1;
+        slots.resize(rounded);
+        mask = rounded - 1;
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    /***** Push *****/
+    /*------------------------------------------------------------------------
+      Appends an item, waiting while the queue is full.
+
+      Precondition:  Called by the producer thread only, before close.
+      Post-condition: The item is queued.
+    -----------------------------------------------------------------------*/
+    void push(T &&item) {
+        size_t position = tail.load(memory_order_relaxed);
+        unsigned spins = 0;
+        while (position - head.load(memory_order_acquire) == slots.size()) {
+            backoff(spins);
+        }
+        slots[position & mask] = move(item);
+        tail.store(position + 1, memory_order_release);
+
+        size_t depth = position + 1 - head.load(memory_order_relaxed);
+        ++pushes;
+        depthSum += depth;
+        if (depth > deepest) deepest = depth;
+    }
+
+    /***** Pop *****/
+    /*------------------------------------------------------------------------
+      Removes the oldest item, waiting while the queue is empty.
+
+      Precondition:  Called by the consumer thread only.
+      Post-condition: Returns true and moves the item into `item`, or returns
+                      false once the queue is closed and empty.
+    -----------------------------------------------------------------------*/
+    bool pop(T &item) {
+        size_t position = head.load(memory_order_relaxed);
+        unsigned spins = 0;
+        while (position == tail.load(memory_order_acquire)) {
+            if (closed.load(memory_order_acquire)) {
+                if (position == tail.load(memory_order_acquire)) return false;
+                break;
+            }
+            backoff(spins);
+        }
+        item = move(slots[position & mask]);
+        head.store(position + 1, memory_order_release);
+        return true;
+    }
+
+    /*------------------------------------------------------------------------
+      Removes the oldest item if the queue holds one, without waiting.
+
+      Precondition:  Called by the consumer thread only.
+      Post-condition: Returns true and moves the item into `item`, or returns
+                      false if the queue is empty.
+    -----------------------------------------------------------------------*/
+    bool tryPop(T &item) {
+        size_t position = head.load(memory_order_relaxed);
+        if (position == tail.load(memory_order_acquire)) return false;
+        item = move(slots[position & mask]);
+        head.store(position + 1, memory_order_release);
+        return true;
+    }
+
+    /***** Close *****/
+    void close() { closed.store(true, memory_order_release); }
+
+    /***** Statistics *****/
+    size_t size() const { return tail.load(memory_order_acquire) - head.load(memory_order_acquire); }
+
+    size_t capacity() const { return slots.size(); }
+
+    // Read once the producer has finished
+    size_t maxDepth() const { return deepest; }
+
+    double meanDepth() const { return pushes ? static_cast<double>(depthSum) / static_cast<double>(pushes) : 0.0; }
+};
+
+#endif // SPSCQUEUE_H
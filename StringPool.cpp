@@ -0,0 +1,95 @@
+#include "StringPool.h"
+#include "MemoryUsage.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// Constructor: Initializes an empty pool
+StringPool::StringPool() : blockUsed(0), usedBytes(0) {}
+
+// Returns the pooled copy of a string, copying it on first use
+string_view StringPool::intern(string_view text) {
+    auto it = interned.find(text);
+    if (it != interned.end()) {
+        return *it;
+    }
+
+    // Start a new block when the current one cannot hold the string
+    if (blocks.empty() || blockUsed + text.size() > blockSizes.back()) {
+        size_t size = max(BLOCK_SIZE, text.size());
+        blocks.emplace_back(new char[size]);
+        blockSizes.push_back(size);
+        blockUsed = 0;
+    }
+
+    char *copy = blocks.back().get() + blockUsed;
+    if (!text.empty()) {
+        memcpy(copy, text.data(), text.size());
+    }
+    blockUsed += text.size();
+    usedBytes += text.size();
+
+    string_view pooled(copy, text.size());
+    interned.insert(pooled);
+    return pooled;
+}
+
+// Returns whether a view is the pooled copy of its text
+bool StringPool::owns(string_view text) const {
+    auto it = interned.find(text);
+    return it != interned.end() && it->data() == text.data();
+}
+
+// Releases every string and arena block
+void StringPool::clear() {
+    interned.clear();
+    blocks.clear();
+    blockSizes.clear();
+    blockUsed = 0;
+    usedBytes = 0;
+}
+
+// Exchanges the strings of two pools; the blocks move, so views stay valid
+void StringPool::swap(StringPool &other) {
+    blocks.swap(other.blocks);
+    blockSizes.swap(other.blockSizes);
+    std::swap(blockUsed, other.blockUsed);
+    std::swap(usedBytes, other.usedBytes);
+    interned.swap(other.interned);
+}
+
+// Returns the number of distinct strings
+size_t StringPool::size() const {
+    return interned.size();
+}
+
+// Returns the bytes of string data stored
+size_t StringPool::bytesUsed() const {
+    return usedBytes;
+}
+
+// Returns the bytes of arena blocks allocated
+size_t StringPool::bytesReserved() const {
+    size_t total = 0;
+    for (size_t size: blockSizes) {
+        total += size;
+    }
+    return total;
+}
+
+// Returns the bytes of the arena blocks and of the lookup set
+size_t StringPool::memoryBytes() const {
+    size_t total = MemoryUsage::vectorBytes(blocks) + MemoryUsage::vectorBytes(blockSizes) +
+                   MemoryUsage::hashBytes(interned);
+    for (size_t size: blockSizes) {
+        total += MemoryUsage::heapBlock(size);
+    }
+    return total;
+}
+
+// Returns the process-wide pool for standalone accounts
+StringPool &StringPool::shared() {
+    static StringPool pool;
+    return pool;
+}
@@ -0,0 +1,113 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+/**-- StringPool.h ----------------------------------------------------------
+  This header file defines the StringPool class, an append-only string arena
+  with interning. Each distinct string is copied once into large arena
+  blocks and handed out as a string_view; interning an equal string again
+  returns the existing view. Views stay valid until the pool is cleared or
+  destroyed.
+
+  Basic operations:
+    Constructor:     Constructs an empty pool.
+    intern:          Returns the pooled view of a string, copying it on first use.
+    owns:            Returns whether a view points into this pool.
+    clear:           Releases every string (invalidates all views).
+    swap:            Exchanges the contents of two pools (views stay valid).
+    size:            Number of distinct strings.
+    bytesUsed:       Bytes of string data stored.
+    bytesReserved:   Bytes of arena blocks allocated.
+    memoryBytes:     Bytes of the arena blocks and of the lookup set.
+    shared:          Process-wide pool for accounts created outside a ForestTree.
+
+  Class Invariant:
+    1. Every view in `interned` points into one of `blocks`.
+    2. No two views in `interned` compare equal.
+--------------------------------------------------------------------------**/
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+class StringPool {
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;    // Default arena block size
+
+    vector<unique_ptr<char[]>> blocks;            // Arena blocks
+    vector<size_t> blockSizes;                    // Capacity of each block
+    size_t blockUsed;                             // Bytes used in the last block
+    size_t usedBytes;                             // Bytes of string data stored
+    unordered_set<string_view> interned;          // Views of the distinct strings
+
+public:
+    /***** Constructor *****/
+    StringPool();
+
+    StringPool(const StringPool &) = delete;
+
+    StringPool &operator=(const StringPool &) = delete;
+
+    /***** Intern *****/
+    /*------------------------------------------------------------------------
+      Returns the pooled copy of a string, copying it into the arena the first
+      time it is seen.
+
+      Precondition:  None.
+      Post-condition: Returns a view equal to `text` that stays valid until the
+                      pool is cleared or destroyed.
+    -----------------------------------------------------------------------*/
+    string_view intern(string_view text);
+
+    /*------------------------------------------------------------------------
+      Returns whether a view is the pooled copy of its text (as opposed to an
+      equal string stored elsewhere, e.g. static data).
+
+      Precondition:  None.
+      Post-condition: Returns true only for views handed out by intern.
+    -----------------------------------------------------------------------*/
+    bool owns(string_view text) const;
+
+    /***** Clear *****/
+    /*------------------------------------------------------------------------
+      Releases every string and arena block.
+
+      Precondition:  No view handed out by this pool is still in use.
+      Post-condition: The pool is empty.
+    -----------------------------------------------------------------------*/
+    void clear();
+
+    /*------------------------------------------------------------------------
+      Exchanges the strings of two pools, e.g. to replace a pool by a copy
+      holding only the strings still in use.
+
+      Precondition:  None.
+      Post-condition: Views handed out by either pool stay valid and now
+                      belong to the other.
+    -----------------------------------------------------------------------*/
+    void swap(StringPool &other);
+
+    /***** Statistics *****/
+    size_t size() const;
+
+    size_t bytesUsed() const;
+
+    size_t bytesReserved() const;
+
+    size_t memoryBytes() const;
+
+    /***** Shared Pool *****/
+    /*------------------------------------------------------------------------
+      Returns the process-wide pool used by accounts that are not created
+      through a ForestTree.
+
+      Precondition:  None.
+      Post-condition: Returns the same pool on every call.
+    -----------------------------------------------------------------------*/
+    static StringPool &shared();
+};
+
+#endif // STRINGPOOL_H
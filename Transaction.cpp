@@ -1,15 +1,18 @@
 #include "Transaction.h"
 #include "Account.h"
+#include <stdexcept>
+#include <cstdio>
 
 using namespace std;
 
-// Constructor: Initializes a Transaction object with amount, type, and related account
-Transaction::Transaction(double amt, char dc)
-        : transactionID(0), amount(amt), debitOrCredit(dc) {
+// Constructor: Initializes a Transaction object with amount, type, and posting date
+Transaction::Transaction(double amt, char dc, int date)
+        : transactionID(0), amount(amt), debitOrCredit(dc), postingDate(0) {
     // Validate the transaction type
     if (dc != 'D' && dc != 'C') {
         throw invalid_argument("Invalid transaction type. Use 'D' for Debit or 'C' for Credit.");
     }
+    setDate(date);
 }
 
 // Returns the transaction ID
@@ -32,6 +35,54 @@ char Transaction::getDebitOrCredit() const {
     return debitOrCredit;
 }
 
+// Returns the posting date (YYYYMMDD, 0 if undated)
+int Transaction::getDate() const {
+    return postingDate;
+}
+
+// Sets the posting date after validating it
+void Transaction::setDate(int date) {
+    if (date != 0 && !isValidDate(date)) {
+        throw invalid_argument("Invalid posting date: " + to_string(date) + ". Use YYYY-MM-DD.");
+    }
+    postingDate = date;
+}
+
+// Checks that a YYYYMMDD value names a real calendar date
+bool Transaction::isValidDate(int date) {
+    int year = date / 10000, month = (date / 100) % 100, day = date % 100;
+    if (year < 1900 || year > 9999 || month < 1 || month > 12 || day < 1) {
+        return false;
+    }
+    static const int daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    int limit = daysInMonth[month - 1] + ((month == 2 && leap) ? 1 : 0);
+    return day <= limit;
+}
+
+// Parses "YYYY-MM-DD" or "YYYYMMDD" into a YYYYMMDD value
+int Transaction::parseDate(const string &text) {
+    int year = 0, month = 0, day = 0;
+    char extra = 0;
+    if (sscanf(text.c_str(), "%4d-%2d-%2d%c", &year, &month, &day, &extra) != 3) {
+        if (text.size() != 8 || sscanf(text.c_str(), "%4d%2d%2d%c", &year, &month, &day, &extra) != 3) {
+            throw invalid_argument("Invalid posting date: " + text + ". Use YYYY-MM-DD.");
+        }
+    }
+    int date = year * 10000 + month * 100 + day;
+    if (!isValidDate(date)) {
+        throw invalid_argument("Invalid posting date: " + text + ". Use YYYY-MM-DD.");
+    }
+    return date;
+}
+
+// Formats a YYYYMMDD value as "YYYY-MM-DD"
+string Transaction::formatDate(int date) {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", date / 10000, (date / 100) % 100, date % 100);
+    return buffer;
+}
+
 // Applies the transaction to the given account and its parent accounts
 void Transaction::applyTransaction(Account *account) const {
     if (!account) return;
@@ -64,6 +115,10 @@ istream &operator>>(istream &in, Transaction &transaction) {
     in >> transaction.amount;
     cout << "Enter Debit or Credit (D/C): ";
     in >> transaction.debitOrCredit;
+    cout << "Enter Posting Date (YYYY-MM-DD, 0 if undated): ";
+    string dateText;
+    in >> dateText;
+    transaction.setDate(dateText == "0" ? 0 : Transaction::parseDate(dateText));
     cout << "Enter Related Account: ";
     in >> transaction.relatedAccount;
     return in;
@@ -74,5 +129,8 @@ ostream &operator<<(ostream &out, const Transaction &transaction) {
     out <<"\n"<< "- Transaction ID: " << transaction.transactionID << "\n"
         << "- Amount: " << transaction.amount << "\n"
         << "- Type: " << (transaction.debitOrCredit == 'D' ? "Debit" : "Credit");
+    if (transaction.postingDate != 0) {
+        out << "\n" << "- Date: " << Transaction::formatDate(transaction.postingDate);
+    }
     return out;
 }
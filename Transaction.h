@@ -4,16 +4,18 @@
 /**-- Transaction.h ----------------------------------------------------------
   This header file defines a Transaction class for representing financial
   transactions associated with accounts. Each transaction includes details
-  about the amount, type (debit or credit), and optionally, related account information.
+  about the amount, type (debit or credit), an optional posting date, and
+  optionally, related account information.
 
   Basic operations:
     Constructor:          Constructs a Transaction object with the specified
-                          amount and type.
+                          amount, type and optional posting date.
     Getters:              Provides access to transaction attributes such as
-                          transaction ID, amount, and type.
+                          transaction ID, amount, type, and posting date.
     Setters:              Allows modification of transaction attributes.
     setTransactionID:     Assigns a transaction ID (used by accounts to assign
                           sequential IDs to their transactions).
+    setDate:              Assigns the posting date of the transaction.
     applyTransaction:     Applies the transaction to a given account and its
                           parent accounts.
     isValid:              Validates the feasibility of applying the transaction
@@ -21,10 +23,16 @@
     Overloaded Operators: Implements input and output stream operations for
                           Transaction objects.
 
+  Date helpers:
+    isValidDate:          Checks that a YYYYMMDD value is a real calendar date.
+    parseDate:            Parses "YYYY-MM-DD" or "YYYYMMDD" into a YYYYMMDD value.
+    formatDate:           Formats a YYYYMMDD value as "YYYY-MM-DD".
+
   Class Invariant:
     1. Each transaction has a unique transaction ID, assigned by the account.
     2. The transaction type is represented by 'D' (Debit) or 'C' (Credit).
     3. The transaction amount must be a valid numeric value.
+    4. The posting date is either 0 (undated) or a valid YYYYMMDD calendar date.
 ----------------------------------------------------------------------------**/
 
 #include <iostream>
@@ -39,18 +47,21 @@ private:
     int transactionID;          // Unique identifier for the transaction (assigned by the account)
     double amount;              // Transaction amount
     char debitOrCredit;         // 'D' for Debit, 'C' for Credit
+    int postingDate;            // Posting date as YYYYMMDD (0 if undated)
     string relatedAccount;      // Account this transaction is related to (optional)
 
 public:
     /***** Constructor *****/
     /*------------------------------------------------------------------------
-      Constructs a Transaction object with the specified amount and type.
+      Constructs a Transaction object with the specified amount, type and
+      optional posting date.
 
       Precondition:  A valid amount and transaction type ('D' or 'C') are provided.
+                     The date is 0 (undated) or a valid YYYYMMDD value.
       Post-condition: A Transaction object is created with the specified attributes.
                       The transaction ID is set separately by the account.
     -----------------------------------------------------------------------*/
-    Transaction(double amt, char dc);
+    Transaction(double amt, char dc, int date = 0);
 
     /***** Getters *****/
     /*------------------------------------------------------------------------
@@ -65,6 +76,8 @@ public:
 
     char getDebitOrCredit() const;
 
+    int getDate() const;
+
     /***** Transaction ID Management *****/
     /*------------------------------------------------------------------------
       Sets the transaction ID for the transaction. This allows accounts to
@@ -75,6 +88,15 @@ public:
     -----------------------------------------------------------------------*/
     void setTransactionID(int id);
 
+    /***** Posting Date Management *****/
+    /*------------------------------------------------------------------------
+      Sets the posting date of the transaction.
+
+      Precondition:  The date is 0 (undated) or a valid YYYYMMDD value.
+      Post-condition: The posting date is updated; throws otherwise.
+    -----------------------------------------------------------------------*/
+    void setDate(int date);
+
     /***** Apply Transaction *****/
     /*------------------------------------------------------------------------
       Applies the transaction to a specified account and its parent accounts.
@@ -95,6 +117,21 @@ public:
     -----------------------------------------------------------------------*/
     bool isValid(const Account *account) const;
 
+    /***** Date Helpers *****/
+    /*------------------------------------------------------------------------
+      Validates, parses and formats posting dates stored as YYYYMMDD integers.
+
+      Precondition:  None.
+      Post-condition: isValidDate returns whether the value is a real calendar
+                      date; parseDate returns the YYYYMMDD value or throws
+                      invalid_argument; formatDate returns "YYYY-MM-DD".
+    -----------------------------------------------------------------------*/
+    static bool isValidDate(int date);
+
+    static int parseDate(const string &text);
+
+    static string formatDate(int date);
+
     /***** Overloaded Operators *****/
     /*------------------------------------------------------------------------
       Implements input and output stream operations for Transaction objects.
@@ -0,0 +1,226 @@
+/**-- AllocationBench.cpp ----------------------------------------------------
+  Google Benchmark suite that counts heap allocations on the posting paths.
+  The global operator new is replaced by a counting version, and each
+  benchmark reports allocations per operation as a counter:
+
+    BM_EmplaceTransaction   ForestTree::emplaceTransaction once the posted
+                            slots are reserved; fails if any posting allocates.
+    BM_AddTransaction       The same through addTransaction(Transaction); fails
+                            if any posting allocates.
+    BM_PostEntry            ForestTree::postEntry of two-leg journal entries
+                            through a reused JournalEntry; fails if any
+                            entry allocates.
+    BM_PipelineFeed         A feed through PostingPipeline. Allocations are
+                            per run (threads, queues, and the batches and line
+                            buffers in flight before the first one is
+                            recycled), so allocations per line fall as the
+                            feed grows.
+    BM_AccountMove / BM_AccountCopy
+                            Moving an account with postings versus copying it.
+
+  A benchmark that sees an allocation where none is allowed stops with an
+  error, so a regression shows up in every run of the suite.
+--------------------------------------------------------------------------**/
+
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+#include <utility>
+#include "ForestTree.h"
+#include "PostingPipeline.h"
+
+using namespace std;
+
+namespace {
+    atomic<uint64_t> allocations{0};
+}
+
+// Counting replacements of the global allocation functions (GCC flags free() in a
+// replacement operator delete as mismatched, although it pairs with the malloc above)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    free(p);
+}
+
+namespace {
+
+    const int ACCOUNTS = 1000;
+    const int64_t POSTINGS = 1 << 20;        // Iterations of the posting benchmarks
+
+    // Accounts 1..ACCOUNTS, each reserved for its share of the postings and
+    // warmed with one posting at both ends of the dates used
+    void prepareTree(ForestTree &tree) {
+        for (int number = 1; number <= ACCOUNTS; ++number) {
+            tree.addAccount(number, "account " + to_string(number), 0.0);
+            tree.reservePostings(number, POSTINGS / ACCOUNTS + 8);
+            tree.emplaceTransaction(number, 1.0, 'D', 20240101);
+            tree.emplaceTransaction(number, 1.0, 'D', 20241231);
+        }
+    }
+
+    // Reports allocations per item and fails the benchmark if any were not allowed
+    void reportAllocations(benchmark::State &state, uint64_t counted, int64_t items, bool mustBeZero) {
+        state.counters["allocations_per_item"] = static_cast<double>(counted) / static_cast<double>(items);
+        if (mustBeZero && counted != 0) {
+            state.SkipWithError(("steady-state path allocated " + to_string(counted) + " times").c_str());
+        }
+    }
+
+    void BM_EmplaceTransaction(benchmark::State &state) {
+        ForestTree tree;
+        prepareTree(tree);
+        int i = 0;
+        uint64_t before = allocations.load(memory_order_relaxed);
+        for (auto _: state) {
+            tree.emplaceTransaction(i % ACCOUNTS + 1, 12.5, 'D', 20240101 + (i % 12) * 100);
+            ++i;
+        }
+        uint64_t counted = allocations.load(memory_order_relaxed) - before;
+        state.SetItemsProcessed(state.iterations());
+        reportAllocations(state, counted, state.iterations(), true);
+    }
+
+    void BM_AddTransaction(benchmark::State &state) {
+        ForestTree tree;
+        prepareTree(tree);
+        int i = 0;
+        uint64_t before = allocations.load(memory_order_relaxed);
+        for (auto _: state) {
+            tree.addTransaction(i % ACCOUNTS + 1, Transaction(12.5, 'D', 20240101 + (i % 12) * 100));
+            ++i;
+        }
+        uint64_t counted = allocations.load(memory_order_relaxed) - before;
+        state.SetItemsProcessed(state.iterations());
+        reportAllocations(state, counted, state.iterations(), true);
+    }
+
+    void BM_PostEntry(benchmark::State &state) {
+        ForestTree tree;
+        prepareTree(tree);
+        for (int number = 1; number <= ACCOUNTS; ++number) {
+            tree.emplaceTransaction(number, 1000.0, 'D', 20240101);   // Covers the credit legs
+        }
+        JournalEntry entry;
+        entry.debit(999, 1.0);
+        entry.credit(100, 1.0);
+        tree.postEntry(entry);                  // Sizes the scratch space for two legs three levels deep
+        int i = 0;
+        uint64_t before = allocations.load(memory_order_relaxed);
+        for (auto _: state) {
+            // Debit one account and credit the next; the following entry reverses the pair
+            int first = (i / 2) % ACCOUNTS + 1, second = first % ACCOUNTS + 1;
+            if (i & 1) swap(first, second);
+            entry.clear(20240101 + (i % 12) * 100);
+            entry.debit(first, 12.5);
+            entry.credit(second, 12.5);
+            tree.postEntry(entry);
+            ++i;
+        }
+        uint64_t counted = allocations.load(memory_order_relaxed) - before;
+        state.SetItemsProcessed(state.iterations());
+        reportAllocations(state, counted, state.iterations(), true);
+    }
+
+    void BM_PipelineFeed(benchmark::State &state) {
+        int64_t lines = state.range(0);
+        string feed;
+        for (int64_t i = 0; i < lines; ++i) {
+            feed += to_string(i % ACCOUNTS + 1) + " 12.50 D 2024-" + to_string(i % 12 + 1) + "-15\n";
+        }
+
+        uint64_t counted = 0;
+        for (auto _: state) {
+            state.PauseTiming();
+            ForestTree tree;
+            for (int number = 1; number <= ACCOUNTS; ++number) {
+                tree.addAccount(number, "account " + to_string(number), 0.0);
+                tree.reservePostings(number, static_cast<size_t>(lines / ACCOUNTS + 1));
+            }
+            istringstream in(feed);
+            PostingPipeline pipeline(tree);
+            state.ResumeTiming();
+
+            uint64_t before = allocations.load(memory_order_relaxed);
+            PostingPipeline::Report report = pipeline.run(in, nullptr, nullptr);
+            counted += allocations.load(memory_order_relaxed) - before;
+            benchmark::DoNotOptimize(report.applied);
+        }
+        state.SetItemsProcessed(state.iterations() * lines);
+        reportAllocations(state, counted, state.iterations() * lines, false);
+    }
+
+    // Account with postings in a tree's store
+    struct AccountFixture {
+        PostingStore store;
+        StringPool pool;
+        Account account;
+
+        AccountFixture() : account(1011, "Subscribed capital - uncalled", 0.0, &store, &pool) {
+            for (int i = 0; i < 100; ++i) {
+                account.addTransaction(10.0 + i, 'D', 20240101);
+            }
+        }
+    };
+
+    void BM_AccountMove(benchmark::State &state) {
+        AccountFixture fixture;
+        uint64_t before = allocations.load(memory_order_relaxed);
+        for (auto _: state) {
+            Account moved(move(fixture.account));
+            fixture.account = move(moved);
+            benchmark::DoNotOptimize(fixture.account);
+        }
+        uint64_t counted = allocations.load(memory_order_relaxed) - before;
+        state.SetItemsProcessed(state.iterations());
+        reportAllocations(state, counted, state.iterations(), true);
+    }
+
+    void BM_AccountCopy(benchmark::State &state) {
+        AccountFixture fixture;
+        uint64_t before = allocations.load(memory_order_relaxed);
+        for (auto _: state) {
+            Account copy(fixture.account);
+            benchmark::DoNotOptimize(copy);
+        }
+        uint64_t counted = allocations.load(memory_order_relaxed) - before;
+        state.SetItemsProcessed(state.iterations());
+        reportAllocations(state, counted, state.iterations(), false);
+    }
+}
+
+BENCHMARK(BM_EmplaceTransaction)->Iterations(POSTINGS);
+BENCHMARK(BM_AddTransaction)->Iterations(POSTINGS);
+BENCHMARK(BM_PostEntry)->Iterations(POSTINGS / 2);
+BENCHMARK(BM_PipelineFeed)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AccountMove);
+BENCHMARK(BM_AccountCopy);
+
+BENCHMARK_MAIN();
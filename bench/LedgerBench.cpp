@@ -0,0 +1,540 @@
+/**-- LedgerBench.cpp -------------------------------------------------------
+  Google Benchmark suite for the ForestTree operations: buildFromFile, buildFromTable,
+  addAccount, addTransaction, removeTransaction, searchAccount, removeAccount,
+  printTree and cached subtree aggregates, batch validation against posting
+  rules, bulk removal by filter against one removeTransaction per posting,
+  structural diffs of two ledger states (LedgerDiff), balance recomputation from the
+  postings, top-K postings against a full sort, the multi-entity ledger (posting,
+  consolidation and overlay memory over the base chart), plus batch commands run end to end through BatchRunner. Each is measured on the real chart (accountswithspace.txt)
+  and/or on synthetic charts and ledgers of increasing size.
+
+  Synthetic charts number their accounts 1..N, so every account's parent
+  (its number without the last digit) exists. Synthetic ledger files are
+  produced by printTree and cached in the system temporary directory.
+
+  Run with --benchmark_out=<file> --benchmark_out_format=json (or build the
+  bench-json target) to record results for comparison over time.
+--------------------------------------------------------------------------**/
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+#include <limits>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "BaseChart.h"
+#include "BatchRunner.h"
+#include "ForestTree.h"
+#include "LedgerDiff.h"
+#include "MultiEntityLedger.h"
+
+using namespace std;
+
+namespace {
+
+    const char *const WORDS[] = {"capital", "reserves", "depreciation", "provisions", "receivables",
+                                 "payables", "inventory", "revenue", "expenses", "taxes", "bank",
+                                 "loans", "fixed", "assets", "other", "services"};
+
+    // Deterministic description for a synthetic account
+    string syntheticDescription(int accountNumber) {
+        unsigned hash = static_cast<unsigned>(accountNumber) * 2654435761u;
+        string description = WORDS[hash % 16];
+        description += ' ';
+        description += WORDS[(hash >> 8) % 16];
+        return description;
+    }
+
+    // Fills a tree with accounts 1..accountCount
+    void addSyntheticAccounts(ForestTree &tree, int accountCount) {
+        for (int number = 1; number <= accountCount; ++number) {
+            tree.addAccount(number, syntheticDescription(number), 0.0);
+        }
+    }
+
+    // Adds debit postings spread round-robin over accounts 1..accountCount
+    void addSyntheticPostings(ForestTree &tree, int accountCount, long long postingCount) {
+        mt19937 rng(7);
+        uniform_int_distribution<int> cents(1, 1000000);
+        for (long long i = 0; i < postingCount; ++i) {
+            int account = static_cast<int>(i % accountCount) + 1;
+            tree.addTransaction(account, Transaction(cents(rng) / 100.0, 'D'));
+        }
+    }
+
+    // Returns (and creates on first use) a synthetic ledger file
+    string syntheticLedgerFile(int accountCount, int postingsPerAccount) {
+        static map<pair<int, int>, string> files;
+        auto key = make_pair(accountCount, postingsPerAccount);
+        auto it = files.find(key);
+        if (it != files.end()) {
+            return it->second;
+        }
+
+        filesystem::path dir = filesystem::temp_directory_path() / "chart-bench";
+        filesystem::create_directories(dir);
+        string path = (dir / ("ledger-" + to_string(accountCount) + "-" + to_string(postingsPerAccount) + ".txt")).string();
+
+        ForestTree tree;
+        addSyntheticAccounts(tree, accountCount);
+        addSyntheticPostings(tree, accountCount, static_cast<long long>(accountCount) * postingsPerAccount);
+        tree.printTree(path);
+        files[key] = path;
+        return path;
+    }
+
+    /***** buildFromFile *****/
+
+    void BM_BuildFromFile_Chart(benchmark::State &state) {
+        auto bytes = static_cast<int64_t>(filesystem::file_size(CHART_FILE));
+        for (auto _: state) {
+            ForestTree tree;
+            tree.buildFromFile(CHART_FILE);
+            benchmark::DoNotOptimize(tree.searchAccount(1));
+        }
+        state.SetBytesProcessed(state.iterations() * bytes);
+    }
+
+    // Same chart from the static table generated at build time
+    void BM_BuildFromTable_BaseChart(benchmark::State &state) {
+        for (auto _: state) {
+            ForestTree tree;
+            tree.buildFromTable(BASE_CHART);
+            benchmark::DoNotOptimize(tree.searchAccount(1));
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(BASE_CHART.count));
+    }
+
+    void BM_BuildFromFile_Synthetic(benchmark::State &state) {
+        int accounts = static_cast<int>(state.range(0));
+        int postingsPerAccount = static_cast<int>(state.range(1));
+        string path = syntheticLedgerFile(accounts, postingsPerAccount);
+        auto bytes = static_cast<int64_t>(filesystem::file_size(path));
+        for (auto _: state) {
+            ForestTree tree;
+            tree.buildFromFile(path);
+            benchmark::DoNotOptimize(tree.searchAccount(1));
+        }
+        state.SetBytesProcessed(state.iterations() * bytes);
+        state.counters["postings"] = static_cast<double>(accounts) * postingsPerAccount;
+    }
+
+    /***** addAccount *****/
+
+    void BM_AddAccount(benchmark::State &state) {
+        int accounts = static_cast<int>(state.range(0));
+        for (auto _: state) {
+            ForestTree tree;
+            addSyntheticAccounts(tree, accounts);
+            benchmark::DoNotOptimize(tree.searchAccount(accounts));
+            state.PauseTiming(); // Exclude the destructor
+            tree.initialize();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * accounts);
+    }
+
+    /***** addTransaction *****/
+
+    void BM_AddTransaction(benchmark::State &state) {
+        int accounts = static_cast<int>(state.range(0));
+        ForestTree tree;
+        addSyntheticAccounts(tree, accounts);
+        int next = 0;
+        for (auto _: state) {
+            tree.addTransaction(accounts - next, Transaction(12.5, 'D'));
+            next = (next + 1) % accounts;
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    /***** removeTransaction *****/
+
+    void BM_RemoveTransaction(benchmark::State &state) {
+        int postings = static_cast<int>(state.range(0));
+        ForestTree tree;
+        tree.addAccount(1, "Benchmark account", 0.0);
+        addSyntheticPostings(tree, 1, postings);
+        for (auto _: state) {
+            tree.removeTransaction(1, postings / 2);
+            state.PauseTiming(); // Restore the posting count
+            tree.addTransaction(1, Transaction(1.0, 'D'));
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    /***** searchAccount *****/
+
+    void BM_SearchAccount(benchmark::State &state) {
+        int accounts = static_cast<int>(state.range(0));
+        ForestTree tree;
+        addSyntheticAccounts(tree, accounts);
+        vector<int> keys(4096);
+        mt19937 rng(11);
+        for (int &key: keys) {
+            key = static_cast<int>(rng() % accounts) + 1;
+        }
+        size_t i = 0;
+        for (auto _: state) {
+            benchmark::DoNotOptimize(tree.searchAccount(keys[i++ & 4095]));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_SearchAccount_Chart(benchmark::State &state) {
+        ForestTree tree;
+        tree.buildFromFile(CHART_FILE);
+        int probes[] = {1, 10, 101, 1011, 10131, 512, 5121, 601, 70, 99999};
+        size_t i = 0;
+        for (auto _: state) {
+            benchmark::DoNotOptimize(tree.searchAccount(probes[i++ % 10]));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    /***** removeAccount *****/
+
+    void BM_RemoveAccount(benchmark::State &state) {
+        int accounts = static_cast<int>(state.range(0));
+        vector<int> order(accounts);
+        for (int i = 0; i < accounts; ++i) order[i] = i + 1;
+        shuffle(order.begin(), order.end(), mt19937(13));
+
+        for (auto _: state) {
+            state.PauseTiming();
+            ForestTree tree;
+            addSyntheticAccounts(tree, accounts);
+            state.ResumeTiming();
+            for (int number: order) {
+                tree.removeAccount(number);
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * accounts);
+    }
+
+    /***** printTree *****/
+
+    void BM_PrintTree(benchmark::State &state) {
+        int accounts = static_cast<int>(state.range(0));
+        int postingsPerAccount = static_cast<int>(state.range(1));
+        ForestTree tree;
+        addSyntheticAccounts(tree, accounts);
+        addSyntheticPostings(tree, accounts, static_cast<long long>(accounts) * postingsPerAccount);
+        string path = (filesystem::temp_directory_path() / "chart-bench-print.txt").string();
+        for (auto _: state) {
+            tree.printTree(path);
+        }
+        state.SetItemsProcessed(state.iterations() * accounts);
+        filesystem::remove(path);
+    }
+
+    // Re-export after a single posting: only the posted account's chain is re-rendered
+    void BM_PrintTree_AfterPosting(benchmark::State &state) {
+        int accounts = static_cast<int>(state.range(0));
+        int postingsPerAccount = static_cast<int>(state.range(1));
+        ForestTree tree;
+        addSyntheticAccounts(tree, accounts);
+        addSyntheticPostings(tree, accounts, static_cast<long long>(accounts) * postingsPerAccount);
+        string path = (filesystem::temp_directory_path() / "chart-bench-print.txt").string();
+        tree.printTree(path);
+        int next = 0;
+        for (auto _: state) {
+            tree.addTransaction(accounts - next, Transaction(1.0, 'D'));
+            next = (next + 1) % accounts;
+            tree.printTree(path);
+        }
+        state.SetItemsProcessed(state.iterations() * accounts);
+        filesystem::remove(path);
+    }
+
+    void BM_PrintTree_Chart(benchmark::State &state) {
+        ForestTree tree;
+        tree.buildFromFile(CHART_FILE);
+        string path = (filesystem::temp_directory_path() / "chart-bench-print.txt").string();
+        for (auto _: state) {
+            tree.printTree(path);
+        }
+        filesystem::remove(path);
+    }
+
+    /***** Subtree aggregates *****/
+
+    // Dashboard-style turnover of the nine top-level subtrees; range(1) postings land between rounds
+    void BM_SubtreeAggregate(benchmark::State &state) {
+        int accounts = static_cast<int>(state.range(0));
+        int postingsPerRound = static_cast<int>(state.range(1));
+        ForestTree tree;
+        addSyntheticAccounts(tree, accounts);
+        addSyntheticPostings(tree, accounts, static_cast<long long>(accounts) * 10);
+        mt19937 rng(23);
+        int top = 0;
+        for (auto _: state) {
+            if (top == 0) {
+                for (int i = 0; i < postingsPerRound; ++i) {
+                    tree.addTransaction(static_cast<int>(rng() % accounts) + 1, Transaction(1.0, 'C', 20240115));
+                }
+            }
+            benchmark::DoNotOptimize(tree.subtreeAggregate(top + 1, QueryCache::TURNOVER, 20240101, 20241231));
+            top = (top + 1) % 9;
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    /***** Posting rules *****/
+
+    // Batch validation of 4096 postings against rules on two classes (range(0) accounts)
+    void BM_ValidatePostings(benchmark::State &state) {
+        int accounts = static_cast<int>(state.range(0));
+        ForestTree tree;
+        addSyntheticAccounts(tree, accounts);
+        PostingRules::Rule liabilities, limited;
+        liabilities.floor = -numeric_limits<double>::infinity();
+        limited.limit = 5000.0;
+        tree.setPostingRule(4, liabilities);
+        tree.setPostingRule(6, limited);
+
+        const size_t n = 4096;
+        vector<int> numbers(n), slots(n);
+        vector<double> amounts(n);
+        vector<char> types(n);
+        vector<unsigned char> verdicts(n);
+        mt19937 rng(41);
+        for (size_t i = 0; i < n; ++i) {
+            numbers[i] = static_cast<int>(rng() % (accounts + accounts / 100)) + 1;   // ~1% unknown
+            amounts[i] = (rng() % 1000000 + 1) / 100.0;
+            types[i] = (rng() % 2) ? 'D' : 'C';
+        }
+        for (auto _: state) {
+            benchmark::DoNotOptimize(tree.validatePostings(numbers.data(), amounts.data(), types.data(), n,
+                                                           slots.data(), verdicts.data()));
+        }
+        state.SetItemsProcessed(state.iterations() * n);
+    }
+
+    /***** Multi-entity ledger *****/
+
+    // Ledger of range(0) entities over the base chart, each with postingsPerEntity debits
+    void fillEntities(MultiEntityLedger &ledger, int entityCount, int postingsPerEntity) {
+        const ChartSkeleton &skeleton = ledger.getSkeleton();
+        mt19937 rng(31);
+        for (int e = 0; e < entityCount; ++e) {
+            EntityLedger &entity = ledger.addEntity("entity " + to_string(e));
+            for (int i = 0; i < postingsPerEntity; ++i) {
+                int index = static_cast<int>(rng() % skeleton.size());
+                entity.post(skeleton.getAccountNumber(index), (rng() % 100000 + 1) / 100.0, 'D', 20240115);
+            }
+        }
+    }
+
+    void BM_MultiEntityPost(benchmark::State &state) {
+        MultiEntityLedger ledger(make_shared<ChartSkeleton>(BASE_CHART));
+        fillEntities(ledger, 1, 0);
+        EntityLedger &entity = ledger.getEntity("entity 0");
+        const ChartSkeleton &skeleton = ledger.getSkeleton();
+        size_t i = 0;
+        for (auto _: state) {
+            entity.post(skeleton.getAccountNumber(static_cast<int>(i++ % skeleton.size())), 12.5, 'D', 20240115);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // Consolidated balances of every account over range(0) entities with range(1) postings each
+    void BM_MultiEntityConsolidate(benchmark::State &state) {
+        int entityCount = static_cast<int>(state.range(0));
+        MultiEntityLedger ledger(make_shared<ChartSkeleton>(BASE_CHART));
+        fillEntities(ledger, entityCount, static_cast<int>(state.range(1)));
+        for (auto _: state) {
+            benchmark::DoNotOptimize(ledger.consolidatedBalances());
+        }
+        state.SetItemsProcessed(state.iterations() * entityCount);
+        state.counters["ledger_bytes"] = static_cast<double>(ledger.memoryBytes());
+        state.counters["bytes_per_entity"] = static_cast<double>(ledger.memoryBytes()) / entityCount;
+    }
+
+    /***** BatchRunner *****/
+
+    // Removes the postings under 500.00 from a 1000-account chart: removePostings over each top-level
+    // subtree (bulk = 1) or removeTransaction per matching posting, highest ID first (bulk = 0)
+    void BM_RemovePostings(benchmark::State &state) {
+        int perAccount = static_cast<int>(state.range(0));
+        bool bulk = state.range(1) != 0;
+        PostingFilter filter;
+        filter.maxAmount = 499.99;
+        size_t removed = 0;
+        for (auto _: state) {
+            state.PauseTiming();
+            ForestTree tree;
+            addSyntheticAccounts(tree, 1000);
+            mt19937 rng(23);
+            for (int account = 1; account <= 1000; ++account) {
+                for (int i = 0; i < perAccount; ++i) {
+                    tree.emplaceTransaction(account, (rng() % 100000 + 1) / 100.0, 'D',
+                                            20240101 + static_cast<int>(rng() % 28));
+                }
+            }
+            state.ResumeTiming();
+
+            if (bulk) {
+                for (int top = 1; top <= 9; ++top) {
+                    removed += tree.removePostings(top, filter, true);
+                }
+            } else {
+                for (int account = 1; account <= 1000; ++account) {
+                    Account *node = tree.searchAccount(account);
+                    vector<int> ids;
+                    for (auto posting: node->getTransactions()) {
+                        if (posting.getAmount() <= filter.maxAmount) ids.push_back(posting.getTransactionID());
+                    }
+                    for (auto id = ids.rbegin(); id != ids.rend(); ++id) {
+                        tree.removeTransaction(account, *id);
+                    }
+                    removed += ids.size();
+                }
+            }
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(removed));
+    }
+
+    // Diffs two synthetic ledgers with 10 postings per account that differ in `changes` postings
+    void BM_LedgerDiff(benchmark::State &state) {
+        int accounts = static_cast<int>(state.range(0));
+        int changes = static_cast<int>(state.range(1));
+        ForestTree before, after;
+        addSyntheticAccounts(before, accounts);
+        addSyntheticAccounts(after, accounts);
+        mt19937 rng(29);
+        for (int account = 1; account <= accounts; ++account) {
+            for (int i = 0; i < 10; ++i) {
+                double amount = (rng() % 100000 + 1) / 100.0;
+                before.emplaceTransaction(account, amount, 'D');
+                after.emplaceTransaction(account, amount, 'D');
+            }
+        }
+        for (int i = 0; i < changes; ++i) {
+            after.emplaceTransaction(static_cast<int>(rng() % accounts) + 1, 1.0, 'D');
+        }
+        for (auto _: state) {
+            LedgerDiff::Report report = LedgerDiff::compare(before, after);
+            benchmark::DoNotOptimize(report.addedPostings.data());
+        }
+        state.SetItemsProcessed(state.iterations() * accounts);
+    }
+
+    // Loads a ledger exported by printTree and diffs it against the live tree; fails unless the diff is empty
+    // and exporting the loaded ledger reproduces the file byte for byte
+    void BM_LedgerDiff_Exported(benchmark::State &state) {
+        int accounts = static_cast<int>(state.range(0));
+        ForestTree live;
+        addSyntheticAccounts(live, accounts);
+        live.addAccount(99999, "opening balance", 1234.56);
+        addSyntheticPostings(live, accounts, 5LL * accounts);
+        string path = (filesystem::temp_directory_path() / "chart-bench" / "exported.txt").string();
+        filesystem::create_directories(filesystem::path(path).parent_path());
+        live.printTree(path);
+        ostringstream exported;
+        live.printTree(exported);
+        for (auto _: state) {
+            ForestTree saved;
+            saved.buildFromFile(path);
+            LedgerDiff::Report report = LedgerDiff::compare(saved, live);
+            if (!report.addedAccounts.empty() || !report.removedAccounts.empty() ||
+                !report.changedDescriptions.empty() || !report.balanceChanges.empty() ||
+                !report.addedPostings.empty() || !report.removedPostings.empty()) {
+                state.SkipWithError("an exported ledger does not load back to the same state");
+                break;
+            }
+            ostringstream reexported;
+            saved.printTree(reexported);
+            if (reexported.str() != exported.str()) {
+                state.SkipWithError("exporting a loaded ledger does not reproduce the file");
+                break;
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * accounts);
+    }
+
+    void BM_BatchPost(benchmark::State &state) {
+        int accounts = static_cast<int>(state.range(0));
+        ForestTree tree;
+        addSyntheticAccounts(tree, accounts);
+        BatchRunner runner(tree);
+        vector<string> commands(4096);
+        mt19937 rng(17);
+        for (size_t i = 0; i < commands.size(); ++i) {
+            commands[i] = "post " + to_string(rng() % accounts + 1) + " " + to_string((rng() % 100000 + 1) / 100.0) +
+                          " D 2024-" + to_string(rng() % 12 + 1) + "-" + to_string(rng() % 28 + 1);
+        }
+        size_t i = 0;
+        for (auto _: state) {
+            benchmark::DoNotOptimize(runner.execute(commands[i++ & 4095]));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // Recomputes every balance of a synthetic ledger with 20 postings per account on `threads` threads
+    void BM_RecomputeBalances(benchmark::State &state) {
+        int accounts = static_cast<int>(state.range(0));
+        auto threads = static_cast<unsigned>(state.range(1));
+        ForestTree tree;
+        addSyntheticAccounts(tree, accounts);
+        addSyntheticPostings(tree, accounts, 20LL * accounts);
+        for (auto _: state) {
+            benchmark::DoNotOptimize(tree.recomputeBalances(nullptr, threads));
+        }
+        state.SetItemsProcessed(state.iterations() * 20LL * accounts);
+    }
+
+    // The 20 largest postings of 64000 accounts x 10: bounded heap (0) against copying and sorting them all (1)
+    void BM_TopPostings(benchmark::State &state) {
+        bool fullSort = state.range(0) != 0;
+        const int accounts = 64000;
+        ForestTree tree;
+        addSyntheticAccounts(tree, accounts);
+        addSyntheticPostings(tree, accounts, 10LL * accounts);
+        for (auto _: state) {
+            if (fullSort) {
+                vector<double> amounts;
+                for (const auto &pair: tree.getAccountMap()) {
+                    for (auto posting: pair.second->getTransactions()) amounts.push_back(posting.getAmount());
+                }
+                sort(amounts.begin(), amounts.end(), greater<double>());
+                benchmark::DoNotOptimize(amounts.data());
+            } else {
+                benchmark::DoNotOptimize(tree.topPostings(20).data());
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * 10LL * accounts);
+    }
+}
+
+BENCHMARK(BM_BuildFromFile_Chart)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BuildFromTable_BaseChart)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BuildFromFile_Synthetic)->Args({1000, 0})->Args({1000, 10})->Args({10000, 10})->Args({50000, 20})
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AddAccount)->RangeMultiplier(8)->Range(1000, 64000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AddTransaction)->Arg(1000)->Arg(64000);
+BENCHMARK(BM_RemoveTransaction)->RangeMultiplier(10)->Range(100, 100000);
+BENCHMARK(BM_SearchAccount)->RangeMultiplier(8)->Range(1000, 64000);
+BENCHMARK(BM_SearchAccount_Chart);
+BENCHMARK(BM_RemoveAccount)->RangeMultiplier(8)->Range(1000, 64000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PrintTree)->Args({1000, 0})->Args({1000, 10})->Args({8000, 10})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PrintTree_AfterPosting)->Args({1000, 10})->Args({8000, 10})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PrintTree_Chart)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SubtreeAggregate)->Args({8000, 0})->Args({8000, 1})->Args({8000, 9});
+BENCHMARK(BM_ValidatePostings)->Arg(1000)->Arg(64000);
+BENCHMARK(BM_MultiEntityPost);
+BENCHMARK(BM_MultiEntityConsolidate)->Args({50, 0})->Args({50, 200})->Args({500, 200})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RemovePostings)->Args({20, 0})->Args({20, 1})->Args({200, 0})->Args({200, 1})
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LedgerDiff)->Args({8000, 0})->Args({8000, 100})->Args({64000, 100})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LedgerDiff_Exported)->Arg(8000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BatchPost)->Arg(1000)->Arg(64000);
+BENCHMARK(BM_TopPostings)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RecomputeBalances)->Args({8000, 1})->Args({64000, 1})->Args({64000, 4})->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
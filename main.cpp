@@ -1,15 +1,347 @@
 #include <iostream>
 #include <fstream>
 #include <limits>
+#include <iomanip>
+#include <chrono>
+#include <csignal>
+#include <memory>
 
 #include "ForestTree.h"
+#include "BatchRunner.h"
+#include "LedgerServer.h"
+#include "LogFollower.h"
+#include "LogShipper.h"
+#include "PostingPipeline.h"
+#include "LedgerDiff.h"
+#include "Metrics.h"
+#include "BaseChart.h"
 
 using namespace std;
 
-// Predefined file paths for loading and saving account data
-const string ORIGINAL_FILE = "C:\\Users\\Personal\\CLionProjects\\ADSProject\\CSIS217-midterm\\accountswithspace.txt";
+// Predefined file path for loading and saving account data (overridden by --input / --output);
+// without it, the chart starts from the base chart compiled into the executable (BaseChart.h)
 const string UPDATED_FILE = "C:\\Users\\Personal\\CLionProjects\\ADSProject\\CSIS217-midterm\\accountswithspace2.txt";
 
+// Command-line options
+struct Options {
+    string inputFile;      // Chart to load, or @base (interactive default: UPDATED_FILE if present, else @base)
+    string outputFile;     // Where to save (interactive default: UPDATED_FILE; batch: not saved)
+    string batchFile;      // Command file, or - for stdin; empty for the interactive menu
+    string resultsFile;    // Batch results, or - for stdout
+    string metricsFile;    // Metrics JSON written on exit
+    string serveAddress;   // unix:<path> or tcp:[<host>:]<port>; empty unless serving
+    size_t workers = 0;    // Server worker threads (0 = hardware concurrency)
+    string filesDirectory; // Directory server clients may export to and diff against (none if empty)
+    string publishPath;    // Unix socket the server's operation log is shipped on (primary)
+    string followPath;     // Unix socket of the primary whose log the server applies (replica)
+    size_t retain = 0;     // Log entries a primary keeps for resuming replicas (0 = all)
+    string feedFile;       // Posting feed, or - for stdin; empty unless ingesting
+    string journalFile;    // Replayable journal of the applied postings
+    string rejectsFile;    // Rejected feed lines with their reasons
+    string diffFile;       // Earlier saved chart to compare --input against
+};
+
+// Displays the command-line usage
+void displayUsage() {
+    cerr << "Usage: chart [options]\n"
+         << "  --input <file>|@base  Chart to load (@base: the built-in base chart)\n"
+         << "  --output <file>       File the chart is saved to on exit\n"
+         << "  --batch <file>|-      Run commands from a file or stdin instead of the menu\n"
+         << "  --results <file>|-    Batch results as JSON lines (default: -)\n"
+         << "  --metrics <file>      Write operation metrics as JSON on exit\n"
+         << "  --serve unix:<path>|tcp:[<host>:]<port>\n"
+         << "                        Serve the batch commands to local clients until SIGINT/SIGTERM\n"
+         << "  --workers <n>         Server worker threads (default: hardware concurrency)\n"
+         << "  --files <dir>         With --serve: directory clients may export to and diff against\n"
+         << "                        (plain file names only; file commands are rejected without it)\n"
+         << "  --publish <path>      With --serve: ship the operation log to replicas on a Unix socket\n"
+         << "  --follow <path>       With --serve: run as a read-only replica of the primary publishing\n"
+         << "                        on <path> (start both from the same --input)\n"
+         << "  --retain <n>          Log entries the primary keeps for replicas to resume from (default: all)\n"
+         << "  --feed <file>|-       Ingest a posting feed through the staged pipeline\n"
+         << "  --journal <file>      Journal of the applied postings (with --feed)\n"
+         << "  --rejects <file>      Rejected feed lines (with --feed; default: stderr)\n"
+         << "  --diff <file>|@base   Print what changed from an earlier chart to --input\n"
+         << "Batch commands are listed in BatchRunner.h." << endl;
+}
+
+// Parses the command-line options
+Options parseOptions(int argc, char **argv) {
+    Options options;
+    options.resultsFile = "-";
+    for (int i = 1; i < argc; ++i) {
+        string flag = argv[i];
+        if (i + 1 >= argc) {
+            throw invalid_argument("Missing value for " + flag);
+        }
+        string value = argv[++i];
+        if (flag == "--input") options.inputFile = value;
+        else if (flag == "--output") options.outputFile = value;
+        else if (flag == "--batch") options.batchFile = value;
+        else if (flag == "--results") options.resultsFile = value;
+        else if (flag == "--metrics") options.metricsFile = value;
+        else if (flag == "--serve") options.serveAddress = value;
+        else if (flag == "--workers") options.workers = stoul(value);
+        else if (flag == "--files") options.filesDirectory = value;
+        else if (flag == "--publish") options.publishPath = value;
+        else if (flag == "--follow") options.followPath = value;
+        else if (flag == "--retain") options.retain = stoul(value);
+        else if (flag == "--feed") options.feedFile = value;
+        else if (flag == "--journal") options.journalFile = value;
+        else if (flag == "--rejects") options.rejectsFile = value;
+        else if (flag == "--diff") options.diffFile = value;
+        else throw invalid_argument("Unknown option: " + flag);
+    }
+    return options;
+}
+
+// Loads a chart file, or the built-in base chart for @base
+void loadChart(ForestTree &forestTree, const string &inputFile) {
+    if (inputFile == "@base") {
+        forestTree.buildFromTable(BASE_CHART);
+    } else {
+        forestTree.buildFromFile(inputFile);
+    }
+}
+
+// Runs a command stream without prompts; starts from an empty chart unless --input is given
+int runBatch(const Options &options) {
+    ForestTree forestTree;
+    try {
+        if (!options.inputFile.empty()) {
+            loadChart(forestTree, options.inputFile);
+        }
+    } catch (const exception &e) {
+        cerr << "Error loading accounts: " << e.what() << endl;
+        return 1;
+    }
+
+    ifstream commandFile;
+    if (options.batchFile != "-") {
+        commandFile.open(options.batchFile);
+        if (!commandFile.is_open()) {
+            cerr << "Could not open file: " << options.batchFile << endl;
+            return 1;
+        }
+    }
+    ofstream resultsFile;
+    if (options.resultsFile != "-") {
+        resultsFile.open(options.resultsFile);
+        if (!resultsFile.is_open()) {
+            cerr << "Could not open file for writing: " << options.resultsFile << endl;
+            return 1;
+        }
+    }
+    istream &in = (options.batchFile == "-") ? cin : commandFile;
+    ostream &out = (options.resultsFile == "-") ? cout : resultsFile;
+
+    BatchRunner runner(forestTree);
+    auto started = chrono::steady_clock::now();
+    size_t failed = runner.run(in, out);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    const BatchRunner::Stats &stats = runner.getStats();
+    cerr << "chart: " << stats.commands << " commands (" << stats.failed << " failed) in " << seconds << " s ("
+         << (seconds > 0 ? stats.commands / seconds : 0.0) << " commands/s)" << endl;
+
+    try {
+        if (!options.outputFile.empty()) {
+            forestTree.printTree(options.outputFile);
+        }
+        if (!options.metricsFile.empty()) {
+            Metrics::writeJson(options.metricsFile);
+        }
+    } catch (const exception &e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return failed == 0 ? 0 : 1;
+}
+
+// Ingests a posting feed through the staged pipeline; starts from an empty chart unless --input is given
+int runFeed(const Options &options) {
+    ForestTree forestTree;
+    try {
+        if (!options.inputFile.empty()) {
+            loadChart(forestTree, options.inputFile);
+        }
+    } catch (const exception &e) {
+        cerr << "Error loading accounts: " << e.what() << endl;
+        return 1;
+    }
+
+    ifstream feedFile;
+    ofstream journalFile, rejectsFile;
+    if (options.feedFile != "-") {
+        feedFile.open(options.feedFile);
+        if (!feedFile.is_open()) {
+            cerr << "Could not open file: " << options.feedFile << endl;
+            return 1;
+        }
+    }
+    if (!options.journalFile.empty()) {
+        journalFile.open(options.journalFile);
+        if (!journalFile.is_open()) {
+            cerr << "Could not open file for writing: " << options.journalFile << endl;
+            return 1;
+        }
+    }
+    if (!options.rejectsFile.empty()) {
+        rejectsFile.open(options.rejectsFile);
+        if (!rejectsFile.is_open()) {
+            cerr << "Could not open file for writing: " << options.rejectsFile << endl;
+            return 1;
+        }
+    }
+
+    PostingPipeline pipeline(forestTree);
+    PostingPipeline::Report report = pipeline.run(options.feedFile == "-" ? cin : feedFile,
+                                                  options.journalFile.empty() ? nullptr : &journalFile,
+                                                  options.rejectsFile.empty() ? &cerr : &rejectsFile);
+    cerr << PostingPipeline::formatReport(report);
+
+    try {
+        if (!options.outputFile.empty()) {
+            forestTree.printTree(options.outputFile);
+        }
+        if (!options.metricsFile.empty()) {
+            Metrics::writeJson(options.metricsFile);
+        }
+    } catch (const exception &e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return report.rejected == 0 ? 0 : 1;
+}
+
+// Compares an earlier chart (--diff) with --input; exits 0 if they match, 1 if they differ
+int runDiff(const Options &options) {
+    ForestTree before, after;
+    try {
+        loadChart(before, options.diffFile);
+        loadChart(after, options.inputFile.empty() ? "@base" : options.inputFile);
+    } catch (const exception &e) {
+        cerr << "Error loading accounts: " << e.what() << endl;
+        return 2;
+    }
+    LedgerDiff::Report report = LedgerDiff::compare(before, after);
+    cout << LedgerDiff::formatReport(report);
+    return LedgerDiff::isEmpty(report) ? 0 : 1;
+}
+
+// Serves the chart to local clients until SIGINT or SIGTERM; loads --input if given
+int runServer(const Options &options) {
+    LedgerServer::Config config;
+    config.workers = options.workers;
+    config.fileDirectory = options.filesDirectory;
+    const string &address = options.serveAddress;
+    try {
+        if (address.rfind("unix:", 0) == 0) {
+            config.unixPath = address.substr(5);
+        } else if (address.rfind("tcp:", 0) == 0) {
+            string endpoint = address.substr(4);
+            size_t colon = endpoint.rfind(':');
+            if (colon != string::npos) {
+                config.host = endpoint.substr(0, colon);
+                endpoint = endpoint.substr(colon + 1);
+            }
+            config.port = stoi(endpoint);
+        } else {
+            throw invalid_argument("--serve expects unix:<path> or tcp:[<host>:]<port>");
+        }
+        if (!options.publishPath.empty() && !options.followPath.empty()) {
+            throw invalid_argument("--publish and --follow cannot be combined");
+        }
+    } catch (const exception &e) {
+        cerr << "chart: " << e.what() << endl;
+        return 2;
+    }
+
+    ForestTree forestTree;
+    try {
+        if (!options.inputFile.empty()) {
+            loadChart(forestTree, options.inputFile);
+        }
+    } catch (const exception &e) {
+        cerr << "Error loading accounts: " << e.what() << endl;
+        return 1;
+    }
+
+    // Block the stop signals in every thread; the main thread waits for them below
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    // A primary logs the mutations its clients make; a replica applies its primary's log
+    unique_ptr<ReplicationLog> log;
+    if (!options.publishPath.empty() || !options.followPath.empty()) {
+        ReplicationLog::Role role = options.followPath.empty() ? ReplicationLog::PRIMARY : ReplicationLog::REPLICA;
+        log = make_unique<ReplicationLog>(role, forestTree.getTreeHash(), options.retain);
+        config.log = log.get();
+    }
+
+    LedgerServer server(forestTree, config);
+    unique_ptr<LogShipper> shipper;
+    unique_ptr<LogFollower> follower;
+    try {
+        server.start();
+        if (!options.publishPath.empty()) {
+            shipper = make_unique<LogShipper>(*log, LogShipper::Config{options.publishPath});
+            shipper->start();
+        }
+        if (!options.followPath.empty()) {
+            LogFollower::Config followConfig;
+            followConfig.primaryPath = options.followPath;
+            follower = make_unique<LogFollower>(forestTree, server.getTreeMutex(), *log, followConfig);
+            follower->start();
+        }
+    } catch (const exception &e) {
+        cerr << "Error starting server: " << e.what() << endl;
+        return 1;
+    }
+    if (config.unixPath.empty()) {
+        cerr << "chart: serving on " << config.host << ":" << server.getPort() << endl;
+    } else {
+        cerr << "chart: serving on " << config.unixPath << endl;
+    }
+    if (shipper) {
+        cerr << "chart: shipping the operation log on " << options.publishPath << endl;
+    }
+    if (follower) {
+        cerr << "chart: following the primary on " << options.followPath << endl;
+    }
+
+    int received;
+    sigwait(&signals, &received);
+    if (follower) follower->stop();
+    if (shipper) shipper->stop();
+    server.stop();
+    LedgerServer::Stats stats = server.getStats();
+    cerr << "chart: served " << stats.requests << " commands over " << stats.accepted << " connections" << endl;
+    if (log) {
+        ReplicationLog::Status status = log->getStatus();
+        cerr << "chart: replication log at position " << status.position;
+        if (shipper) cerr << ", " << shipper->getStats().entriesSent << " entries shipped";
+        if (!status.error.empty()) cerr << "; stopped following: " << status.error;
+        cerr << endl;
+    }
+
+    try {
+        if (!options.outputFile.empty()) {
+            forestTree.printTree(options.outputFile);
+        }
+        if (!options.metricsFile.empty()) {
+            Metrics::writeJson(options.metricsFile);
+        }
+    } catch (const exception &e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
 // Displays the main menu to the user
 void displayMenu() {
     cout << "\n======================================" << endl;
@@ -22,17 +354,49 @@ void displayMenu() {
     cout << "5. Search for an account by number" << endl;
     cout << "6. Print the chart of accounts (current state)" << endl;
     cout << "7. Exit and save changes to a new file" << endl;
+    cout << "8. Show an account balance at a date" << endl;
+    cout << "9. Search accounts by description" << endl;
     cout << "======================================" << endl;
 }
 
 // Main function: Entry point of the program
-int main() {
+int main(int argc, char **argv) {
+    Options options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const exception &e) {
+        cerr << "chart: " << e.what() << endl;
+        displayUsage();
+        return 2;
+    }
+    if (!options.serveAddress.empty()) {
+        return runServer(options);
+    }
+    if (!options.batchFile.empty()) {
+        return runBatch(options);
+    }
+    if (!options.feedFile.empty()) {
+        return runFeed(options);
+    }
+    if (!options.diffFile.empty()) {
+        return runDiff(options);
+    }
+
     ForestTree forestTree; // Create the ForestTree instance to manage accounts
     int choice; // Variable to store user menu selection
+    const string savedFile = options.outputFile.empty() ? UPDATED_FILE : options.outputFile;
 
-    // Load accounts data from the UPDATED_FILE if it exists, otherwise from ORIGINAL_FILE
+    // Load accounts data from --input, else from the UPDATED_FILE if it exists, otherwise from the base chart
     ifstream updatedFile(UPDATED_FILE);
-    if (updatedFile) {
+    if (!options.inputFile.empty()) {
+        try {
+            loadChart(forestTree, options.inputFile);
+            cout << "Accounts successfully loaded from " << options.inputFile << "." << endl;
+        } catch (const exception &e) {
+            cerr << "Error loading accounts: " << e.what() << endl;
+            return 1;
+        }
+    } else if (updatedFile) {
         try {
             forestTree.buildFromFile(UPDATED_FILE);
             cout << "Accounts successfully loaded from " << UPDATED_FILE << "." << endl;
@@ -42,8 +406,8 @@ int main() {
         }
     } else {
         try {
-            forestTree.buildFromFile(ORIGINAL_FILE);
-            cout << "Accounts successfully loaded from " << ORIGINAL_FILE << "." << endl;
+            forestTree.buildFromTable(BASE_CHART);
+            cout << "Accounts successfully loaded from the base chart." << endl;
         } catch (const exception &e) {
             cerr << "Error loading original accounts: " << e.what() << endl;
             return 1; // Exit if the original file cannot be loaded
@@ -58,7 +422,7 @@ int main() {
         while (!(cin >> choice)) {
             cin.clear();
             cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            cout << "Invalid input. Please enter a number (1-7): \n ";
+            cout << "Invalid input. Please enter a number (1-9): \n ";
             displayMenu();
         }
 
@@ -165,9 +529,15 @@ int main() {
                                 break;
                             }
 
+                            string dateInput;
+                            cout << "Enter posting date (YYYY-MM-DD, 0 if undated): ";
+                            cin >> dateInput;
+
                             try {
+                                int date = (dateInput == "0") ? 0 : Transaction::parseDate(dateInput);
+
                                 // Create a new transaction and automatically assign an ID
-                                forestTree.addTransaction(accountNumber, Transaction(amount, type));
+                                forestTree.addTransaction(accountNumber, Transaction(amount, type, date));
                                 cout << "Transaction added successfully." << endl;
                             } catch (const exception &e) {
                                 // Handle exceptions and display the error message
@@ -264,36 +634,75 @@ int main() {
                 break;
             }
 
-            case 6: { // Print the chart of accounts to a temporary file and display it
+            case 6: { // Print the chart of accounts to the console
                 try {
-                    string tempFile = "current_chart_of_accounts.txt";
-                    forestTree.printTree(tempFile);
-                    cout << "Current state of the chart of accounts saved to " << tempFile << "." << endl;
-
-                    ifstream file(tempFile);
-                    if (file) {
-                        cout << file.rdbuf(); // Display file contents to the console
-                        file.close();
-                    }
+                    forestTree.printTree(cout);
+                    cout.flush();
                 } catch (const exception &e) {
                     cout << "Error: " << e.what() << endl;
                 }
                 break;
             }
-            case 7: { // Save changes to UPDATED_FILE and exit
+            case 7: { // Save changes to the output file and exit
                 try {
-                    forestTree.printTree(UPDATED_FILE);
-                    cout << "All changes saved to " << UPDATED_FILE << ". Goodbye!" << endl;
+                    forestTree.printTree(savedFile);
+                    cout << "All changes saved to " << savedFile << ". Goodbye!" << endl;
                 } catch (const exception &e) {
                     cout << "Error: " << e.what() << endl;
                 }
                 break;
             }
+            case 8: { // Show an account balance at a date
+                int accountNumber;
+                string dateInput;
+                cout << "Enter account number: ";
+
+                if (cin >> accountNumber) {
+                    cout << "Enter date (YYYY-MM-DD): ";
+                    cin >> dateInput;
+                    try {
+                        int date = Transaction::parseDate(dateInput);
+                        double balance = forestTree.balanceAt(accountNumber, date);
+                        cout << "Balance of " << accountNumber << " at " << Transaction::formatDate(date) << ": "
+                             << fixed << setprecision(2) << balance << endl;
+                    } catch (const exception &e) {
+                        cout << "Error: " << e.what() << endl;
+                    }
+                } else {
+                    // Clear the error state and ignore invalid input
+                    cin.clear();
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    cout << "Error: Invalid input. Please enter a numeric account number." << endl;
+                }
+                break;
+            }
+            case 9: { // Search accounts by description words
+                string query;
+                cout << "Enter words to search for: ";
+                cin.ignore(); // Clear the newline character left in the buffer
+                getline(cin, query);
+
+                vector<Account *> matches = forestTree.searchByDescription(query);
+                if (matches.empty()) {
+                    cout << "No matching accounts found." << endl;
+                }
+                for (const Account *account : matches) {
+                    cout << account->getAccountNumber() << " " << account->getDescription() << endl;
+                }
+                break;
+            }
             default: // Invalid menu choice
                 cout << "Invalid choice. Please enter a valid option." << endl;
 
         }
     } while (choice != 7); // Exit when the user selects option 7
 
+    if (!options.metricsFile.empty()) {
+        try {
+            Metrics::writeJson(options.metricsFile);
+        } catch (const exception &e) {
+            cerr << "Error: " << e.what() << endl;
+        }
+    }
     return 0;
 }
@@ -0,0 +1,130 @@
+/**-- ChartCompiler.cpp ------------------------------------------------------
+  Build-time compiler of a chart of accounts into a static ChartTable (see
+  ChartTable.h). The chart file is loaded with ForestTree::buildFromFile, so
+  the table holds exactly the accounts, parents, descriptions and balances a
+  run-time load would produce, and is written as a C++ source file:
+
+      const char DESCRIPTIONS[] = "...";         every description
+      const ChartTableEntry ENTRIES[] = {...};   ordered by account number
+      const ChartTable <symbol> = {ENTRIES, <count>, DESCRIPTIONS};
+
+  A chart is reference data: a file that holds postings is rejected.
+
+  Usage:
+    chart_compile <chart file> <output .cpp> [<symbol>]   (default symbol: BASE_CHART)
+--------------------------------------------------------------------------**/
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "ForestTree.h"
+
+using namespace std;
+
+namespace {
+
+    // Appends text as the body of a C++ string literal
+    void appendLiteral(string &out, string_view text) {
+        for (char c: text) {
+            unsigned char u = static_cast<unsigned char>(c);
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (u < 0x20 || u >= 0x7F) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\%03o", u);   // Octal escapes end after 3 digits
+                out += escaped;
+            } else {
+                out += c;
+            }
+        }
+    }
+
+    // Writes the table source for every account of a tree
+    string compileTable(const ForestTree &tree, const string &chartFile, const string &symbol) {
+        const map<int, Account *> &accounts = tree.getAccountMap();
+        map<const Account *, int> indexOf;
+        int index = 0;
+        for (const auto &pair: accounts) {
+            indexOf[pair.second] = index++;
+        }
+
+        string descriptions, entries;
+        size_t offset = 0, column = 0;
+        bool open = false;
+        char line[160];
+        for (const auto &pair: accounts) {
+            const Account *account = pair.second;
+            if (!account->getTransactions().empty()) {
+                throw runtime_error("Account " + to_string(pair.first) + " has postings; a chart table holds "
+                                                                         "accounts only");
+            }
+            string_view description = account->getDescription();
+            int parent = account->getParent() ? indexOf.at(account->getParent()) : -1;
+            snprintf(line, sizeof(line), "        {%d, %d, %zu, %zu, %.17g},\n", pair.first, parent, offset,
+                     description.size(), account->getBalance());
+            entries += line;
+
+            // One literal piece per line keeps the generated file readable
+            if (!open) {
+                descriptions += "        \"";
+                open = true;
+            }
+            appendLiteral(descriptions, description);
+            offset += description.size();
+            column += description.size();
+            if (column >= 72) {
+                descriptions += "\"\n";
+                open = false;
+                column = 0;
+            }
+        }
+        if (open) descriptions += "\"\n";
+
+        ostringstream out;
+        out << "// Generated by chart_compile from " << filesystem::path(chartFile).filename().string()
+            << ". Do not edit.\n"
+            << "#include \"ChartTable.h\"\n\n"
+            << "namespace {\n\n"
+            << "    const char DESCRIPTIONS[] =\n" << descriptions << "    ;\n\n"
+            << "    const ChartTableEntry ENTRIES[] = {\n" << entries << "    };\n"
+            << "}\n\n"
+            << "extern const ChartTable " << symbol << ";\n"
+            << "const ChartTable " << symbol << " = {ENTRIES, " << accounts.size() << ", DESCRIPTIONS};\n";
+        return out.str();
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3 || argc > 4) {
+        cerr << "Usage: chart_compile <chart file> <output .cpp> [<symbol>]" << endl;
+        return 2;
+    }
+    string chartFile = argv[1], outputFile = argv[2];
+    string symbol = (argc == 4) ? argv[3] : "BASE_CHART";
+
+    try {
+        ForestTree tree;
+        tree.buildFromFile(chartFile);
+        if (tree.getAccountMap().empty()) {
+            throw runtime_error("No accounts in " + chartFile);
+        }
+        string source = compileTable(tree, chartFile, symbol);
+
+        ofstream out(outputFile, ios::binary | ios::trunc);
+        out << source;
+        if (!out) {
+            throw runtime_error("Could not write " + outputFile);
+        }
+        cout << "chart_compile: " << tree.getAccountMap().size() << " accounts -> " << outputFile << endl;
+    } catch (const exception &e) {
+        cerr << "chart_compile: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,448 @@
+/**-- LedgerGenerator.cpp ---------------------------------------------------
+  Deterministic generator of large synthetic ledgers for scale testing.
+
+  The base chart (accountswithspace.txt by default) is expanded with
+  analytic sub-accounts, then postings are spread over the leaf accounts and
+  the result is written in exactly the layout that ForestTree::printTree
+  writes and ForestTree::buildFromFile reads:
+
+      <indent><number> <description padded to 30> <balance>
+      <indent+2>Transaction ID: <id>, Amount: <amount>, Type: Debit|Credit[, Date: YYYY-MM-DD]
+      <blank line after an account's transactions>
+
+  The same seed and options always produce the same file. Postings are
+  generated account by account while the file is streamed, so memory stays
+  proportional to the chart, not to the number of postings.
+
+  Balances: like printTree, an account shows its subtree balance, the
+  signed sum of its own postings and of every account below it. A first
+  pass replays the random stream to sum them before the file is written.
+  Credits never exceed the running balance of their account, so every
+  posting passes Transaction::isValid.
+
+  Usage:
+    ledger_gen [options]
+      --chart <file>          Base chart (default: accountswithspace.txt)
+      --output <file>|-       Output file, or - for stdout (default: -)
+      --seed <n>              Random seed (default: 1)
+      --postings <n>          Number of postings (default: 1000000)
+      --sub-accounts <n>      Analytic sub-accounts to add (default: 0)
+      --depth-weights a,b,c   Relative weights of new sub-accounts with 3, 4
+                              and 5 digits (default: 1,2,4)
+      --skew <s>              Zipf exponent of postings over leaf accounts;
+                              0 is uniform (default: 1.0)
+      --credit-ratio <r>      Share of postings attempted as credits (default: 0.3)
+      --min-amount <x>        Smallest posting amount (default: 1.00)
+      --max-amount <x>        Largest posting amount (default: 100000.00)
+      --from <YYYY-MM-DD>     First posting date (default: undated postings)
+      --to <YYYY-MM-DD>       Last posting date (default: --from)
+--------------------------------------------------------------------------**/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "ForestTree.h"
+
+using namespace std;
+
+namespace {
+
+    struct Options {
+        string chartFile = "accountswithspace.txt";
+        string outputFile = "-";
+        unsigned long long seed = 1;
+        long long postings = 1000000;
+        int subAccounts = 0;
+        double depthWeights[3] = {1.0, 2.0, 4.0};
+        double skew = 1.0;
+        double creditRatio = 0.3;
+        long long minCents = 100;
+        long long maxCents = 10000000;
+        int fromDate = 0;
+        int toDate = 0;
+    };
+
+    struct Node {
+        int number;                 // Account number
+        string description;         // Account description
+        int parent;                 // Index of the parent node (-1 for roots)
+        vector<int> children;       // Indices of child nodes, ascending by number
+        long long postings;         // Number of postings to generate
+        long long balance = 0;      // Subtree balance in cents
+    };
+
+    // Buffered writer that formats numbers without iostreams
+    class Output {
+    private:
+        FILE *file;
+        vector<char> buffer;
+        size_t used;
+        unsigned long long written;
+
+    public:
+        explicit Output(FILE *file) : file(file), buffer(1 << 20), used(0), written(0) {}
+
+        ~Output() { flush(); }
+
+        void flush() {
+            if (used > 0 && fwrite(buffer.data(), 1, used, file) != used) {
+                throw runtime_error("Write failed");
+            }
+            written += used;
+            used = 0;
+        }
+
+        unsigned long long bytesWritten() const { return written + used; }
+
+        void put(const char *text, size_t length) {
+            if (used + length > buffer.size()) {
+                flush();
+                if (length > buffer.size()) {
+                    buffer.resize(length);
+                }
+            }
+            memcpy(buffer.data() + used, text, length);
+            used += length;
+        }
+
+        void put(const string &text) { put(text.data(), text.size()); }
+
+        void put(char c) { put(&c, 1); }
+
+        void spaces(size_t count) {
+            for (size_t i = 0; i < count; ++i) put(' ');
+        }
+
+        void integer(long long value) {
+            char digits[24];
+            int n = snprintf(digits, sizeof(digits), "%lld", value);
+            put(digits, static_cast<size_t>(n));
+        }
+
+        // Writes an amount held in cents with two decimals
+        void cents(long long value) {
+            if (value < 0) {
+                put('-');
+                value = -value;
+            }
+            integer(value / 100);
+            char fraction[3] = {'.', static_cast<char>('0' + (value % 100) / 10), static_cast<char>('0' + value % 10)};
+            put(fraction, 3);
+        }
+    };
+
+    // Converts between YYYYMMDD dates and day numbers (days since 1970-01-01)
+    long long dayNumber(int date) {
+        int y = date / 10000, m = (date / 100) % 100, d = date % 100;
+        y -= m <= 2;
+        long long era = (y >= 0 ? y : y - 399) / 400;
+        long long yoe = y - era * 400;
+        long long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468;
+    }
+
+    int dateFromDay(long long z) {
+        z += 719468;
+        long long era = (z >= 0 ? z : z - 146096) / 146097;
+        long long doe = z - era * 146097;
+        long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        long long y = yoe + era * 400;
+        long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        long long mp = (5 * doy + 2) / 153;
+        long long d = doy - (153 * mp + 2) / 5 + 1;
+        long long m = mp + (mp < 10 ? 3 : -9);
+        return static_cast<int>((y + (m <= 2)) * 10000 + m * 100 + d);
+    }
+
+    int digitCount(int number) {
+        int digits = 1;
+        while (number >= 10) {
+            number /= 10;
+            ++digits;
+        }
+        return digits;
+    }
+
+    Options parseOptions(int argc, char **argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            string flag = argv[i];
+            if (i + 1 >= argc) {
+                throw invalid_argument("Missing value for " + flag);
+            }
+            string value = argv[++i];
+            if (flag == "--chart") options.chartFile = value;
+            else if (flag == "--output") options.outputFile = value;
+            else if (flag == "--seed") options.seed = stoull(value);
+            else if (flag == "--postings") options.postings = stoll(value);
+            else if (flag == "--sub-accounts") options.subAccounts = stoi(value);
+            else if (flag == "--skew") options.skew = stod(value);
+            else if (flag == "--credit-ratio") options.creditRatio = stod(value);
+            else if (flag == "--min-amount") options.minCents = llround(stod(value) * 100);
+            else if (flag == "--max-amount") options.maxCents = llround(stod(value) * 100);
+            else if (flag == "--from") options.fromDate = Transaction::parseDate(value);
+            else if (flag == "--to") options.toDate = Transaction::parseDate(value);
+            else if (flag == "--depth-weights") {
+                if (sscanf(value.c_str(), "%lf,%lf,%lf", &options.depthWeights[0], &options.depthWeights[1],
+                           &options.depthWeights[2]) != 3) {
+                    throw invalid_argument("--depth-weights expects three comma-separated numbers");
+                }
+            } else {
+                throw invalid_argument("Unknown option: " + flag);
+            }
+        }
+        if (options.postings < 0 || options.subAccounts < 0 || options.minCents < 1 ||
+            options.maxCents < options.minCents) {
+            throw invalid_argument("Counts must be non-negative and 0 < min-amount <= max-amount");
+        }
+        if (options.toDate == 0) options.toDate = options.fromDate;
+        if (options.fromDate == 0 && options.toDate != 0) {
+            throw invalid_argument("--to requires --from");
+        }
+        if (options.toDate < options.fromDate) {
+            throw invalid_argument("--to must not be earlier than --from");
+        }
+        return options;
+    }
+
+    // Loads the base chart into nodes indexed by position, with a number lookup table
+    vector<Node> loadChart(const string &chartFile, vector<int> &indexOf) {
+        ForestTree chart;
+        chart.buildFromFile(chartFile);
+
+        vector<Node> nodes;
+        indexOf.assign(100000, -1);
+        for (const auto &pair: chart.getAccountMap()) {
+            indexOf[pair.first] = static_cast<int>(nodes.size());
+            nodes.push_back(Node{pair.first, string(pair.second->getDescription()), -1, {}, 0});
+        }
+        for (Node &node: nodes) {
+            int parentIndex = indexOf[node.number / 10];
+            if (node.number >= 10 && parentIndex >= 0) {
+                node.parent = parentIndex;
+            }
+        }
+        return nodes;
+    }
+
+    // Adds analytic sub-accounts under randomly chosen parents
+    void addSubAccounts(vector<Node> &nodes, vector<int> &indexOf, const Options &options, mt19937_64 &rng) {
+        // Candidate parents by the digit count of the children they would get (3, 4, 5)
+        vector<int> parents[3];
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            int digits = digitCount(nodes[i].number) + 1;
+            if (digits >= 3 && digits <= 5) parents[digits - 3].push_back(static_cast<int>(i));
+        }
+
+        for (int added = 0; added < options.subAccounts;) {
+            double weights[3];
+            for (int d = 0; d < 3; ++d) {
+                weights[d] = parents[d].empty() ? 0.0 : options.depthWeights[d];
+            }
+            if (weights[0] + weights[1] + weights[2] <= 0.0) {
+                cerr << "ledger_gen: account space exhausted after " << added << " sub-accounts" << endl;
+                return;
+            }
+            int depth = discrete_distribution<int>(weights, weights + 3)(rng);
+
+            // Pick a parent and a free child digit; drop parents that are full
+            vector<int> &pool = parents[depth];
+            size_t pick = rng() % pool.size();
+            int parentIndex = pool[pick];
+            int base = nodes[parentIndex].number * 10;
+            int start = static_cast<int>(rng() % 10), digit = -1;
+            for (int k = 0; k < 10; ++k) {
+                if (indexOf[base + (start + k) % 10] < 0) {
+                    digit = (start + k) % 10;
+                    break;
+                }
+            }
+            if (digit < 0) {
+                pool[pick] = pool.back();
+                pool.pop_back();
+                continue;
+            }
+
+            int number = base + digit;
+            indexOf[number] = static_cast<int>(nodes.size());
+            nodes.push_back(Node{number, nodes[parentIndex].description + " - analytic " + to_string(digit),
+                                 parentIndex, {}, 0});
+            if (depth < 2) {
+                parents[depth + 1].push_back(indexOf[number]);
+            }
+            ++added;
+        }
+    }
+
+    // Spreads the postings over leaf accounts with a Zipf distribution of the given skew
+    void assignPostings(vector<Node> &nodes, const Options &options, mt19937_64 &rng) {
+        vector<int> leaves;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i].children.empty()) leaves.push_back(static_cast<int>(i));
+        }
+        if (leaves.empty() || options.postings == 0) {
+            return;
+        }
+
+        // Rank leaves randomly so popularity does not follow account numbers
+        shuffle(leaves.begin(), leaves.end(), rng);
+        vector<double> cumulative(leaves.size());
+        double total = 0.0;
+        for (size_t rank = 0; rank < leaves.size(); ++rank) {
+            total += 1.0 / pow(static_cast<double>(rank + 1), options.skew);
+            cumulative[rank] = total;
+        }
+
+        uniform_real_distribution<double> unit(0.0, total);
+        for (long long i = 0; i < options.postings; ++i) {
+            size_t rank = static_cast<size_t>(lower_bound(cumulative.begin(), cumulative.end(), unit(rng)) -
+                                              cumulative.begin());
+            ++nodes[leaves[min(rank, leaves.size() - 1)]].postings;
+        }
+    }
+
+    struct Posting {
+        long long cents;
+        bool credit;
+        int date;
+    };
+
+    // Generates an account's postings and returns the balance they leave
+    long long generatePostings(const Node &node, const Options &options, mt19937_64 &rng, vector<Posting> &postings) {
+        // Amounts are log-uniform between the bounds, like real ledgers
+        postings.clear();
+        long long balance = 0;
+        double logMin = log(static_cast<double>(options.minCents));
+        double logMax = log(static_cast<double>(options.maxCents));
+        uniform_real_distribution<double> logAmount(logMin, logMax);
+        uniform_real_distribution<double> unit(0.0, 1.0);
+        long long firstDay = options.fromDate ? dayNumber(options.fromDate) : 0;
+        long long daySpan = options.fromDate ? dayNumber(options.toDate) - firstDay + 1 : 0;
+        for (long long i = 0; i < node.postings; ++i) {
+            long long cents = min(options.maxCents, max(options.minCents, llround(exp(logAmount(rng)))));
+            bool credit = unit(rng) < options.creditRatio && balance >= cents;
+            int date = options.fromDate ? dateFromDay(firstDay + static_cast<long long>(rng() % daySpan)) : 0;
+            balance += credit ? -cents : cents;
+            postings.push_back(Posting{cents, credit, date});
+        }
+        return balance;
+    }
+
+    // Sums the subtree balance of an account and its children, drawing from rng as writeAccount will
+    long long sumBalances(vector<Node> &nodes, int index, const Options &options, mt19937_64 &rng,
+                          vector<Posting> &postings) {
+        long long balance = generatePostings(nodes[index], options, rng, postings);
+        for (int child: nodes[index].children) {
+            balance += sumBalances(nodes, child, options, rng, postings);
+        }
+        nodes[index].balance = balance;
+        return balance;
+    }
+
+    // Writes one account and its postings, then its children, depth first
+    void writeAccount(Output &out, const vector<Node> &nodes, int index, int indent, const Options &options,
+                      mt19937_64 &rng, vector<Posting> &postings) {
+        const Node &node = nodes[index];
+        generatePostings(node, options, rng, postings);
+
+        out.spaces(static_cast<size_t>(indent) * 2);
+        out.integer(node.number);
+        out.put(' ');
+        out.put(node.description);
+        if (node.description.size() < 30) out.spaces(30 - node.description.size());
+        out.put(' ');
+        out.cents(node.balance);
+        out.put('\n');
+
+        for (size_t i = 0; i < postings.size(); ++i) {
+            out.spaces(static_cast<size_t>(indent + 1) * 2);
+            out.put("Transaction ID: ", 16);
+            out.integer(static_cast<long long>(i) + 1);
+            out.put(", Amount: ", 10);
+            out.cents(postings[i].cents);
+            if (postings[i].credit) out.put(", Type: Credit", 14);
+            else out.put(", Type: Debit", 13);
+            if (postings[i].date != 0) {
+                out.put(", Date: ", 8);
+                out.put(Transaction::formatDate(postings[i].date));
+            }
+            out.put('\n');
+        }
+        if (!postings.empty()) {
+            out.put('\n');
+        }
+
+        for (int child: node.children) {
+            writeAccount(out, nodes, child, indent + 1, options, rng, postings);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    try {
+        Options options = parseOptions(argc, argv);
+        auto started = chrono::steady_clock::now();
+        mt19937_64 rng(options.seed);
+
+        vector<int> indexOf;
+        vector<Node> nodes = loadChart(options.chartFile, indexOf);
+        addSubAccounts(nodes, indexOf, options, rng);
+
+        // Link children in ascending account order, as printTree visits them
+        vector<int> order(nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i) order[i] = static_cast<int>(i);
+        sort(order.begin(), order.end(), [&nodes](int a, int b) { return nodes[a].number < nodes[b].number; });
+        for (int index: order) {
+            if (nodes[index].parent >= 0) nodes[nodes[index].parent].children.push_back(index);
+        }
+
+        assignPostings(nodes, options, rng);
+
+        // A copy of the generator yields the postings writeAccount draws next
+        {
+            mt19937_64 preview = rng;
+            vector<Posting> postings;
+            for (int index: order) {
+                if (nodes[index].parent < 0) {
+                    sumBalances(nodes, index, options, preview, postings);
+                }
+            }
+        }
+
+        FILE *file = (options.outputFile == "-") ? stdout : fopen(options.outputFile.c_str(), "wb");
+        if (!file) {
+            throw runtime_error("Could not open file for writing: " + options.outputFile);
+        }
+        unsigned long long bytes;
+        {
+            Output out(file);
+            vector<Posting> postings;
+            for (int index: order) {
+                if (nodes[index].parent < 0) {
+                    writeAccount(out, nodes, index, 0, options, rng, postings);
+                }
+            }
+            out.flush();
+            bytes = out.bytesWritten();
+        }
+        if (file != stdout && fclose(file) != 0) {
+            throw runtime_error("Could not close file: " + options.outputFile);
+        }
+
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        cerr << "ledger_gen: " << nodes.size() << " accounts, " << options.postings << " postings, " << bytes
+             << " bytes in " << seconds << " s (" << (bytes / 1048576.0) / seconds << " MiB/s)" << endl;
+    } catch (const exception &e) {
+        cerr << "ledger_gen: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
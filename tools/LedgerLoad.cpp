@@ -0,0 +1,238 @@
+/**-- LedgerLoad.cpp --------------------------------------------------------
+  Load generator for the ledger server (chart --serve). Opens many client
+  connections from one epoll thread, keeps a fixed number of pipelined
+  commands outstanding on each, and reports throughput and round-trip
+  latency percentiles.
+
+  Each command is a query, or with probability --write-ratio a 1.00 debit,
+  on an account drawn uniformly from --accounts.
+
+  Usage:
+    ledger_load [options]
+      --connect unix:<path>|tcp:[<host>:]<port>   Server address (required)
+      --clients <n>           Concurrent connections (default: 100)
+      --depth <n>             Pipelined commands per connection (default: 8)
+      --requests <n>          Commands in total (default: 200000)
+      --write-ratio <r>       Share of post commands (default: 0.1)
+      --accounts a,b,...      Accounts to use (default: 1,10,101,1011)
+      --seed <n>              Random seed (default: 1)
+--------------------------------------------------------------------------**/
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+    using Clock = chrono::steady_clock;
+
+    struct Options {
+        string address;
+        size_t clients = 100;
+        size_t depth = 8;
+        long long requests = 200000;
+        double writeRatio = 0.1;
+        vector<int> accounts = {1, 10, 101, 1011};
+        unsigned long long seed = 1;
+    };
+
+    struct Client {
+        int fd = -1;
+        deque<Clock::time_point> sentAt;    // Send time of each outstanding command
+        string output;                      // Commands not yet written
+        string input;                       // Partial reply line
+    };
+
+    Options parseOptions(int argc, char **argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            string flag = argv[i];
+            if (i + 1 >= argc) {
+                throw invalid_argument("Missing value for " + flag);
+            }
+            string value = argv[++i];
+            if (flag == "--connect") options.address = value;
+            else if (flag == "--clients") options.clients = stoul(value);
+            else if (flag == "--depth") options.depth = stoul(value);
+            else if (flag == "--requests") options.requests = stoll(value);
+            else if (flag == "--write-ratio") options.writeRatio = stod(value);
+            else if (flag == "--seed") options.seed = stoull(value);
+            else if (flag == "--accounts") {
+                options.accounts.clear();
+                stringstream list(value);
+                string item;
+                while (getline(list, item, ',')) options.accounts.push_back(stoi(item));
+            } else {
+                throw invalid_argument("Unknown option: " + flag);
+            }
+        }
+        if (options.address.empty() || options.clients == 0 || options.depth == 0 || options.accounts.empty()) {
+            throw invalid_argument("--connect, --clients, --depth and --accounts need values");
+        }
+        return options;
+    }
+
+    // Opens a blocking connection, then switches it to non-blocking
+    int connectTo(const string &address) {
+        int fd;
+        if (address.rfind("unix:", 0) == 0) {
+            sockaddr_un target{};
+            target.sun_family = AF_UNIX;
+            strncpy(target.sun_path, address.c_str() + 5, sizeof(target.sun_path) - 1);
+            fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&target), sizeof(target)) < 0) {
+                throw runtime_error("connect " + address + ": " + strerror(errno));
+            }
+        } else if (address.rfind("tcp:", 0) == 0) {
+            string endpoint = address.substr(4), host = "127.0.0.1";
+            size_t colon = endpoint.rfind(':');
+            if (colon != string::npos) {
+                host = endpoint.substr(0, colon);
+                endpoint = endpoint.substr(colon + 1);
+            }
+            sockaddr_in target{};
+            target.sin_family = AF_INET;
+            target.sin_port = htons(static_cast<uint16_t>(stoi(endpoint)));
+            if (inet_pton(AF_INET, host.c_str(), &target.sin_addr) != 1) {
+                throw invalid_argument("Invalid address: " + host);
+            }
+            fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&target), sizeof(target)) < 0) {
+                throw runtime_error("connect " + address + ": " + strerror(errno));
+            }
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        } else {
+            throw invalid_argument("--connect expects unix:<path> or tcp:[<host>:]<port>");
+        }
+        if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0) {
+            throw runtime_error(string("fcntl: ") + strerror(errno));
+        }
+        return fd;
+    }
+
+    // Queues the next command of a client
+    void queueCommand(Client &client, const Options &options, mt19937_64 &rng) {
+        int account = options.accounts[rng() % options.accounts.size()];
+        bool write = uniform_real_distribution<double>(0.0, 1.0)(rng) < options.writeRatio;
+        client.output += write ? "post " + to_string(account) + " 1.00 D\n" : "query " + to_string(account) + "\n";
+        client.sentAt.push_back(Clock::now());
+    }
+
+    // Writes as much of a client's queued commands as the socket takes
+    void flush(Client &client) {
+        while (!client.output.empty()) {
+            ssize_t sent = send(client.fd, client.output.data(), client.output.size(), MSG_NOSIGNAL);
+            if (sent > 0) {
+                client.output.erase(0, static_cast<size_t>(sent));
+            } else if (sent < 0 && errno == EINTR) {
+                continue;
+            } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return;
+            } else {
+                throw runtime_error(string("send: ") + strerror(errno));
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    try {
+        Options options = parseOptions(argc, argv);
+        mt19937_64 rng(options.seed);
+
+        int epollFd = epoll_create1(EPOLL_CLOEXEC);
+        vector<Client> clients(options.clients);
+        for (size_t i = 0; i < clients.size(); ++i) {
+            clients[i].fd = connectTo(options.address);
+            epoll_event event{};
+            event.events = EPOLLIN; // Unsent commands are retried whenever a reply arrives
+            event.data.u64 = i;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, clients[i].fd, &event);
+        }
+
+        auto started = Clock::now();
+        long long issued = 0, completed = 0, failed = 0;
+        vector<double> latencies;
+        latencies.reserve(static_cast<size_t>(options.requests));
+
+        // Fill every pipeline
+        for (Client &client: clients) {
+            for (size_t d = 0; d < options.depth && issued < options.requests; ++d, ++issued) {
+                queueCommand(client, options, rng);
+            }
+            flush(client);
+        }
+
+        vector<epoll_event> events(256);
+        char buffer[64 * 1024];
+        while (completed < issued) {
+            int ready = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), 10000);
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready <= 0) throw runtime_error("Timed out waiting for replies");
+
+            for (int e = 0; e < ready; ++e) {
+                Client &client = clients[events[e].data.u64];
+                ssize_t received = recv(client.fd, buffer, sizeof(buffer), 0);
+                if (received == 0) throw runtime_error("Server closed a connection");
+                if (received < 0) {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+                    throw runtime_error(string("recv: ") + strerror(errno));
+                }
+                client.input.append(buffer, static_cast<size_t>(received));
+
+                // Every complete reply line retires the oldest outstanding command
+                size_t start = 0, newline;
+                auto now = Clock::now();
+                while ((newline = client.input.find('\n', start)) != string::npos) {
+                    if (client.input.find("\"ok\":false", start) < newline) ++failed;
+                    latencies.push_back(chrono::duration<double, micro>(now - client.sentAt.front()).count());
+                    client.sentAt.pop_front();
+                    ++completed;
+                    start = newline + 1;
+                    if (issued < options.requests) {
+                        queueCommand(client, options, rng);
+                        ++issued;
+                    }
+                }
+                client.input.erase(0, start);
+                flush(client);
+            }
+        }
+
+        double seconds = chrono::duration<double>(Clock::now() - started).count();
+        sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double q) {
+            return latencies.empty() ? 0.0 : latencies[min(latencies.size() - 1, static_cast<size_t>(q * latencies.size()))];
+        };
+        cout << "clients=" << options.clients << " depth=" << options.depth << " requests=" << completed
+             << " failed=" << failed << " seconds=" << seconds << " requests_per_second=" << completed / seconds
+             << " p50_us=" << percentile(0.5) << " p90_us=" << percentile(0.9) << " p99_us=" << percentile(0.99)
+             << " max_us=" << (latencies.empty() ? 0.0 : latencies.back()) << endl;
+
+        for (Client &client: clients) close(client.fd);
+        close(epollFd);
+    } catch (const exception &e) {
+        cerr << "ledger_load: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}